@@ -42,6 +42,9 @@ trusty_app_manifest_t TRUSTY_APP_MANIFEST_ATTRS trusty_app_manifest =
         /* enable/disable auto start */
         TRUSTY_APP_CONFIG_AUTO_START(0),
 
+        /* instances started ahead of the sessions that use them */
+        TRUSTY_APP_CONFIG_INSTANCE_POOL(2),
+
         /* custom external config options */
         TRUSTY_APP_CONFIG_EXTERN((uint32_t)&tee_api_properties, (uint32_t)&ta_props_len),
     },
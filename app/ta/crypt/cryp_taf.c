@@ -26,6 +26,7 @@
  */
 
 #include <tee_internal_api.h>
+#include <tee_internal_api_extensions.h>
 #include "cryp_taf.h"
 
 #define ASSERT_PARAM_TYPE(pt)                    \
@@ -699,3 +700,262 @@ TEE_Result ta_entry_get_object_value_attribute(uint32_t param_type,
     return TEE_GetObjectValueAttribute(o, params[0].value.b,
                                        &params[1].value.a, &params[1].value.b);
 }
+
+#define MAC_BENCH_DEFAULT_COUNT 10000
+#define MAC_BENCH_MSG_LEN       64
+#define MAC_BENCH_BATCH         64
+
+static uint32_t elapsed_ms(const TEE_Time *start)
+{
+    TEE_Time now;
+
+    TEE_GetSystemTime(&now);
+    return (now.seconds - start->seconds) * 1000 +
+           now.millis - start->millis;
+}
+
+TEE_Result ta_entry_mac_batch_bench(uint32_t param_type, TEE_Param params[4])
+{
+    TEE_Result res;
+    TEE_OperationHandle op = TEE_HANDLE_NULL;
+    TEE_ObjectHandle key = TEE_HANDLE_NULL;
+    TEE_DigestBatchEntry entries[MAC_BENCH_BATCH];
+    uint8_t *msgs = NULL;
+    uint8_t *ref = NULL;
+    uint8_t *out = NULL;
+    uint32_t count;
+    uint32_t i, j, n;
+    size_t len;
+    TEE_Time start;
+
+    ASSERT_PARAM_TYPE(TEE_PARAM_TYPES
+                      (TEE_PARAM_TYPE_VALUE_INPUT,
+                       TEE_PARAM_TYPE_VALUE_OUTPUT, TEE_PARAM_TYPE_NONE,
+                       TEE_PARAM_TYPE_NONE));
+
+    count = params[0].value.a ? params[0].value.a : MAC_BENCH_DEFAULT_COUNT;
+
+    msgs = TEE_Malloc(MAC_BENCH_BATCH * MAC_BENCH_MSG_LEN, 0);
+    ref = TEE_Malloc(MAC_BENCH_BATCH * TEE_SHA256_HASH_SIZE, 0);
+    out = TEE_Malloc(MAC_BENCH_BATCH * TEE_SHA256_HASH_SIZE, 0);
+    if (!msgs || !ref || !out) {
+        res = TEE_ERROR_OUT_OF_MEMORY;
+        goto out;
+    }
+    TEE_GenerateRandom(msgs, MAC_BENCH_BATCH * MAC_BENCH_MSG_LEN);
+
+    res = TEE_AllocateOperation(&op, TEE_ALG_HMAC_SHA256, TEE_MODE_MAC, 256);
+    if (res != TEE_SUCCESS)
+        goto out;
+    res = TEE_AllocateTransientObject(TEE_TYPE_HMAC_SHA256, 256, &key);
+    if (res != TEE_SUCCESS)
+        goto out;
+    res = TEE_GenerateKey(key, 256, NULL, 0);
+    if (res != TEE_SUCCESS)
+        goto out;
+    res = TEE_SetOperationKey(op, key);
+    if (res != TEE_SUCCESS)
+        goto out;
+
+    /* one message per init/final pair */
+    TEE_GetSystemTime(&start);
+    for (i = 0; i < count; i++) {
+        n = i % MAC_BENCH_BATCH;
+        len = TEE_SHA256_HASH_SIZE;
+        TEE_MACInit(op, NULL, 0);
+        res = TEE_MACComputeFinal(op, msgs + n * MAC_BENCH_MSG_LEN,
+                                  MAC_BENCH_MSG_LEN,
+                                  ref + n * TEE_SHA256_HASH_SIZE, &len);
+        if (res != TEE_SUCCESS)
+            goto out;
+    }
+    params[1].value.a = elapsed_ms(&start);
+
+    /* the same messages, MAC_BENCH_BATCH per call */
+    TEE_GetSystemTime(&start);
+    TEE_MACInit(op, NULL, 0);
+    for (i = 0; i < count; i += n) {
+        n = count - i < MAC_BENCH_BATCH ? count - i : MAC_BENCH_BATCH;
+        for (j = 0; j < n; j++) {
+            entries[j].data = msgs + j * MAC_BENCH_MSG_LEN;
+            entries[j].dataLen = MAC_BENCH_MSG_LEN;
+            entries[j].hash = out + j * TEE_SHA256_HASH_SIZE;
+            entries[j].hashLen = TEE_SHA256_HASH_SIZE;
+        }
+        res = TEE_DigestBatch(op, entries, n);
+        if (res != TEE_SUCCESS)
+            goto out;
+    }
+    params[1].value.b = elapsed_ms(&start);
+
+    n = count < MAC_BENCH_BATCH ? count : MAC_BENCH_BATCH;
+    if (TEE_MemCompare(ref, out, n * TEE_SHA256_HASH_SIZE)) {
+        EMSG("batched HMAC-SHA256 differs from single");
+        res = TEE_ERROR_GENERIC;
+        goto out;
+    }
+
+    IMSG("%u HMAC-SHA256 of %d bytes: %u ms single, %u ms batched",
+         count, MAC_BENCH_MSG_LEN, params[1].value.a, params[1].value.b);
+
+out:
+    if (op != TEE_HANDLE_NULL)
+        TEE_FreeOperation(op);
+    TEE_FreeTransientObject(key);
+    TEE_Free(msgs);
+    TEE_Free(ref);
+    TEE_Free(out);
+    return res;
+}
+
+#define HANDLE_BENCH_DEFAULT_LIVE 1000
+#define HANDLE_BENCH_CALLS        10000
+
+TEE_Result ta_entry_handle_bench(uint32_t param_type, TEE_Param params[4])
+{
+    TEE_Result res = TEE_SUCCESS;
+    TEE_ObjectHandle *objs = NULL;
+    TEE_OperationHandle *ops = NULL;
+    TEE_ObjectInfo info;
+    uint8_t chunk[16] = { 0 };
+    uint32_t live;
+    uint32_t i;
+    TEE_Time start;
+
+    ASSERT_PARAM_TYPE(TEE_PARAM_TYPES
+                      (TEE_PARAM_TYPE_VALUE_INPUT,
+                       TEE_PARAM_TYPE_VALUE_OUTPUT, TEE_PARAM_TYPE_NONE,
+                       TEE_PARAM_TYPE_NONE));
+
+    live = params[0].value.a ? params[0].value.a : HANDLE_BENCH_DEFAULT_LIVE;
+
+    objs = TEE_Malloc(live * sizeof(*objs), 0);
+    ops = TEE_Malloc(live * sizeof(*ops), 0);
+    if (!objs || !ops) {
+        res = TEE_ERROR_OUT_OF_MEMORY;
+        goto out;
+    }
+
+    for (i = 0; i < live; i++) {
+        res = TEE_AllocateTransientObject(TEE_TYPE_AES, 128, &objs[i]);
+        if (res != TEE_SUCCESS)
+            goto out;
+        res = TEE_AllocateOperation(&ops[i], TEE_ALG_SHA256, TEE_MODE_DIGEST,
+                                    0);
+        if (res != TEE_SUCCESS)
+            goto out;
+    }
+
+    /* the newest handles, the last ones a linear search would reach */
+    TEE_GetSystemTime(&start);
+    for (i = 0; i < HANDLE_BENCH_CALLS; i++)
+        TEE_DigestUpdate(ops[live - 1], chunk, sizeof(chunk));
+    params[1].value.a = elapsed_ms(&start);
+
+    TEE_GetSystemTime(&start);
+    for (i = 0; i < HANDLE_BENCH_CALLS; i++) {
+        res = TEE_GetObjectInfo1(objs[live - 1], &info);
+        if (res != TEE_SUCCESS)
+            goto out;
+    }
+    params[1].value.b = elapsed_ms(&start);
+
+    IMSG("%u live objects and operations, %d calls: %u ms digest update, "
+         "%u ms object info", live, HANDLE_BENCH_CALLS, params[1].value.a,
+         params[1].value.b);
+
+out:
+    for (i = 0; i < live; i++) {
+        if (ops && ops[i] != TEE_HANDLE_NULL)
+            TEE_FreeOperation(ops[i]);
+        if (objs)
+            TEE_FreeTransientObject(objs[i]);
+    }
+    TEE_Free(objs);
+    TEE_Free(ops);
+    return res;
+}
+
+#define PACKET_BENCH_DEFAULT_COUNT 10000
+#define PACKET_BENCH_LEN           64
+
+static TEE_Result packet_bench_op(uint32_t algo, uint32_t key_type,
+                                  uint32_t count, uint32_t *ms)
+{
+    TEE_Result res;
+    TEE_OperationHandle op = TEE_HANDLE_NULL;
+    TEE_ObjectHandle key = TEE_HANDLE_NULL;
+    uint8_t iv[16] = { 0 };
+    uint8_t in[PACKET_BENCH_LEN] = { 0 };
+    uint8_t out[PACKET_BENCH_LEN];
+    uint8_t tag[16];
+    size_t out_len, tag_len;
+    uint32_t i;
+    TEE_Time start;
+
+    res = TEE_AllocateOperation(&op, algo, TEE_MODE_ENCRYPT, 128);
+    if (res != TEE_SUCCESS)
+        goto out;
+    res = TEE_AllocateTransientObject(key_type, 128, &key);
+    if (res != TEE_SUCCESS)
+        goto out;
+    res = TEE_GenerateKey(key, 128, NULL, 0);
+    if (res != TEE_SUCCESS)
+        goto out;
+    res = TEE_SetOperationKey(op, key);
+    if (res != TEE_SUCCESS)
+        goto out;
+
+    /* same key, fresh IV for every packet */
+    TEE_GetSystemTime(&start);
+    for (i = 0; i < count; i++) {
+        TEE_MemMove(iv, &i, sizeof(i));
+        out_len = sizeof(out);
+        if (algo == TEE_ALG_AES_GCM) {
+            tag_len = sizeof(tag);
+            res = TEE_AEInit(op, iv, 12, sizeof(tag) * 8, 0, 0);
+            if (res != TEE_SUCCESS)
+                goto out;
+            res = TEE_AEEncryptFinal(op, in, sizeof(in), out, &out_len,
+                                     tag, &tag_len);
+        } else {
+            TEE_CipherInit(op, iv, sizeof(iv));
+            res = TEE_CipherDoFinal(op, in, sizeof(in), out, &out_len);
+        }
+        if (res != TEE_SUCCESS)
+            goto out;
+    }
+    *ms = elapsed_ms(&start);
+
+out:
+    if (op != TEE_HANDLE_NULL)
+        TEE_FreeOperation(op);
+    TEE_FreeTransientObject(key);
+    return res;
+}
+
+TEE_Result ta_entry_packet_bench(uint32_t param_type, TEE_Param params[4])
+{
+    TEE_Result res;
+    uint32_t count;
+
+    ASSERT_PARAM_TYPE(TEE_PARAM_TYPES
+                      (TEE_PARAM_TYPE_VALUE_INPUT,
+                       TEE_PARAM_TYPE_VALUE_OUTPUT, TEE_PARAM_TYPE_NONE,
+                       TEE_PARAM_TYPE_NONE));
+
+    count = params[0].value.a ? params[0].value.a : PACKET_BENCH_DEFAULT_COUNT;
+
+    res = packet_bench_op(TEE_ALG_AES_CBC_NOPAD, TEE_TYPE_AES, count,
+                          &params[1].value.a);
+    if (res != TEE_SUCCESS)
+        return res;
+    res = packet_bench_op(TEE_ALG_AES_GCM, TEE_TYPE_AES, count,
+                          &params[1].value.b);
+    if (res != TEE_SUCCESS)
+        return res;
+
+    IMSG("%u packets of %d bytes: %u ms AES-128-CBC, %u ms AES-128-GCM",
+         count, PACKET_BENCH_LEN, params[1].value.a, params[1].value.b);
+    return TEE_SUCCESS;
+}
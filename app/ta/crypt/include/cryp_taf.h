@@ -118,4 +118,10 @@ TEE_Result ta_entry_get_object_buffer_attribute(uint32_t param_type,
 TEE_Result ta_entry_get_object_value_attribute(uint32_t param_type,
                                                TEE_Param params[4]);
 
+TEE_Result ta_entry_mac_batch_bench(uint32_t param_type, TEE_Param params[4]);
+
+TEE_Result ta_entry_handle_bench(uint32_t param_type, TEE_Param params[4]);
+
+TEE_Result ta_entry_packet_bench(uint32_t param_type, TEE_Param params[4]);
+
 #endif /*CRYP_TAF_H */
@@ -362,4 +362,31 @@
 #define TA_CRYPT_CMD_SETGLOBAL     40
 #define TA_CRYPT_CMD_GETGLOBAL     41
 
+/*
+ * HMAC-SHA256 of 64-byte messages, one TEE_MACComputeFinal() per message
+ * against TEE_DigestBatch().
+ * in      params[0].value.a = number of messages, 0 for 10000
+ * out     params[1].value.a = milliseconds, one at a time
+ * out     params[1].value.b = milliseconds, batched
+ */
+#define TA_CRYPT_CMD_MAC_BATCH_BENCH 42
+
+/*
+ * Crypto syscall cost with many live handles: TEE_DigestUpdate() and
+ * TEE_GetObjectInfo1() on the newest of many operations and objects.
+ * in      params[0].value.a = number of objects and operations, 0 for 1000
+ * out     params[1].value.a = milliseconds for 10000 digest updates
+ * out     params[1].value.b = milliseconds for 10000 object info calls
+ */
+#define TA_CRYPT_CMD_HANDLE_BENCH 43
+
+/*
+ * Small-packet encryption: TEE_CipherInit()/TEE_AEInit() with a new IV and
+ * a 64-byte final for each packet, all under one AES-128 key.
+ * in      params[0].value.a = number of packets, 0 for 10000
+ * out     params[1].value.a = milliseconds, AES-CBC
+ * out     params[1].value.b = milliseconds, AES-GCM
+ */
+#define TA_CRYPT_CMD_PACKET_BENCH 44
+
 #endif /*TA_CRYPT_H */
@@ -220,6 +220,15 @@ TEE_Result TA_InvokeCommandEntryPoint(void *pSessionContext,
     case TA_CRYPT_CMD_GETGLOBAL:
         return get_global(nParamTypes, pParams);
 
+    case TA_CRYPT_CMD_MAC_BATCH_BENCH:
+        return ta_entry_mac_batch_bench(nParamTypes, pParams);
+
+    case TA_CRYPT_CMD_HANDLE_BENCH:
+        return ta_entry_handle_bench(nParamTypes, pParams);
+
+    case TA_CRYPT_CMD_PACKET_BENCH:
+        return ta_entry_packet_bench(nParamTypes, pParams);
+
     default:
         return TEE_ERROR_BAD_PARAMETERS;
     }
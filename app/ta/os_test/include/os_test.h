@@ -39,6 +39,10 @@ TEE_Result ta_entry_params_access_rights(uint32_t p_types,
                                          TEE_Param params[4]);
 TEE_Result ta_entry_wait(uint32_t param_types, TEE_Param params[4]);
 TEE_Result ta_entry_bad_mem_access(uint32_t param_types, TEE_Param params[4]);
+TEE_Result ta_entry_memref_stream(uint32_t param_types, TEE_Param params[4]);
+TEE_Result ta_entry_malloc_bench(uint32_t param_types, TEE_Param params[4]);
+TEE_Result ta_entry_udata_bench(uint32_t param_types, TEE_Param params[4]);
+TEE_Result ta_entry_prop_bench(uint32_t param_types, TEE_Param params[4]);
 TEE_Result ta_entry_mfw_apply_ddr_rules(uint32_t param_types,
                                         TEE_Param params[4]);
 TEE_Result ta_entry_mfw_apply_esram_rules(uint32_t param_types,
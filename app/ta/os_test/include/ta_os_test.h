@@ -41,4 +41,9 @@
 #define TA_OS_TEST_MFW_CMD_BASE         11
 #define TA_OS_TEST_MFW_CMD_LAST         16
 
+#define TA_OS_TEST_CMD_MEMREF_STREAM        17
+#define TA_OS_TEST_CMD_MALLOC_BENCH         18
+#define TA_OS_TEST_CMD_UDATA_BENCH          19
+#define TA_OS_TEST_CMD_PROP_BENCH           20
+
 #endif /*TA_OS_TEST_H */
@@ -26,6 +26,8 @@
  */
 #include <stdint.h>
 #include <setjmp.h>
+#include <trusty_std.h>
+#include <tee_api_properties.h>
 
 #include <compiler.h>
 /* #include <ta_crypt.h> */ /* NOT IMPLEMENTED */
@@ -938,3 +940,224 @@ TEE_Result ta_entry_bad_mem_access(uint32_t param_types, TEE_Param params[4])
 
     return TEE_SUCCESS;
 }
+
+static uint32_t elapsed_ms(const TEE_Time *start, const TEE_Time *end)
+{
+    return (end->seconds - start->seconds) * 1000 +
+           end->millis - start->millis;
+}
+
+/*
+ * Stream over a (typically 4 MB) memref params[1].value.a times, reading
+ * one word per 64 bytes so the pass is bound by tlb and cache misses.
+ * Returns the elapsed milliseconds in params[1].value.a and the sum in
+ * params[1].value.b; compare the kernel "tlb" counters around the call.
+ */
+TEE_Result ta_entry_memref_stream(uint32_t param_types, TEE_Param params[4])
+{
+    const volatile uint32_t *buf;
+    uint32_t passes;
+    uint32_t pass;
+    uint32_t sum = 0;
+    size_t words;
+    size_t n;
+    TEE_Time start;
+    TEE_Time end;
+
+    if (param_types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+                                       TEE_PARAM_TYPE_VALUE_INOUT, 0, 0))
+        return TEE_ERROR_BAD_PARAMETERS;
+
+    buf = params[0].memref.buffer;
+    words = params[0].memref.size / sizeof(uint32_t);
+    passes = params[1].value.a;
+
+    TEE_GetSystemTime(&start);
+    for (pass = 0; pass < passes; pass++) {
+        for (n = 0; n < words; n += 64 / sizeof(uint32_t))
+            sum += buf[n];
+    }
+    TEE_GetSystemTime(&end);
+
+    params[1].value.a = elapsed_ms(&start, &end);
+    params[1].value.b = sum;
+
+    printf("memref stream: %u bytes %u passes %u ms\n",
+           (unsigned int)params[0].memref.size, (unsigned int)passes,
+           (unsigned int)params[1].value.a);
+
+    return TEE_SUCCESS;
+}
+
+#define MALLOC_BENCH_DEFAULT_COUNT 10000
+
+TEE_Result ta_entry_malloc_bench(uint32_t param_types, TEE_Param params[4])
+{
+    void **bufs;
+    uint32_t count;
+    uint32_t n;
+    TEE_Time start;
+    TEE_Time end;
+
+    if (param_types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INOUT, 0, 0, 0))
+        return TEE_ERROR_BAD_PARAMETERS;
+
+    count = params[0].value.a ? params[0].value.a : MALLOC_BENCH_DEFAULT_COUNT;
+
+    bufs = TEE_Malloc(count * sizeof(*bufs), 0);
+    if (!bufs)
+        return TEE_ERROR_OUT_OF_MEMORY;
+
+    /* all blocks stay live until the free pass, like a parsed cert chain */
+    TEE_GetSystemTime(&start);
+    for (n = 0; n < count; n++) {
+        bufs[n] = TEE_Malloc(16 + (n & 63), 0);
+        if (!bufs[n])
+            break;
+    }
+    TEE_GetSystemTime(&end);
+    params[0].value.a = elapsed_ms(&start, &end);
+
+    /* newest first, the worst order for a search from the oldest block */
+    TEE_GetSystemTime(&start);
+    while (n)
+        TEE_Free(bufs[--n]);
+    TEE_GetSystemTime(&end);
+    params[0].value.b = elapsed_ms(&start, &end);
+
+    printf("malloc bench: %u blocks, %u ms malloc, %u ms free\n",
+           (unsigned int)count, (unsigned int)params[0].value.a,
+           (unsigned int)params[0].value.b);
+
+    TEE_Free(bufs);
+    return TEE_SUCCESS;
+}
+
+#define UDATA_BENCH_DEFAULT_COUNT 100000
+
+static uint32_t calls_per_sec(uint32_t count, uint32_t ms)
+{
+    return ms ? (uint32_t)((uint64_t)count * 1000 / ms) : 0;
+}
+
+/*
+ * Calls per second of the queries answered from the TA's data pages, and
+ * of the syscalls they replace.
+ */
+TEE_Result ta_entry_udata_bench(uint32_t param_types, TEE_Param params[4])
+{
+    uint32_t count;
+    uint32_t n;
+    uint32_t set = 0;
+    int64_t ns;
+    TEE_Time start;
+    TEE_Time end;
+    TEE_Time now;
+
+    if (param_types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INOUT,
+                                       TEE_PARAM_TYPE_VALUE_OUTPUT, 0, 0))
+        return TEE_ERROR_BAD_PARAMETERS;
+
+    count = params[0].value.a ? params[0].value.a : UDATA_BENCH_DEFAULT_COUNT;
+
+    TEE_GetSystemTime(&start);
+    for (n = 0; n < count; n++)
+        set += TEE_GetCancellationFlag();
+    TEE_GetSystemTime(&end);
+    params[0].value.a = calls_per_sec(count, elapsed_ms(&start, &end));
+
+    TEE_GetSystemTime(&start);
+    for (n = 0; n < count; n++)
+        set += get_cancel_flag();
+    TEE_GetSystemTime(&end);
+    params[0].value.b = calls_per_sec(count, elapsed_ms(&start, &end));
+
+    TEE_GetSystemTime(&start);
+    for (n = 0; n < count; n++)
+        TEE_GetSystemTime(&now);
+    TEE_GetSystemTime(&end);
+    params[1].value.a = calls_per_sec(count, elapsed_ms(&start, &end));
+
+    TEE_GetSystemTime(&start);
+    for (n = 0; n < count; n++)
+        gettime(0, 0, &ns);
+    TEE_GetSystemTime(&end);
+    params[1].value.b = calls_per_sec(count, elapsed_ms(&start, &end));
+
+    printf("udata bench: %u calls, per sec: cancel flag %u (syscall %u), "
+           "system time %u (syscall %u), flag set %u\n",
+           (unsigned int)count, (unsigned int)params[0].value.a,
+           (unsigned int)params[0].value.b, (unsigned int)params[1].value.a,
+           (unsigned int)params[1].value.b, (unsigned int)set);
+
+    return TEE_SUCCESS;
+}
+
+#define PROP_BENCH_DEFAULT_COUNT 10000
+
+/*
+ * Calls per second of typed property reads, which libutee answers from its
+ * property cache, and of the named get_kprops syscall each one used to take.
+ */
+TEE_Result ta_entry_prop_bench(uint32_t param_types, TEE_Param params[4])
+{
+    static const char u32_name[] = "gpd.ta.dataSize";
+    static const char str_name[] = "gpd.tee.apiversion";
+    uint32_t count;
+    uint32_t n;
+    uint32_t u32;
+    bool flag;
+    char str[64];
+    size_t str_len;
+    struct result_property prop;
+    TEE_Time start;
+    TEE_Time end;
+
+    if (param_types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INOUT,
+                                       TEE_PARAM_TYPE_VALUE_OUTPUT, 0, 0))
+        return TEE_ERROR_BAD_PARAMETERS;
+
+    count = params[0].value.a ? params[0].value.a : PROP_BENCH_DEFAULT_COUNT;
+
+    TEE_GetSystemTime(&start);
+    for (n = 0; n < count; n++)
+        TEE_GetPropertyAsU32((TEE_PropSetHandle)TEE_PROPSET_CURRENT_TA,
+                             u32_name, &u32);
+    TEE_GetSystemTime(&end);
+    params[0].value.a = calls_per_sec(count, elapsed_ms(&start, &end));
+
+    TEE_GetSystemTime(&start);
+    for (n = 0; n < count; n++) {
+        prop.value = &u32;
+        prop.value_buf_len = sizeof(u32);
+        get_kprops(u32_name, sizeof(u32_name), &prop, 0,
+                   (uint32_t)TEE_PROPSET_CURRENT_TA);
+    }
+    TEE_GetSystemTime(&end);
+    params[0].value.b = calls_per_sec(count, elapsed_ms(&start, &end));
+
+    TEE_GetSystemTime(&start);
+    for (n = 0; n < count; n++)
+        TEE_GetPropertyAsBool((TEE_PropSetHandle)TEE_PROPSET_CURRENT_TA,
+                              "gpd.ta.singleInstance", &flag);
+    TEE_GetSystemTime(&end);
+    params[1].value.a = calls_per_sec(count, elapsed_ms(&start, &end));
+
+    TEE_GetSystemTime(&start);
+    for (n = 0; n < count; n++) {
+        str_len = sizeof(str);
+        TEE_GetPropertyAsString(
+            (TEE_PropSetHandle)TEE_PROPSET_TEE_IMPLEMENTATION, str_name,
+            str, &str_len);
+    }
+    TEE_GetSystemTime(&end);
+    params[1].value.b = calls_per_sec(count, elapsed_ms(&start, &end));
+
+    printf("prop bench: %u calls, per sec: u32 %u (syscall %u), bool %u, "
+           "string %u\n",
+           (unsigned int)count, (unsigned int)params[0].value.a,
+           (unsigned int)params[0].value.b, (unsigned int)params[1].value.a,
+           (unsigned int)params[1].value.b);
+
+    return TEE_SUCCESS;
+}
@@ -101,6 +101,18 @@ TEE_Result TA_InvokeCommandEntryPoint(void *pSessionContext,
     case TA_OS_TEST_CMD_BAD_MEM_ACCESS:
         return ta_entry_bad_mem_access(nParamTypes, pParams);
 
+    case TA_OS_TEST_CMD_MEMREF_STREAM:
+        return ta_entry_memref_stream(nParamTypes, pParams);
+
+    case TA_OS_TEST_CMD_MALLOC_BENCH:
+        return ta_entry_malloc_bench(nParamTypes, pParams);
+
+    case TA_OS_TEST_CMD_UDATA_BENCH:
+        return ta_entry_udata_bench(nParamTypes, pParams);
+
+    case TA_OS_TEST_CMD_PROP_BENCH:
+        return ta_entry_prop_bench(nParamTypes, pParams);
+
     default:
         return TEE_ERROR_BAD_PARAMETERS;
     }
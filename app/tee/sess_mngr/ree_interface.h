@@ -61,6 +61,15 @@
  */
 #define MIPSTEE_MSG_ATTR_FRAGMENT           BIT(9)
 
+/*
+ * The temp memref is not physically contiguous and buf_ptr points to a
+ * page list instead of the buffer. Each page of the list holds
+ * PAGE_SIZE / 8 - 1 page addresses followed by the address of the next
+ * page of the list. The offset of the buffer in its first page is passed
+ * in the low bits of buf_ptr.
+ */
+#define MIPSTEE_MSG_ATTR_NONCONTIG          (1ULL << 10)
+
 /*
  * Memory attributes for caching passed with temp memrefs. The actual value
  * used is defined outside the message protocol with the exception of
@@ -87,6 +96,14 @@
 #define MIPSTEE_MSG_CMD_INVOKE_COMMAND          1
 #define MIPSTEE_MSG_CMD_CLOSE_SESSION           2
 #define MIPSTEE_MSG_CMD_CANCEL                  3
+/*
+ * MIPSTEE_MSG_CMD_REGISTER_SHM carries a single tmem parameter describing
+ * the buffer, MIPSTEE_MSG_CMD_UNREGISTER_SHM a single rmem parameter for
+ * the same range. Both are answered directly by the Session Manager with
+ * the message echoed back and ret/ret_origin set. Memrefs into registered
+ * memory stay mapped in the TA between invokes. A range whose address or
+ * size does not fit the TEE's native word gets TEE_ERROR_NOT_SUPPORTED.
+ */
 #define MIPSTEE_MSG_CMD_REGISTER_SHM            4
 #define MIPSTEE_MSG_CMD_UNREGISTER_SHM          5
 #define MIPSTEE_MSG_FUNCID_CALL_WITH_ARG        0x0004
@@ -33,15 +33,6 @@
 #define DEFAULT_TIMEOUT_MSECS 1000
 #define TEE_SM_NUM_RX_BUF 8
 
-/* Session Manager UUID. It has to be kept in sync with changes to SM UUID in
- * appropriate manifest file.
- */
-#ifdef SM_UUID
-#undef SM_UUID
-#endif
-#define SM_UUID { 0x7ea5ad73, 0xd8eb, 0x4859, \
-                  { 0xa2, 0x06, 0x17, 0x46, 0xd3, 0xc4, 0xcc, 0xdf } }
-
 #define TEE_PARAM_TYPE_SET(t, i) (((t) & 0xF) << ((i) * 4))
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
@@ -88,6 +79,8 @@ static unsigned long trusted_ch_map[BITMAP_NUM_WORDS(IPC_MAX_HANDLES)];
 /* forward declarations */
 static void force_close_session(struct sess_context *sess);
 static struct sess_context *sess_context_get(uint32_t session_id);
+static status_t sm_send_buffer(handle_t channel, uint8_t *buffer,
+        uint32_t buf_size);
 
 static const char *id_str(unsigned int id)
 {
@@ -118,7 +111,8 @@ static inline uint32_t sm_get_data_tag(struct mipstee_tipc_msg *ree_buf)
 
 static status_t msg_param_to_tee_param(struct mipstee_msg_param *msg_params,
                                      size_t msg_num_params,
-                                     utee_params_t *uparam)
+                                     utee_params_t *uparam,
+                                     uint32_t *ns_pagelist)
 {
     size_t i;
     const uint8_t tee_param[] = {
@@ -135,6 +129,7 @@ static status_t msg_param_to_tee_param(struct mipstee_msg_param *msg_params,
     };
 
     uparam->param_types = 0;
+    *ns_pagelist = 0;
     /*
      * GP API specification (and our implementation) supports up to 4
      * parameters in open session and invoke command operations.
@@ -144,12 +139,13 @@ static status_t msg_param_to_tee_param(struct mipstee_msg_param *msg_params,
 
     for (i = 0; i < msg_num_params; i++) {
         struct mipstee_msg_param *mp = msg_params + i;
+        uint64_t attr = mp->attr & ~MIPSTEE_MSG_ATTR_NONCONTIG;
 
-        if (mp->attr >= ARRAY_SIZE(tee_param))
+        if (attr >= ARRAY_SIZE(tee_param))
             return ERR_INVALID_ARGS;
 
-        uparam->param_types |= TEE_PARAM_TYPE_SET(tee_param[mp->attr], i);
-        switch (mp->attr) {
+        uparam->param_types |= TEE_PARAM_TYPE_SET(tee_param[attr], i);
+        switch (attr) {
         case MIPSTEE_MSG_ATTR_TYPE_NONE:
         case MIPSTEE_MSG_ATTR_TYPE_VALUE_OUTPUT:
             uparam->params[2 * i] = 0;
@@ -178,10 +174,18 @@ static status_t msg_param_to_tee_param(struct mipstee_msg_param *msg_params,
             // TODO: Check if this is enough for handling memrefs
             uparam->params[2 * i] = mp->u.tmem.buf_ptr;
             uparam->params[2 * i + 1] = mp->u.tmem.size;
+            /* the kernel walks the page list when mapping the memref */
+            if (mp->attr & MIPSTEE_MSG_ATTR_NONCONTIG)
+                *ns_pagelist |= 1U << i;
             break;
         default:
             return ERR_INVALID_ARGS;
         }
+
+        /* only temp memrefs can be described by a page list */
+        if ((mp->attr & MIPSTEE_MSG_ATTR_NONCONTIG) &&
+                !(*ns_pagelist & (1U << i)))
+            return ERR_INVALID_ARGS;
     }
 
     return NO_ERROR;
@@ -310,6 +314,7 @@ static status_t ree_to_tee_msg(uint8_t *ns_data, size_t read_len,
     struct mipstee_tipc_msg *ree_buf;
     struct mipstee_msg_arg *ree_arg;
     struct mipstee_msg_param *ree_param;
+    uint32_t ns_pagelist;
     status_t sys_res;
 
     ree_buf = (struct mipstee_tipc_msg *)ns_data;
@@ -336,6 +341,7 @@ static status_t ree_to_tee_msg(uint8_t *ns_data, size_t read_len,
     msg_args->parent_sess_id = 0;
     msg_args->parent_op_id = 0;
     msg_args->client_ta = 0;
+    msg_args->ns_pagelist = 0;
 
     switch (msg_args->cmd) {
     case TEE_OPEN_SESSION_ID:
@@ -351,9 +357,10 @@ static status_t ree_to_tee_msg(uint8_t *ns_data, size_t read_len,
     case TEE_INVOKE_COMMAND_ID:
     case TEE_CANCEL_ID:
         sys_res = msg_param_to_tee_param(ree_param, ree_arg->num_params,
-                               &msg_args->utee_params);
+                               &msg_args->utee_params, &ns_pagelist);
         if (sys_res)
             return sys_res;
+        msg_args->ns_pagelist = ns_pagelist;
         break;
     case TEE_CLOSE_SESSION_ID:
         break;
@@ -364,6 +371,76 @@ static status_t ree_to_tee_msg(uint8_t *ns_data, size_t read_len,
     return NO_ERROR;
 }
 
+static bool is_ree_shm_cmd(uint8_t *ns_data, size_t read_len)
+{
+    struct mipstee_tipc_msg *ree_buf = (struct mipstee_tipc_msg *)ns_data;
+
+    if (read_len < MIPSTEE_TIPC_MSG_GET_SIZE(0) ||
+            ree_buf->hdr.magic != REE_MAGIC)
+        return false;
+
+    return ree_buf->msg.cmd == MIPSTEE_MSG_CMD_REGISTER_SHM ||
+           ree_buf->msg.cmd == MIPSTEE_MSG_CMD_UNREGISTER_SHM;
+}
+
+/*
+ * The register_shm/unregister_shm syscalls take native sized arguments. A
+ * range the REE describes with wider ones is refused rather than truncated
+ * to some other range, as memrefs into it could not be mapped either.
+ */
+static bool ree_shm_range_fits(uint64_t buf, uint64_t size)
+{
+    return buf == (unsigned long)buf && size == (size_t)size;
+}
+
+/*
+ * Register or unregister a range of REE shared memory with the kernel and
+ * reply straight away; no TA is involved. Returns ERR_ALREADY_STARTED so
+ * that the message is not processed any further.
+ */
+static status_t ree_handle_shm_cmd(handle_t channel, uint8_t *ns_data,
+        size_t read_len)
+{
+    struct mipstee_tipc_msg *ree_buf = (struct mipstee_tipc_msg *)ns_data;
+    struct mipstee_msg_param *mp = ree_buf->msg.params;
+    uint64_t buf;
+    TEE_Result ret;
+    status_t sys_res;
+
+    if (read_len != MIPSTEE_TIPC_MSG_GET_SIZE(1) ||
+            ree_buf->msg.num_params != 1) {
+        ret = TEE_ERROR_BAD_PARAMETERS;
+    } else if (ree_buf->msg.cmd == MIPSTEE_MSG_CMD_REGISTER_SHM) {
+        buf = mp->u.tmem.buf_ptr;
+        if (mp->attr < MIPSTEE_MSG_ATTR_TYPE_TMEM_INPUT ||
+                mp->attr > MIPSTEE_MSG_ATTR_TYPE_TMEM_INOUT)
+            ret = TEE_ERROR_BAD_PARAMETERS;
+        else if (!ree_shm_range_fits(buf, mp->u.tmem.size))
+            ret = TEE_ERROR_NOT_SUPPORTED;
+        else
+            ret = register_shm(buf, mp->u.tmem.size);
+    } else {
+        buf = mp->u.rmem.shm_ref + mp->u.rmem.offs;
+        if (mp->attr < MIPSTEE_MSG_ATTR_TYPE_RMEM_INPUT ||
+                mp->attr > MIPSTEE_MSG_ATTR_TYPE_RMEM_INOUT)
+            ret = TEE_ERROR_BAD_PARAMETERS;
+        else if (!ree_shm_range_fits(buf, mp->u.rmem.size))
+            ret = TEE_ERROR_NOT_SUPPORTED;
+        else
+            ret = unregister_shm(buf, mp->u.rmem.size);
+    }
+
+    TEE_DBG_MSG("ree shm cmd %u returned %x\n", ree_buf->msg.cmd, ret);
+
+    ree_buf->msg.ret = ret;
+    ree_buf->msg.ret_origin = TEE_ORIGIN_TEE;
+    sys_res = sm_send_buffer(channel, ns_data, read_len);
+    if (sys_res < 0)
+        return sys_res;
+
+    return ERR_ALREADY_STARTED;
+}
+
 static bool uuid_cmp(const uuid_t *val1, const uuid_t *val2)
 {
     uint32_t retval = (uint32_t)((val1->time_low == val2->time_low) &&
@@ -542,6 +619,9 @@ static status_t sm_get_msg_buffer(handle_t channel, uint8_t *buffer,
         }
         /* messages from TAs and client TAs are of the msg_map_t type */
         memcpy(buffer, in_msg_buf, buf_len);
+    } else if (is_ree_shm_cmd(in_msg_buf, read_len)) {
+        sys_res = ree_handle_shm_cmd(channel, in_msg_buf, read_len);
+        goto err_put_fail;
     } else {
         /* messages from untrusted REE client TAs need to be adapted */
         sys_res = ree_to_tee_msg(in_msg_buf, read_len, (msg_map_t *)buffer);
@@ -39,6 +39,18 @@
 #define TEE_MAX_BUFFER_SIZE 256
 #define TEE_SESS_MANAGER_COMMAND_MSG "tee.sess_manager.command_msg"
 
+/*
+ * Session Manager UUID. It has to be kept in sync with changes to SM UUID in
+ * appropriate manifest file.
+ * Any earlier definition is replaced, so that tampering with SM_UUID cannot
+ * affect the checks made against it.
+ */
+#ifdef SM_UUID
+#undef SM_UUID
+#endif
+#define SM_UUID { 0x7ea5ad73, 0xd8eb, 0x4859, \
+                  { 0xa2, 0x06, 0x17, 0x46, 0xd3, 0xc4, 0xcc, 0xdf } }
+
 /*****************************************************************************
  * syscall interface on TEE side for:
  * - sys_invoke_operation()
@@ -73,6 +85,47 @@ struct utee_attribute {
     uint32_t attribute_id;
 };
 
+/*
+ * One message of a utee_hash_batch() call. digest_len holds the size of the
+ * digest buffer on input and the size of the digest on output.
+ */
+struct utee_hash_msg {
+    uint64_t data;	/* pointer to the message */
+    uint64_t data_len;
+    uint64_t digest;	/* pointer to the digest buffer */
+    uint64_t digest_len;
+};
+
+/*
+ * Read-only pages the kernel maps into every TA right above the user stack,
+ * so that frequent queries are answered without a syscall. They are 16KB
+ * apart to stay page aligned with any page size.
+ */
+#define UTEE_TIME_DATA_VADDR    0x1000000
+#define UTEE_TA_DATA_VADDR      0x1004000
+
+/*
+ * Shared by all TAs. Time in usecs is
+ * base_us + (count - base_count) / count_mhz, where count is hardware
+ * register 2, the CP0 count register. The kernel refreshes the base well
+ * before count can wrap. seq is odd while it does; readers retry until they
+ * see the same even seq before and after. count_mhz is 0 if there is no
+ * time base and the gettime syscall has to be used.
+ */
+struct utee_time_data {
+    volatile uint32_t seq;
+    volatile uint32_t count_mhz;
+    volatile uint32_t base_count;
+    uint32_t reserved;
+    volatile uint64_t base_us;
+};
+
+/* Private to each TA instance */
+struct utee_ta_data {
+    volatile uint32_t cancel;   /* flag set and cancellation unmasked */
+    uint32_t props_num;         /* properties in TEE_PROPSET_CURRENT_TA */
+};
+
 /*****************************************************************************
  * Formatting of messages on TEE side
  *****************************************************************************/
@@ -103,6 +156,7 @@ typedef union  __attribute__((__packed__)) {
         uint32_t parent_sess_id;
         uint32_t parent_op_id;
         uintptr_t client_ta;
+        uint32_t ns_pagelist; // bit i: memref i is an NS page list
     };
 } msg_map_t;
 
@@ -34,6 +34,7 @@
 
 struct sess_status {
     void *session_ctx;  /* Session context parameter */
+    uint32_t session_id;    /* Session id given by the session manager */
     TEE_Identity client_id; /* Client's identity */
 };
 
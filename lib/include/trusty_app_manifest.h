@@ -44,6 +44,7 @@ enum {
 	TRUSTY_APP_CONFIG_KEY_AUTO_START	= 4,
 	TRUSTY_APP_CONFIG_KEY_EXTERN		= 5,
 	TRUSTY_APP_CONFIG_KEY_PRIVILEGES        = 6,
+	TRUSTY_APP_CONFIG_KEY_INSTANCE_POOL	= 7,
 };
 
 #define TRUSTY_APP_CFG_ITERATOR(_blob, _cnt, _key, _val) \
@@ -77,6 +78,11 @@ enum {
 #define TRUSTY_APP_CONFIG_PRIVILEGES(flags) \
 	TRUSTY_APP_CONFIG_SZ(1), TRUSTY_APP_CONFIG_KEY_PRIVILEGES, flags
 
+/* idle instances of a multi-instance app kept started for new sessions;
+ * ignored for single instance apps */
+#define TRUSTY_APP_CONFIG_INSTANCE_POOL(cnt) \
+	TRUSTY_APP_CONFIG_SZ(1), TRUSTY_APP_CONFIG_KEY_INSTANCE_POOL, cnt
+
 /* manifest section attributes */
 #define TRUSTY_APP_MANIFEST_ATTRS \
 	__attribute((aligned(4))) __attribute((section(".trusty_app.manifest")))
@@ -63,6 +63,8 @@
 #define __NR_connect_to_sm                       	0x3e
 #define __NR_get_ta_flags                        	0x3f
 #define __NR_tee_wait                            	0x40
+#define __NR_register_shm                        	0x41
+#define __NR_unregister_shm                      	0x42
 #define __NR_utee_cryp_state_alloc               	0x50
 #define __NR_utee_cryp_state_copy                	0x51
 #define __NR_utee_cryp_state_free                	0x52
@@ -103,6 +105,7 @@
 #define __NR_utee_storage_obj_write              	0x75
 #define __NR_utee_storage_obj_trunc              	0x76
 #define __NR_utee_storage_obj_seek               	0x77
+#define __NR_utee_hash_batch                     	0x78
 
 #ifndef ASSEMBLY
 
@@ -148,6 +151,8 @@ bool unmask_cancel_flag(void);
 TEE_Result connect_to_sm(uint32_t *handle_id);
 TEE_Result get_ta_flags(const uuid_t *dest_uuid, uint32_t *flags);
 TEE_Result tee_wait(uint32_t timeout);
+TEE_Result register_shm(unsigned long buf, size_t size);
+TEE_Result unregister_shm(unsigned long buf, size_t size);
 TEE_Result utee_cryp_state_alloc(unsigned long algo, unsigned long op_mode, unsigned long key1, unsigned long key2, uint32_t *state);
 TEE_Result utee_cryp_state_copy(unsigned long dst, unsigned long src);
 TEE_Result utee_cryp_state_free(unsigned long state);
@@ -188,6 +193,7 @@ TEE_Result utee_storage_obj_read(unsigned long obj, void *data, size_t len, uint
 TEE_Result utee_storage_obj_write(unsigned long obj, const void *data, size_t len);
 TEE_Result utee_storage_obj_trunc(unsigned long obj, size_t len);
 TEE_Result utee_storage_obj_seek(unsigned long obj, int32_t offset, unsigned long whence);
+TEE_Result utee_hash_batch(unsigned long state, struct utee_hash_msg *msgs, unsigned long num_msgs);
 
 __END_CDECLS
 
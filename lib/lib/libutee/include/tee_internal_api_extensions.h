@@ -56,4 +56,27 @@ TEE_Result TEE_CacheClean(char *buf, size_t len);
 TEE_Result TEE_CacheFlush(char *buf, size_t len);
 TEE_Result TEE_CacheInvalidate(char *buf, size_t len);
 
+/*
+ * Batched message digest and MAC computation
+ *
+ * TEE_DigestBatch() computes the digest (TEE_OPERATION_DIGEST) or the MAC
+ * (TEE_OPERATION_MAC, after TEE_MACInit()) of each of num independent
+ * messages with a single call into the TEE core. Any data already passed to
+ * the operation is discarded, and on return the operation is in the same
+ * state as after TEE_DigestDoFinal() or TEE_MACInit() respectively.
+ *
+ * hashLen holds the size of the hash buffer on input and the size of the
+ * digest on output. TEE_ERROR_SHORT_BUFFER is returned, and no digest is
+ * computed, if any of the hash buffers is too small.
+ */
+typedef struct {
+    const void *data;
+    size_t dataLen;
+    void *hash;
+    size_t hashLen;
+} TEE_DigestBatchEntry;
+
+TEE_Result TEE_DigestBatch(TEE_OperationHandle operation,
+                           TEE_DigestBatchEntry *entries, size_t num);
+
 #endif
@@ -63,6 +63,9 @@ TEE_Result utee_hash_update(unsigned long state, const void *chunk,
 			    size_t chunk_size);
 TEE_Result utee_hash_final(unsigned long state, const void *chunk,
 			   size_t chunk_size, void *hash, uint64_t *hash_len);
+/* Digest or MAC of independent messages, state is left re-initialized */
+TEE_Result utee_hash_batch(unsigned long state, struct utee_hash_msg *msgs,
+			   unsigned long num_msgs);
 
 TEE_Result utee_cipher_init(unsigned long state, const void *iv, size_t iv_len);
 TEE_Result utee_cipher_update(unsigned long state, const void *src,
@@ -33,4 +33,7 @@
 void __utee_from_attr(struct utee_attribute *ua, const TEE_Attribute *attrs,
                       uint32_t attr_count);
 
+/* Drops the cached client properties of a session that is being closed */
+void tee_prop_session_closed(uint32_t session);
+
 #endif /*TEE_API_PRIVATE*/
@@ -27,6 +27,7 @@
  */
 
 #include <tee_internal_api.h>
+#include <tee_common_uapi.h>
 #include <trusty_std.h>
 
 /*
@@ -41,7 +42,11 @@
  */
 bool TEE_GetCancellationFlag(void)
 {
-    return get_cancel_flag();
+    const struct utee_ta_data *data =
+        (const struct utee_ta_data *)UTEE_TA_DATA_VADDR;
+
+    /* the kernel keeps the flag up to date in our data page */
+    return data->cancel != 0;
 }
 
 /*
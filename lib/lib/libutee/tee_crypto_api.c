@@ -900,6 +900,73 @@ out:
     return res;
 }
 
+/* Number of batch entries passed to the TEE core per system call */
+#define DIGEST_BATCH_CHUNK 16
+
+TEE_Result TEE_DigestBatch(TEE_OperationHandle operation,
+                           TEE_DigestBatchEntry *entries, size_t num)
+{
+    TEE_Result res = TEE_SUCCESS;
+    struct utee_hash_msg msgs[DIGEST_BATCH_CHUNK];
+    size_t digest_size;
+    size_t done, n, i;
+
+    if (operation == TEE_HANDLE_NULL || (!entries && num))
+        TEE_Panic(0);
+
+    switch (operation->info.operationClass) {
+    case TEE_OPERATION_DIGEST:
+        break;
+    case TEE_OPERATION_MAC:
+        if ((operation->info.handleState & TEE_HANDLE_FLAG_INITIALIZED) == 0)
+            TEE_Panic(0);
+        break;
+    default:
+        TEE_Panic(0);
+    }
+
+    /* check all buffers up front so that nothing is hashed on failure */
+    if (tee_hash_get_digest_size(operation->info.algorithm,
+                                 &digest_size) == TEE_SUCCESS) {
+        for (i = 0; i < num; i++) {
+            if (entries[i].hashLen < digest_size)
+                res = TEE_ERROR_SHORT_BUFFER;
+        }
+        if (res != TEE_SUCCESS) {
+            for (i = 0; i < num; i++)
+                entries[i].hashLen = digest_size;
+            return res;
+        }
+    }
+
+    for (done = 0; done < num; done += n) {
+        n = MIN(num - done, (size_t)DIGEST_BATCH_CHUNK);
+        for (i = 0; i < n; i++) {
+            msgs[i].data = (uintptr_t)entries[done + i].data;
+            msgs[i].data_len = entries[done + i].dataLen;
+            msgs[i].digest = (uintptr_t)entries[done + i].hash;
+            msgs[i].digest_len = entries[done + i].hashLen;
+        }
+
+        res = utee_hash_batch(operation->state, msgs, n);
+        if (res != TEE_SUCCESS && res != TEE_ERROR_SHORT_BUFFER)
+            TEE_Panic(res);
+
+        for (i = 0; i < n; i++)
+            entries[done + i].hashLen = msgs[i].digest_len;
+        if (res != TEE_SUCCESS)
+            return res;
+    }
+
+    /* the TEE core re-initialized the state */
+    if (operation->info.operationClass == TEE_OPERATION_DIGEST) {
+        operation->buffer_offs = 0;
+        operation->operationState = TEE_OPERATION_STATE_INITIAL;
+    }
+
+    return TEE_SUCCESS;
+}
+
 /* Cryptographic Operations API - Symmetric Cipher Functions */
 
 void TEE_CipherInit(TEE_OperationHandle operation, const void *IV,
@@ -40,17 +40,38 @@
 
 /*
  * Memory element structure; attaches hint and size value to the allocated block
- * of memory
+ * of memory. It sits right in front of the buffer handed to the TA so
+ * TEE_Free and TEE_Realloc find it without a lookup. The magic is derived from
+ * the header address and cleared on free, which catches pointers that were not
+ * returned by TEE_Malloc or were already freed.
  */
 struct mem_elem {
-    struct list_node mem_elem_node;
-    void *buf;
+    uint32_t magic;
     uint32_t size;
     uint32_t hint;
+    uint32_t reserved; /* keeps the buffer 8 byte aligned */
 };
 
-/* List of memory element structures allocated by TA instance */
-static struct list_node mem_elem_list = LIST_INITIAL_VALUE(mem_elem_list);
+#define MEM_ELEM_MAGIC 0x4d454d45 /* "MEME" */
+
+/*
+ * Zero sized allocations all return MALLOC_ZERO_MAGIC, only their hint has to
+ * be kept for TEE_Realloc.
+ */
+struct zero_elem {
+    struct list_node node;
+    uint32_t hint;
+};
+
+/* List of zero sized allocations made by TA instance */
+static struct list_node zero_elem_list = LIST_INITIAL_VALUE(zero_elem_list);
+
+/*
+ * Bounds of all blocks handed out so far. A header is only read if it lies
+ * inside them, so a stray pointer cannot fault on the magic check.
+ */
+static uintptr_t mem_heap_start = UINTPTR_MAX;
+static uintptr_t mem_heap_end;
 
 /* Placeholders for Memory Management Functions */
 
@@ -239,14 +260,48 @@ void *TEE_GetInstanceData(void)
     return (void *)tee_instance_data;
 }
 
+static inline uint32_t mem_elem_magic(const struct mem_elem *el)
+{
+    return MEM_ELEM_MAGIC ^ (uint32_t)(uintptr_t)el;
+}
+
+static void mem_elem_init(struct mem_elem *el, uint32_t size)
+{
+    uintptr_t end = (uintptr_t)(el + 1) + size;
+
+    el->magic = mem_elem_magic(el);
+    el->size = size;
+
+    if ((uintptr_t)el < mem_heap_start)
+        mem_heap_start = (uintptr_t)el;
+    if (end > mem_heap_end)
+        mem_heap_end = end;
+}
+
 static struct mem_elem *get_mem_elem_from_buffer(const void *buffer)
 {
-    struct mem_elem *el;
+    uintptr_t addr = (uintptr_t)buffer;
+    struct mem_elem *el = (struct mem_elem *)buffer - 1;
+
+    if (addr & (sizeof(uint32_t) - 1))
+        return NULL;
+    if (addr < mem_heap_start || addr - mem_heap_start < sizeof(*el) ||
+        addr > mem_heap_end)
+        return NULL;
+    if (el->magic != mem_elem_magic(el))
+        return NULL;
+    return el;
+}
+
+static void *zero_elem_alloc(uint32_t hint)
+{
+    struct zero_elem *el = malloc(sizeof(*el));
 
-    list_for_every_entry(&mem_elem_list, el, struct mem_elem, mem_elem_node)
-        if (el->buf == buffer)
-            return el;
-    return NULL;
+    if (!el)
+        return NULL;
+    el->hint = hint;
+    list_add_tail(&zero_elem_list, &el->node);
+    return MALLOC_ZERO_MAGIC;
 }
 
 /*
@@ -298,8 +353,7 @@ static struct mem_elem *get_mem_elem_from_buffer(const void *buffer)
  */
 void *TEE_Malloc(size_t size, uint32_t hint)
 {
-    void *buf;
-    uint32_t total_size = size + sizeof(struct mem_elem);
+    struct mem_elem *el;
 
     if (size > UINT32_MAX - sizeof(struct mem_elem))
         return NULL;
@@ -313,24 +367,20 @@ void *TEE_Malloc(size_t size, uint32_t hint)
         return NULL;
     }
 
-    buf = malloc((size_t)total_size);
-    if (buf != NULL) {
-        struct mem_elem *el = (struct mem_elem *)buf;
-
-        el->size = size;
-        el->hint = hint;
-        if (!size)
-            el->buf = MALLOC_ZERO_MAGIC;
-        else
-            el->buf = (void *)((uint8_t *)buf + sizeof(struct mem_elem));
-        list_add_tail(&mem_elem_list, &el->mem_elem_node);
-        buf = el->buf;
-
-        if (hint == TEE_MALLOC_FILL_ZERO && size)
-            memset(buf, 0, size);
-    }
+    if (!size)
+        return zero_elem_alloc(hint);
+
+    el = malloc(size + sizeof(struct mem_elem));
+    if (!el)
+        return NULL;
+
+    mem_elem_init(el, size);
+    el->hint = hint;
 
-    return buf;
+    if (hint == TEE_MALLOC_FILL_ZERO)
+        memset(el + 1, 0, size);
+
+    return el + 1;
 }
 
 /*
@@ -371,10 +421,10 @@ void *TEE_Malloc(size_t size, uint32_t hint)
 void *TEE_Realloc(const void *buffer, uint32_t newSize)
 {
     struct mem_elem *el_old;
+    struct mem_elem *el_new;
+    struct zero_elem *zel;
     uint32_t hint, old_size;
     void *ptr;
-    uint32_t total_size = newSize + sizeof(struct mem_elem);
-    uint32_t resize = 0;
 
     if (newSize > UINT32_MAX - sizeof(struct mem_elem))
         return NULL;
@@ -382,6 +432,19 @@ void *TEE_Realloc(const void *buffer, uint32_t newSize)
     if (!buffer)
         return TEE_Malloc(newSize, TEE_MALLOC_FILL_ZERO);
 
+    if (buffer == MALLOC_ZERO_MAGIC) {
+        zel = list_peek_head_type(&zero_elem_list, struct zero_elem, node);
+        if (!zel)
+            TEE_Panic(TEE_ERROR_ITEM_NOT_FOUND);
+
+        ptr = TEE_Malloc(newSize, zel->hint);
+        if (ptr) {
+            list_delete(&zel->node);
+            free(zel);
+        }
+        return ptr;
+    }
+
     el_old = get_mem_elem_from_buffer(buffer);
     if (!el_old)
         TEE_Panic(TEE_ERROR_ITEM_NOT_FOUND);
@@ -389,36 +452,26 @@ void *TEE_Realloc(const void *buffer, uint32_t newSize)
     hint = el_old->hint;
     old_size = el_old->size;
 
-    ptr = realloc(el_old, total_size);
-    if (!ptr)
-        return NULL;
+    if (!newSize) {
+        ptr = zero_elem_alloc(hint);
+        if (ptr)
+            TEE_Free((void *)buffer);
+        return ptr;
+    }
 
-    if (newSize > old_size)
-        resize = newSize - old_size;
-
-    if (ptr != el_old) {
-        /* Remove old list entry and add new */
-        list_delete(&el_old->mem_elem_node);
-        struct mem_elem *el_new = (struct mem_elem *)ptr;
-        el_new->size = newSize;
-        el_new->hint = hint;
-        if (newSize)
-            el_new->buf = (void *)((uint8_t *)el_new + sizeof(struct mem_elem));
-        else
-            el_new->buf = MALLOC_ZERO_MAGIC;
-        list_add_tail(&mem_elem_list, &el_new->mem_elem_node);
-        ptr = el_new->buf;
-    } else {
-        if (!newSize)
-            el_old->buf = MALLOC_ZERO_MAGIC;
-        else if (el_old->buf == MALLOC_ZERO_MAGIC && newSize)
-            el_old->buf = (void *)((uint8_t *)el_old + sizeof(struct mem_elem));
-        el_old->size = newSize;
-        ptr = el_old->buf;
+    /* the old header is stale once realloc moves the block */
+    el_old->magic = 0;
+    el_new = realloc(el_old, newSize + sizeof(struct mem_elem));
+    if (!el_new) {
+        el_old->magic = mem_elem_magic(el_old);
+        return NULL;
     }
 
-    if (hint == TEE_MALLOC_FILL_ZERO && resize)
-        memset((void *)((uint8_t *)ptr + old_size), 0, resize);
+    mem_elem_init(el_new, newSize);
+    ptr = el_new + 1;
+
+    if (hint == TEE_MALLOC_FILL_ZERO && newSize > old_size)
+        memset((uint8_t *)ptr + old_size, 0, newSize - old_size);
 
     return ptr;
 }
@@ -433,15 +486,25 @@ void *TEE_Realloc(const void *buffer, uint32_t newSize)
  */
 void TEE_Free(void *buffer)
 {
+    struct mem_elem *el;
+    struct zero_elem *zel;
+
     if (!buffer)
         return;
 
-    struct mem_elem *el = get_mem_elem_from_buffer(buffer);
+    if (buffer == MALLOC_ZERO_MAGIC) {
+        zel = list_remove_head_type(&zero_elem_list, struct zero_elem, node);
+        if (!zel)
+            TEE_Panic(TEE_ERROR_ITEM_NOT_FOUND);
+        free(zel);
+        return;
+    }
 
+    el = get_mem_elem_from_buffer(buffer);
     if (!el)
         TEE_Panic(TEE_ERROR_ITEM_NOT_FOUND);
 
-    list_delete(&el->mem_elem_node);
+    el->magic = 0;
     free(el);
 }
 
@@ -34,6 +34,7 @@
 #include <tee_ta_interface.h>
 #include <tee_internal_api.h>
 #include <tee_api_defines.h>
+#include "tee_api_private.h"
 
 #define TEE_LOCAL_TRACE 0
 #define TEE_TAG "UTEE"
@@ -118,6 +119,323 @@ static const struct ta_property propset_client[] = {
 static const size_t propset_client_len = sizeof(propset_client) /
                                          sizeof(propset_client[0]);
 
+/*
+ * The CURRENT_TA and TEE_IMPLEMENTATION sets never change while the TA runs,
+ * and a client TA's set stays the same for the life of a session. Each set is
+ * read out of the kernel once, by index, and lookups are then served from
+ * this copy instead of a get_kprops/get_prop_name syscall per call. Entries
+ * keep the set's index order and are chained by name hash for named reads.
+ * A set that cannot be read is cached too, as the error lookups return.
+ */
+#define PROP_CACHE_BUCKETS  16
+#define PROP_CACHE_BUF_LEN  64
+
+/* client sets of this many sessions are kept, least recently used goes */
+#define PROP_CLIENT_CACHES  4
+
+struct prop_cache_entry {
+    char *name;
+    uint32_t type;
+    void *value;
+    uint32_t value_len;
+    struct prop_cache_entry *hash_next;
+};
+
+struct prop_cache {
+    bool valid;
+    TEE_Result res;     /* why the set could not be read */
+    uint32_t count;
+    struct prop_cache_entry *entries;
+    struct prop_cache_entry *hash[PROP_CACHE_BUCKETS];
+};
+
+struct client_prop_cache {
+    uint32_t session;
+    TEE_UUID uuid;      /* client TA the set was read for */
+    uint32_t last_use;
+    struct prop_cache cache;
+};
+
+static struct prop_cache ta_prop_cache;
+static struct prop_cache impl_prop_cache;
+static struct client_prop_cache client_prop_caches[PROP_CLIENT_CACHES];
+static uint32_t client_prop_clock;
+
+static uint32_t prop_cache_bucket(const char *name)
+{
+    uint32_t hash = 2166136261u;
+
+    while (*name)
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
+
+    return hash % PROP_CACHE_BUCKETS;
+}
+
+static void prop_cache_free(struct prop_cache *cache)
+{
+    uint32_t i;
+
+    for (i = 0; i < cache->count; i++) {
+        TEE_Free(cache->entries[i].name);
+        TEE_Free(cache->entries[i].value);
+    }
+    TEE_Free(cache->entries);
+    memset(cache, 0, sizeof(*cache));
+}
+
+static TEE_Result prop_fetch_value(uint32_t prop_set, uuid_t *uuid,
+                                   uint32_t idx, struct result_property *prop)
+{
+    if (prop_set == TEE_PROPSET_CURRENT_CLIENT)
+        return get_ta_client_props(uuid, NULL, 0, (void *)prop, idx);
+
+    return get_kprops(NULL, 0, (void *)prop, idx, prop_set);
+}
+
+static TEE_Result prop_cache_load(struct prop_cache_entry *entry,
+                                  uint32_t prop_set, uuid_t *uuid,
+                                  uint32_t idx)
+{
+    TEE_Result res;
+    char buf[PROP_CACHE_BUF_LEN];
+    size_t len = sizeof(buf);
+    struct result_property prop;
+
+    res = get_prop_name(prop_set, idx, buf, uuid, &len);
+    if (res != TEE_SUCCESS && res != TEE_ERROR_SHORT_BUFFER)
+        return res;
+
+    entry->name = TEE_Malloc(len, 0);
+    if (!entry->name)
+        return TEE_ERROR_OUT_OF_MEMORY;
+
+    if (res == TEE_ERROR_SHORT_BUFFER)
+        res = get_prop_name(prop_set, idx, entry->name, uuid, &len);
+    else
+        memcpy(entry->name, buf, len);
+    if (res != TEE_SUCCESS)
+        return res;
+
+    prop.value = buf;
+    prop.value_buf_len = sizeof(buf);
+    res = prop_fetch_value(prop_set, uuid, idx, &prop);
+    if (res != TEE_SUCCESS && res != TEE_ERROR_SHORT_BUFFER)
+        return res;
+
+    /* the kernel only reports the length of strings and short reads */
+    switch (prop.type) {
+    case TA_PROP_TYPE_BOOL:
+    case TA_PROP_TYPE_U32:
+        len = sizeof(uint32_t);
+        break;
+    case TA_PROP_TYPE_UUID:
+        len = sizeof(TEE_UUID);
+        break;
+    case TA_PROP_TYPE_ID:
+        len = sizeof(TEE_Identity);
+        break;
+    default:
+        len = prop.value_buf_len;
+        break;
+    }
+
+    entry->type = prop.type;
+    entry->value_len = len;
+    entry->value = TEE_Malloc(len, 0);
+    if (!entry->value)
+        return TEE_ERROR_OUT_OF_MEMORY;
+
+    if (res == TEE_ERROR_SHORT_BUFFER) {
+        prop.value = entry->value;
+        prop.value_buf_len = len;
+        res = prop_fetch_value(prop_set, uuid, idx, &prop);
+    } else {
+        memcpy(entry->value, buf, len);
+    }
+
+    return res;
+}
+
+static TEE_Result prop_cache_fill(struct prop_cache *cache, uint32_t prop_set,
+                                  uuid_t *uuid)
+{
+    TEE_Result res;
+    struct prop_cache_entry *entry;
+    uint32_t count;
+    uint32_t bucket;
+    uint32_t i;
+
+    res = get_props_num(uuid, prop_set, &count);
+    if (res == TEE_SUCCESS && count) {
+        cache->entries = TEE_Malloc(count * sizeof(*cache->entries),
+                                    TEE_MALLOC_FILL_ZERO);
+        if (!cache->entries)
+            res = TEE_ERROR_OUT_OF_MEMORY;
+    }
+    if (res == TEE_SUCCESS) {
+        cache->count = count;
+        for (i = 0; i < count && res == TEE_SUCCESS; i++)
+            res = prop_cache_load(&cache->entries[i], prop_set, uuid, i);
+    }
+
+    if (res != TEE_SUCCESS) {
+        prop_cache_free(cache);
+        /* running out of memory is retried, anything else is remembered */
+        if (res != TEE_ERROR_OUT_OF_MEMORY) {
+            cache->res = res;
+            cache->valid = true;
+        }
+        return res;
+    }
+
+    /* chain backwards so a name lookup finds the lowest index, as the
+     * kernel's linear search does
+     */
+    for (i = count; i--; ) {
+        entry = &cache->entries[i];
+        bucket = prop_cache_bucket(entry->name);
+        entry->hash_next = cache->hash[bucket];
+        cache->hash[bucket] = entry;
+    }
+
+    cache->valid = true;
+    return TEE_SUCCESS;
+}
+
+/*
+ * Slot for the client set of the active session. The uuid is compared too,
+ * so a session id reused after a missed close does not see a stale set.
+ */
+static struct prop_cache *client_prop_cache_get(const TEE_UUID *uuid)
+{
+    uint32_t session = ta_context->active_sess.session_id;
+    struct client_prop_cache *slot = &client_prop_caches[0];
+    uint32_t i;
+
+    for (i = 0; i < PROP_CLIENT_CACHES; i++) {
+        struct client_prop_cache *c = &client_prop_caches[i];
+
+        if (c->cache.valid && c->session == session &&
+            memcmp(&c->uuid, uuid, sizeof(c->uuid)) == 0) {
+            slot = c;
+            goto found;
+        }
+        if (!c->cache.valid ||
+            (slot->cache.valid && c->last_use < slot->last_use))
+            slot = c;
+    }
+
+    prop_cache_free(&slot->cache);
+    slot->session = session;
+    memcpy(&slot->uuid, uuid, sizeof(slot->uuid));
+found:
+    slot->last_use = ++client_prop_clock;
+    return &slot->cache;
+}
+
+void tee_prop_session_closed(uint32_t session)
+{
+    uint32_t i;
+
+    for (i = 0; i < PROP_CLIENT_CACHES; i++) {
+        if (client_prop_caches[i].session == session)
+            prop_cache_free(&client_prop_caches[i].cache);
+    }
+}
+
+/*
+ * Cache of prop_set, filled on first use. client is only looked at for
+ * TEE_PROPSET_CURRENT_CLIENT, where it is the client TA of the active
+ * session. Returns NULL if memory ran out while reading the set, leaving the
+ * caller to go to the kernel directly. A set the kernel refused is returned
+ * with res set, which lookups in it fail with.
+ */
+static struct prop_cache *prop_cache_get(uint32_t prop_set,
+                                         TEE_Identity *client)
+{
+    struct prop_cache *cache;
+    uuid_t *uuid = NULL;
+
+    switch (prop_set) {
+    case TEE_PROPSET_CURRENT_TA:
+        cache = &ta_prop_cache;
+        break;
+    case TEE_PROPSET_TEE_IMPLEMENTATION:
+        cache = &impl_prop_cache;
+        break;
+    case TEE_PROPSET_CURRENT_CLIENT:
+        cache = client_prop_cache_get(&client->uuid);
+        uuid = (uuid_t *)&client->uuid;
+        break;
+    default:
+        return NULL;
+    }
+
+    if (!cache->valid &&
+        prop_cache_fill(cache, prop_set, uuid) == TEE_ERROR_OUT_OF_MEMORY)
+        return NULL;
+
+    return cache;
+}
+
+/* Same results as get_kprops for a property of a cached set. */
+static TEE_Result prop_cache_read(const struct prop_cache *cache,
+                                  const char *name, uint32_t index,
+                                  struct result_property *prop)
+{
+    const struct prop_cache_entry *entry = NULL;
+
+    if (cache->res != TEE_SUCCESS)
+        return cache->res;
+
+    if (name != NULL) {
+        for (entry = cache->hash[prop_cache_bucket(name)]; entry;
+             entry = entry->hash_next) {
+            if (strcmp(name, entry->name) == 0)
+                break;
+        }
+    } else if (index < cache->count) {
+        entry = &cache->entries[index];
+    }
+
+    if (!entry)
+        return TEE_ERROR_ITEM_NOT_FOUND;
+
+    prop->type = entry->type;
+    if (prop->value_buf_len < entry->value_len) {
+        prop->value_buf_len = entry->value_len;
+        return TEE_ERROR_SHORT_BUFFER;
+    }
+
+    memcpy(prop->value, entry->value, entry->value_len);
+    if (entry->type == TA_PROP_TYPE_STR ||
+        entry->type == TA_PROP_TYPE_BIN_BLOCK)
+        prop->value_buf_len = entry->value_len;
+
+    return TEE_SUCCESS;
+}
+
+/* Same results as get_prop_name for a property of a cached set. */
+static TEE_Result prop_cache_name(const struct prop_cache *cache, uint32_t idx,
+                                  char *prop_name, size_t *buffer_len)
+{
+    size_t len;
+
+    if (cache->res != TEE_SUCCESS)
+        return cache->res;
+    if (idx >= cache->count)
+        return TEE_ERROR_ITEM_NOT_FOUND;
+
+    len = strlcpy(prop_name, cache->entries[idx].name, *buffer_len) + 1;
+    if (len > *buffer_len) {
+        *buffer_len = len;
+        return TEE_ERROR_SHORT_BUFFER;
+    }
+    *buffer_len = len;
+
+    return TEE_SUCCESS;
+}
+
 static long handle_current_client(const char *name, size_t name_len,
                                   struct result_property *prop, uint32_t index)
 {
@@ -159,6 +477,12 @@ index_to_large:
      * is TEE_LOGIN_TRUSTED_APP search in client TA properties.
      */
     if (client_id.login == TEE_LOGIN_TRUSTED_APP) {
+        struct prop_cache *cache =
+            prop_cache_get(TEE_PROPSET_CURRENT_CLIENT, &client_id);
+
+        if (cache)
+            return prop_cache_read(cache, name, index - propset_client_len,
+                                   prop);
         return get_ta_client_props((uuid_t *)&client_id.uuid, name, name_len,
                                       (void *)prop,
                                       index - propset_client_len);
@@ -174,9 +498,13 @@ static TEE_Result ta_config_prop(const char *name,
     if (name != NULL)
         name_len = strlen(name) + 1;
 
-    if (prop_set_id != TEE_PROPSET_CURRENT_CLIENT)
+    if (prop_set_id != TEE_PROPSET_CURRENT_CLIENT) {
+        struct prop_cache *cache = prop_cache_get(prop_set_id, NULL);
+
+        if (cache)
+            return prop_cache_read(cache, name, index, prop);
         return get_kprops(name, name_len, (void *)prop, index, prop_set_id);
-    else if (prop_set_id == TEE_PROPSET_CURRENT_CLIENT)
+    } else if (prop_set_id == TEE_PROPSET_CURRENT_CLIENT)
         return handle_current_client(name, name_len, (void *)prop, index);
 
     TEE_DBG_MSG("ERROR: Invalid property set indentifier.\n");
@@ -548,6 +876,8 @@ static TEE_Result handle_prop_name(uint32_t prop_set, uint32_t idx,
 {
     TEE_Result res;
     uuid_t *ta_uuid = NULL;
+    TEE_Identity client_id;
+    struct prop_cache *cache;
     size_t len;
 
     if (prop_set == TEE_PROPSET_CURRENT_CLIENT) {
@@ -560,8 +890,6 @@ static TEE_Result handle_prop_name(uint32_t prop_set, uint32_t idx,
             *buffer_len = len;
             return TEE_SUCCESS;
         } else {
-            TEE_Identity client_id;
-
             idx -= propset_client_len;
             /* Get the client's UUID for the syscall */
             get_client_identity((void *)&client_id);
@@ -571,6 +899,10 @@ static TEE_Result handle_prop_name(uint32_t prop_set, uint32_t idx,
         }
     }
 
+    cache = prop_cache_get(prop_set, &client_id);
+    if (cache)
+        return prop_cache_name(cache, idx, prop_name, buffer_len);
+
     res = get_prop_name(prop_set, idx, prop_name, ta_uuid, buffer_len);
     return res;
 }
@@ -614,6 +946,7 @@ TEE_Result TEE_GetNextProperty(TEE_PropSetHandle enumerator)
     TEE_Result res = TEE_SUCCESS;
     uuid_t *ta_uuid = NULL;
     TEE_Identity client_id = {0, {0} };
+    struct prop_cache *cache;
 
     if (enumerator == NULL || enumerator == TEE_HANDLE_NULL)
         TEE_Panic(TEE_ERROR_BAD_PARAMETERS);
@@ -628,20 +961,34 @@ TEE_Result TEE_GetNextProperty(TEE_PropSetHandle enumerator)
 
     if ((uint32_t) enum_ptr->propSet == TEE_PROPSET_CURRENT_CLIENT) {
         client_props_num = propset_client_len;
-        if (enum_ptr->index >= client_props_num)
-            res = TEE_ERROR_ITEM_NOT_FOUND;
+        get_client_identity((void *)&client_id);
+        if (client_id.login == TEE_LOGIN_TRUSTED_APP)
+            ta_uuid = (uuid_t *)&client_id.uuid;
     }
 
-    if (((uint32_t) enum_ptr->propSet != TEE_PROPSET_CURRENT_CLIENT) ||
-        client_id.login == TEE_LOGIN_TRUSTED_APP) {
-        res = get_props_num(ta_uuid, (uint32_t) enum_ptr->propSet,
+    if ((uint32_t) enum_ptr->propSet == TEE_PROPSET_CURRENT_TA) {
+        /* fixed for the life of the TA, published in its data page */
+        props_num =
+            ((const struct utee_ta_data *)UTEE_TA_DATA_VADDR)->props_num;
+    } else if (((uint32_t) enum_ptr->propSet != TEE_PROPSET_CURRENT_CLIENT) ||
+        ta_uuid) {
+        cache = prop_cache_get((uint32_t) enum_ptr->propSet, &client_id);
+        if (cache) {
+            res = cache->res;
+            if (res != TEE_SUCCESS)
+                goto next_prop_err;
+            props_num = cache->count;
+        } else {
+            res = get_props_num(ta_uuid, (uint32_t) enum_ptr->propSet,
                                 &props_num);
-        if (res != TEE_SUCCESS)
-            goto next_prop_err;
-        if (enum_ptr->index >= props_num + client_props_num)
-            res = TEE_ERROR_ITEM_NOT_FOUND;
+            if (res != TEE_SUCCESS)
+                goto next_prop_err;
+        }
     }
 
+    if (enum_ptr->index >= props_num + client_props_num)
+        res = TEE_ERROR_ITEM_NOT_FOUND;
+
 next_prop_err:
     if (res != TEE_ERROR_ITEM_NOT_FOUND &&
         res != TEE_SUCCESS)
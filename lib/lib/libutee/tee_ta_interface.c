@@ -34,6 +34,7 @@
 #include <tee_internal_api.h>
 #include <tee_common_uapi.h>
 #include <tee_arith_internal.h>
+#include "tee_api_private.h"
 #include <trusty_std.h>
 #include <err.h>
 
@@ -45,7 +46,8 @@
 static bool ta_create_done = false;
 static struct ta_ctx __ta_context;
 struct ta_ctx *ta_context = &__ta_context;
-static msg_map_t _ep_msg;
+/* the kernel accesses it through one page translation, keep it in one page */
+static msg_map_t _ep_msg __attribute__((aligned(TEE_MAX_BUFFER_SIZE)));
 
 #define TIME_MULTIPLICATOR  1000000
 
@@ -151,6 +153,7 @@ static TEE_Result preprocess_entry(uint32_t ep_id, msg_map_t *msg_buffer,
     tee_uuid_from_octets(&ta_context->active_sess.client_id.uuid,
                          msg_buffer->client_id_uuid);
     ta_context->active_sess.session_ctx = (void *)msg_buffer->session_ctx;
+    ta_context->active_sess.session_id = msg_buffer->session;
 
     if (ep_id == TEE_INVOKE_COMMAND_ID)
         *cmd_id = msg_buffer->func;
@@ -260,6 +263,7 @@ static void entry_close_session(msg_map_t *msg_buffer)
         goto close_sess_end;
 
     res = call_ta_close_session_entry_point(ta_context->active_sess.session_ctx);
+    tee_prop_session_closed(ta_context->active_sess.session_id);
 
 close_sess_end:
     postprocess_entry(TEE_CLOSE_SESSION_ID, msg_buffer, 0, NULL, res);
@@ -41,16 +41,48 @@ struct ta_persistent_time_t {
 
 static struct ta_persistent_time_t *ta_persistent_time = NULL;
 
+/* usecs from the kernel's time page, false if it doesn't publish one */
+static bool utee_time_us(uint64_t *us)
+{
+#if defined(__mips_isa_rev) && __mips_isa_rev >= 2
+    const struct utee_time_data *td =
+        (const struct utee_time_data *)UTEE_TIME_DATA_VADDR;
+    uint32_t seq, mhz, base_count, count;
+    uint64_t base_us;
+
+    do {
+        seq = td->seq;
+        mhz = td->count_mhz;
+        base_count = td->base_count;
+        base_us = td->base_us;
+        __asm__ volatile("rdhwr %0, $2" : "=r" (count) : : "memory");
+    } while ((seq & 1) || seq != td->seq);
+
+    if (!mhz)
+        return false;
+
+    *us = base_us + (count - base_count) / mhz;
+    return true;
+#else
+    return false;
+#endif
+}
+
 void TEE_GetSystemTime(TEE_Time *time)
 {
     int64_t local_time;
+    uint64_t us;
     long res;
 
-    res = gettime(0, 0, &local_time);
-    if (res < 0)
-        TEE_Panic(err_to_tee_err(res));
-    /* gettime() returns time in nsec */
-    local_time /= 1000000;
+    if (utee_time_us(&us)) {
+        local_time = us / 1000;
+    } else {
+        res = gettime(0, 0, &local_time);
+        if (res < 0)
+            TEE_Panic(err_to_tee_err(res));
+        /* gettime() returns time in nsec */
+        local_time /= 1000000;
+    }
     time->seconds = local_time / 1000;
     time->millis = local_time - time->seconds * 1000;
 }
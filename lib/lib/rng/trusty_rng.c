@@ -51,15 +51,15 @@ static uint64_t counter;
 static uint8_t rand_bytes_buf[AES_BLOCK_SIZE];
 static uint32_t rand_bytes_pos;
 static bool rng_initialized;
+/* entropy_pool expanded once, redone whenever the pool changes */
+static AES_KEY pool_key;
 
-static int aes_encrypt_ecb(uint8_t *dst, const uint8_t *src,
-			const uint8_t *key_bytes, size_t key_size_bits)
+static int set_pool_key(void)
 {
-	AES_KEY key;
-	if (AES_set_encrypt_key(key_bytes, key_size_bits, &key) != 0)
+	if (AES_set_encrypt_key(entropy_pool, sizeof(entropy_pool) * 8,
+			&pool_key) != 0)
 		return ERR_INVALID_ARGS;
 
-	AES_encrypt(src, dst, &key);
 	return NO_ERROR;
 }
 
@@ -74,6 +74,10 @@ static int trusty_rng_init(void)
 	if (err)
 		goto done;
 
+	err = set_pool_key();
+	if (err)
+		goto done;
+
 	counter = 0;
 	rand_bytes_pos = sizeof(rand_bytes_buf);
 	rng_initialized = true;
@@ -103,10 +107,7 @@ int trusty_rng_secure_rand(uint8_t *data, size_t len)
 			memcpy(counter_buf, &counter, sizeof(counter));
 
 			/* Encrypt the counter, placing the results in rand_bytes_buf */
-			err = aes_encrypt_ecb(rand_bytes_buf, counter_buf, entropy_pool,
-					sizeof(entropy_pool) * 8);
-			if (err)
-				goto done;
+			AES_encrypt(counter_buf, rand_bytes_buf, &pool_key);
 
 			rand_bytes_pos = 0;
 		}
@@ -137,6 +138,8 @@ int trusty_rng_add_entropy(const uint8_t *data, size_t len)
 	/* XOR new entropy bytes into the pool */
 	for (i = 0; (i < sizeof(entropy_pool)) && (i < len); ++i)
 		entropy_pool[i] ^= data[i];
+
+	err = set_pool_key();
 done:
 	return err;
 }
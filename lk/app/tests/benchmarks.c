@@ -153,6 +153,73 @@ __NO_INLINE static void bench_memcpy(void)
     free(buf);
 }
 
+__NO_INLINE static void bench_memcpy_unaligned(void)
+{
+    uint8_t *buf = malloc(BUFSIZE);
+    if (!buf) {
+        printf("failed to allocate buffer\n");
+        return;
+    }
+
+    uint count = arch_cycle_count();
+    for (uint i = 0; i < ITER; i++) {
+        memcpy(buf, buf + BUFSIZE / 2 + 1, BUFSIZE / 2 - 1);
+    }
+    count = arch_cycle_count() - count;
+
+    printf("took %u cycles to memcpy a misaligned buffer of size %u %d times (%u source bytes), %f source bytes/cycle\n",
+           count, BUFSIZE / 2 - 1, ITER, (BUFSIZE / 2 - 1) * ITER, ((BUFSIZE / 2 - 1) * ITER) / (float)count);
+
+    free(buf);
+}
+
+__NO_INLINE static void bench_memcmp(void)
+{
+    uint8_t *buf = malloc(BUFSIZE);
+    if (!buf) {
+        printf("failed to allocate buffer\n");
+        return;
+    }
+
+    memset(buf, 0x5a, BUFSIZE);
+
+    int res = 0;
+    uint count = arch_cycle_count();
+    for (uint i = 0; i < ITER; i++) {
+        res |= memcmp(buf, buf + BUFSIZE / 2, BUFSIZE / 2);
+    }
+    count = arch_cycle_count() - count;
+
+    printf("took %u cycles to memcmp a buffer of size %u %d times (%u bytes), %f bytes/cycle (res %d)\n",
+           count, BUFSIZE / 2, ITER, BUFSIZE / 2 * ITER, (BUFSIZE / 2 * ITER) / (float)count, res);
+
+    free(buf);
+}
+
+__NO_INLINE static void bench_strlen(void)
+{
+    char *buf = malloc(BUFSIZE);
+    if (!buf) {
+        printf("failed to allocate buffer\n");
+        return;
+    }
+
+    memset(buf, 'a', BUFSIZE);
+    buf[BUFSIZE - 1] = '\0';
+
+    size_t len = 0;
+    uint count = arch_cycle_count();
+    for (uint i = 0; i < ITER; i++) {
+        len += strlen(buf);
+    }
+    count = arch_cycle_count() - count;
+
+    printf("took %u cycles to strlen a string of length %u %d times (%u bytes), %f bytes/cycle\n",
+           count, len / ITER, ITER, len, len / (float)count);
+
+    free(buf);
+}
+
 #if ARCH_ARM
 __NO_INLINE static void arm_bench_cset_stm(void)
 {
@@ -252,6 +319,9 @@ void benchmarks(void)
     bench_set_overhead();
     bench_memset();
     bench_memcpy();
+    bench_memcpy_unaligned();
+    bench_memcmp();
+    bench_strlen();
 
     bench_cset_uint8_t();
     bench_cset_uint16_t();
@@ -29,6 +29,7 @@
 #include <lib/console.h>
 #include <platform.h>
 #include <debug.h>
+#include <kernel/thread.h>
 
 #if WITH_KERNEL_VM
 #include <kernel/vm.h>
@@ -237,6 +238,101 @@ usage:
     return 0;
 }
 
+#define HEAP_BENCH_SLOTS 32
+#define HEAP_BENCH_MAX_THREADS 16
+
+#define __HEAP_NAME(x) #x
+#define HEAP_NAME(x) __HEAP_NAME(x)
+
+struct heap_bench_args {
+    uint iterations;
+    uint seed;
+    uint failed;
+    lk_bigtime_t time;
+};
+
+static int heap_bench_thread(void *arg)
+{
+    struct heap_bench_args *args = arg;
+    void *slot[HEAP_BENCH_SLOTS] = { NULL };
+    uint seed = args->seed;
+    uint i;
+
+    lk_bigtime_t t = current_time_hires();
+    for (i = 0; i < args->iterations; i++) {
+        seed = seed * 1103515245 + 12345;
+
+        /* replace a random slot, mostly with small objects */
+        uint n = (seed >> 16) % HEAP_BENCH_SLOTS;
+        size_t size = 16 << ((seed >> 8) % 6);
+        if ((seed & 0xff) == 0)
+            size = 4096;
+
+        free(slot[n]);
+        slot[n] = malloc(size);
+        if (slot[n])
+            *(volatile uint32_t *)slot[n] = i;
+        else
+            args->failed++;
+    }
+    for (i = 0; i < HEAP_BENCH_SLOTS; i++)
+        free(slot[i]);
+    args->time = current_time_hires() - t;
+
+    return 0;
+}
+
+static int heap_bench(int argc, const cmd_args *argv)
+{
+    struct heap_bench_args args[HEAP_BENCH_MAX_THREADS];
+    thread_t *threads[HEAP_BENCH_MAX_THREADS];
+    uint nthreads = (argc >= 2) ? argv[1].u : 4;
+    uint iterations = (argc >= 3) ? argv[2].u : 100000;
+    uint i;
+
+    if (nthreads == 0 || nthreads > HEAP_BENCH_MAX_THREADS) {
+        printf("usage: %s [threads (1-%d)] [iterations per thread]\n",
+               argv[0].str, HEAP_BENCH_MAX_THREADS);
+        return -1;
+    }
+
+    printf("heap %s, %u threads, %u malloc/free pairs each\n",
+           HEAP_NAME(LK_HEAP_IMPLEMENTATION), nthreads, iterations);
+
+    lk_bigtime_t t = current_time_hires();
+    for (i = 0; i < nthreads; i++) {
+        args[i].iterations = iterations;
+        args[i].seed = i + 1;
+        args[i].failed = 0;
+        threads[i] = thread_create("heap bench", &heap_bench_thread, &args[i],
+                                   DEFAULT_PRIORITY, DEFAULT_STACK_SIZE);
+        if (!threads[i]) {
+            printf("error creating heap bench thread %u\n", i);
+            break;
+        }
+    }
+    /* run whatever was created so it can exit, but only report full runs */
+    bool complete = (i == nthreads);
+    nthreads = i;
+    for (i = 0; i < nthreads; i++)
+        thread_resume(threads[i]);
+    for (i = 0; i < nthreads; i++)
+        thread_join(threads[i], NULL, INFINITE_TIME);
+    t = current_time_hires() - t;
+    if (!complete)
+        return -1;
+
+    for (i = 0; i < nthreads; i++) {
+        printf("\tthread %u: %llu usecs, %u failed allocations\n", i,
+               args[i].time, args[i].failed);
+    }
+    printf("total %llu usecs, %llu nsecs per pair\n", t,
+           t * 1000 / ((lk_bigtime_t)nthreads * MAX(iterations, 1u)));
+
+    return 0;
+}
+
 STATIC_COMMAND_START
 STATIC_COMMAND("mem_test", "test memory", &mem_test)
+STATIC_COMMAND("heap_bench", "multithreaded malloc/free benchmark", &heap_bench)
 STATIC_COMMAND_END(mem_tests);
@@ -27,12 +27,14 @@
 #include <debug.h>
 #include <assert.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <bits.h>
 #include <kernel/thread.h>
 #include <kernel/debug.h>
 #include <mips/m32c0.h>
 #include <arch/mips.h>
 #include <arch/mips/mmu.h>
+#include <arch/tlb.h>
 #if WITH_LIB_UTHREAD
 #include <arch/uthread_mmu.h>
 #endif
@@ -244,11 +246,14 @@ static int mips_tlb_exception_user(struct mips_iframe *iframe)
 
 #if WITH_LIB_UTHREAD
     status_t err;
+    uthread_t *ut = uthread_get_current();
     vaddr_t vaddr = iframe->badvaddr;
+    vaddr_t pair;
+    size_t pair_size;
     paddr_t paddr;
     u_int mmu_flags = 0;
 
-    err = mips_uthread_mmu_query(uthread_get_current(), vaddr, &paddr, &mmu_flags);
+    err = mips_uthread_mmu_query(ut, vaddr, &paddr, &mmu_flags);
     if (err) {
         TRACEF("No page entry found\n");
         goto user_fail;
@@ -258,6 +263,7 @@ static int mips_tlb_exception_user(struct mips_iframe *iframe)
     uint32_t excode = exc_code(iframe);
     switch (excode) {
     case EXC_MOD:
+    case EXC_TLBS:
         if ((mmu_flags & MMU_DIRTY) == 0) {
             TRACEF("Attempt to modify read-only page\n");
             goto user_fail;
@@ -268,17 +274,7 @@ static int mips_tlb_exception_user(struct mips_iframe *iframe)
             TRACEF("Attempt to read no-read page\n");
             goto user_fail;
         }
-        else {
-            // map in the page
-            // TODO ideally probe and replace existing TLB entry (using mips_tlbrwr2)
-            // TODO hack: invalidate current entry and re-take _tlb_refill exception
-            tlbhi_t entryhi = mips_read_c0_entryhi();
-            assert((entryhi & ~0x1fffUL) == (vaddr & ~0x1fffUL) && "entryhi and badvaddr mismatch");
-            mips_tlbinval(entryhi);
-            handled = 1;
-        }
         break;
-    case EXC_TLBS:
     case EXC_TLBRI:
     case EXC_TLBXI:
         goto user_fail;
@@ -288,6 +284,23 @@ static int mips_tlb_exception_user(struct mips_iframe *iframe)
         goto user_fail;
         break;
     }
+
+    // the page table allows the access, so the tlb entry is stale (the page
+    // was mapped after its pair was loaded): rewrite it in place
+    err = mips_uthread_mmu_tlb_load(ut, vaddr, &pair_size, false);
+    if (err)
+        goto user_fail;
+    mips_tlb_stats.reload++;
+
+    // on sequential faults also load the next pair ahead of its access,
+    // if all of it is mapped
+    pair = ROUNDDOWN(vaddr, pair_size);
+    if (pair == ut->arch.tlb_fault_next &&
+        !mips_uthread_mmu_tlb_load(ut, pair + pair_size, NULL, true))
+        mips_tlb_stats.preload++;
+    ut->arch.tlb_fault_next = pair + pair_size;
+
+    handled = 1;
     return handled;
 
 user_fail:
@@ -296,8 +309,43 @@ user_fail:
     return handled;
 }
 
+// A store to a copy-on-write page of the current uthread, from user mode or
+// a kernel copy_to_user. The copy may block on the uthread's mmap lock, so
+// it is only done when the faulting context ran with interrupts enabled.
+static int mips_tlb_exception_cow(struct mips_iframe *iframe)
+{
+#if WITH_LIB_UTHREAD
+    uint32_t excode = exc_code(iframe);
+    uthread_t *ut = uthread_get_current();
+    status_t err;
+
+    if (excode != EXC_MOD && excode != EXC_TLBS)
+        return 0;
+    if (!ut || iframe->badvaddr >= MAX_USR_VA || !(iframe->status & SR_IE))
+        return 0;
+
+    arch_enable_ints();
+    err = uthread_cow_fault(ut, iframe->badvaddr);
+    arch_disable_ints();
+
+    if (err == NO_ERROR) {
+        mips_tlb_stats.cow++;
+        return 1;
+    }
+    if (err != ERR_NOT_FOUND)
+        TRACEF("copy-on-write fault at %#x failed: %d\n",
+               iframe->badvaddr, err);
+#endif
+    return 0;
+}
+
 static int mips_tlb_exception(struct mips_iframe *iframe)
 {
+    mips_tlb_stats.fault++;
+
+    if (mips_tlb_exception_cow(iframe))
+        return 1;
+
     // TODO move this check later if we want on demand user paging, otherwise
     // kernel copy_to_user will fail on demand accesses.
     if (fault_handler_table_hit(iframe))
@@ -64,6 +64,7 @@ GEN_CP_REG_FUNCS(c0_entrylo1, 3, 0)
 GEN_CP_REG_FUNCS(c0_context, 4, 0)
 GEN_CP_REG_FUNCS(c0_pagemask, 5, 0)
 GEN_CP_REG_FUNCS(c0_pagegrain, 5, 1)
+GEN_CP_REG_FUNCS(c0_hwrena, 7, 0)
 GEN_CP_REG_FUNCS(c0_badvaddr, 8, 0)
 GEN_CP_REG_FUNCS(c0_badinstr, 8, 1)
 GEN_CP_REG_FUNCS(c0_badinstrp, 8, 2)
@@ -90,6 +91,10 @@ GEN_CP_REG_FUNCS(c0_config5, 16, 5)
 GEN_CP_REG_FUNCS(c0_config6, 16, 6)
 GEN_CP_REG_FUNCS(c0_config7, 16, 7)
 GEN_CP_REG_FUNCS(c0_config8, 16, 8)
+GEN_CP_REG_FUNCS(c0_perfctl0, 25, 0)
+GEN_CP_REG_FUNCS(c0_perfcnt0, 25, 1)
+GEN_CP_REG_FUNCS(c0_perfctl1, 25, 2)
+GEN_CP_REG_FUNCS(c0_perfcnt1, 25, 3)
 
 struct mips_iframe {
     uint32_t at;
@@ -124,6 +129,7 @@ STATIC_ASSERT((IFRAME_SIZE % 8) == 0);
 STATIC_ASSERT(offsetof(struct mips_iframe, sp) == IFRAME_SP);
 
 void mips_init_timer(uint32_t freq);
+uint32_t mips_timer_rate_mhz(void);
 enum handler_return mips_timer_irq(void);
 
 void mips_enable_irq(uint num);
@@ -23,6 +23,8 @@
  */
 #pragma once
 
+#include <arch/defines.h>
+
 #define TLB_ENTRYLO_PFN_SHIFT	(6)
 #define TLB_ENTRYLO_RIXI_ROTR	(2)
 
@@ -44,6 +46,20 @@
 #define MMU_RX		(MMU_VALID)
 #define MMU_RWX		(MMU_VALID | MMU_DIRTY)
 
+/*
+ * Kernel page tables map kseg2 and kseg3 with the same pte format and L2
+ * table shape as the uthread tables. Empty kernel ptes keep MMU_GLOBAL so
+ * a tlb pair with one unmapped half is still global.
+ */
+#define MMU_KERNEL_BASE		(0xc0000000)
+#define MMU_KERNEL_SIZE		(0x40000000)
+#define MMU_KERNEL_L1_SHIFT	(20)
+#define MMU_KERNEL_L1_WIDTH	(10)
+#define MMU_KERNEL_L1_ENTRIES	(1 << MMU_KERNEL_L1_WIDTH)
+#define MMU_KERNEL_L2_ENTRIES	(1 << (MMU_KERNEL_L1_SHIFT - PAGE_SIZE_SHIFT))
+#define MMU_KERNEL_L2_SIZE	(MMU_KERNEL_L2_ENTRIES * 4)
+#define MMU_KERNEL_PTE_EMPTY	(MMU_GLOBAL)
+
 #ifndef ASSEMBLY
 
 #define LOW_512MB_MASK  ((uintptr_t)0x1fffffff)
@@ -23,6 +23,37 @@
  */
 #pragma once
 
+/* count tlb refills in the refill handler, which costs a load and a store */
+#ifndef MIPS_TLB_STATS
+#define MIPS_TLB_STATS (LK_DEBUGLEVEL > 1)
+#endif
+
+/* struct mips_tlb_stats offsets for the refill handler */
+#define MIPS_TLB_STATS_REFILL       0
+#define MIPS_TLB_STATS_REFILL_LARGE 4
+#define MIPS_TLB_STATS_FAULT        8
+
+#ifndef ASSEMBLY
+
+#include <stdint.h>
+
+/*
+ * Counted in the tlb exception handler, and in vectors.S if MIPS_TLB_STATS
+ * is set; wrap around.
+ */
+struct mips_tlb_stats {
+    uint32_t refill;        /* _tlb_refill of a PAGE_SIZE pair */
+    uint32_t refill_large;  /* _tlb_refill of a large page pair */
+    uint32_t fault;         /* tlb exceptions taken to C */
+    uint32_t reload;        /* stale entries rewritten by a tlb exception */
+    uint32_t preload;       /* next pairs loaded on sequential faults */
+    uint32_t cow;           /* copy-on-write pages copied on a store */
+};
+
+extern struct mips_tlb_stats mips_tlb_stats;
+
 void mips_invalidate_tlb_global(void);
 void mips_invalidate_tlb_asid(vaddr_t va, uint32_t asid);
 void mips_tlb_init(void);
+
+#endif // ASSEMBLY
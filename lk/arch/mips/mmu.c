@@ -25,7 +25,10 @@
 #include <assert.h>
 #include <err.h>
 #include <trace.h>
+#include <stdlib.h>
 #include <kernel/vm.h>
+#include <arch/mips.h>
+#include <arch/tlb.h>
 #include <arch/mips/mmu.h>
 
 #define LOCAL_TRACE 0
@@ -55,15 +58,101 @@ inline void *paddr_to_kvaddr(paddr_t pa)
 }
 #else /* WITH_KERNEL_VM */
 
-uint32_t mips_kernel_translation_table[256] __ALIGNED(PAGE_SIZE) __SECTION(".bss.prebss.translation_table");
+/* kseg2/kseg3 L1 table, entries point at MMU_KERNEL_L2_SIZE L2 tables */
+uint32_t mips_kernel_translation_table[MMU_KERNEL_L1_ENTRIES] __ALIGNED(PAGE_SIZE) __SECTION(".bss.prebss.translation_table");
+
+/* above this many pages a map/unmap flushes the whole tlb once */
+#define MMU_KERNEL_TLB_FLUSH_PAGES 32
 
 static inline bool is_valid_vaddr(arch_aspace_t *aspace, vaddr_t vaddr)
 {
     return (vaddr >= aspace->base && vaddr <= aspace->base + aspace->size - 1);
 }
 
+static inline bool is_kernel_mapped(vaddr_t vaddr)
+{
+    return vaddr >= MMU_KERNEL_BASE;
+}
+
+static uint32_t *kernel_pte(vaddr_t vaddr, bool alloc)
+{
+    uint idx = (vaddr - MMU_KERNEL_BASE) >> MMU_KERNEL_L1_SHIFT;
+    uint32_t *level_2 = (uint32_t *)mips_kernel_translation_table[idx];
+
+    if (!level_2 && alloc) {
+        level_2 = memalign(MMU_KERNEL_L2_SIZE, MMU_KERNEL_L2_SIZE);
+        if (!level_2)
+            return NULL;
+
+        for (uint i = 0; i < MMU_KERNEL_L2_ENTRIES; i++)
+            level_2[i] = MMU_KERNEL_PTE_EMPTY;
+
+        /* the refill handler may walk it as soon as it is installed */
+        SYNC;
+        mips_kernel_translation_table[idx] = (uint32_t)level_2;
+    }
+
+    if (!level_2)
+        return NULL;
+
+    return &level_2[(vaddr >> PAGE_SIZE_SHIFT) & (MMU_KERNEL_L2_ENTRIES - 1)];
+}
+
+static uint32_t arch_flags_to_pte(paddr_t paddr, uint flags)
+{
+    uint32_t pte = MMU_GLOBAL | MMU_VALID;
+
+    if ((flags & ARCH_MMU_FLAG_CACHE_MASK) == ARCH_MMU_FLAG_CACHED)
+        pte |= MMU_CACHED;
+    else
+        pte |= MMU_UNCACHED;
+
+    if (!(flags & ARCH_MMU_FLAG_PERM_RO))
+        pte |= MMU_DIRTY;
+
+    if (flags & ARCH_MMU_FLAG_PERM_NO_EXECUTE)
+        pte |= MMU_NO_EXEC;
+
+    /* same layout as the uthread ptes, see mips_uthread_mmu_map() */
+    return ((paddr >> SHIFT_4K) << MMU_FLAG_BITS) | pte;
+}
+
+static uint pte_to_arch_flags(uint32_t pte)
+{
+    uint flags = 0;
+
+    if ((pte & MMU_CACHE_MASK) != MMU_CACHED)
+        flags |= ARCH_MMU_FLAG_UNCACHED;
+
+    if (!(pte & MMU_DIRTY))
+        flags |= ARCH_MMU_FLAG_PERM_RO;
+
+    if (pte & MMU_NO_EXEC)
+        flags |= ARCH_MMU_FLAG_PERM_NO_EXECUTE;
+
+    return flags;
+}
+
+/* drop tlb entries for count pages at vaddr with a single flush */
+static void kernel_tlb_flush(vaddr_t vaddr, uint count)
+{
+    vaddr_t va;
+    vaddr_t end = vaddr + count * PAGE_SIZE;
+
+    if (count > MMU_KERNEL_TLB_FLUSH_PAGES) {
+        mips_invalidate_tlb_global();
+        return;
+    }
+
+    /* kernel entries are global, any asid matches */
+    for (va = ROUNDDOWN(vaddr, 2 * PAGE_SIZE); va < end; va += 2 * PAGE_SIZE)
+        mips_invalidate_tlb_asid(va, 0);
+}
+
 status_t arch_mmu_query(arch_aspace_t *aspace, vaddr_t vaddr, paddr_t *paddr, uint *flags)
 {
+    uint32_t *pte;
+
     LTRACEF("aspace %p, vaddr 0x%lx\n", aspace, vaddr);
 
     DEBUG_ASSERT(aspace);
@@ -73,7 +162,6 @@ status_t arch_mmu_query(arch_aspace_t *aspace, vaddr_t vaddr, paddr_t *paddr, ui
     if (!is_valid_vaddr(aspace, vaddr))
         return ERR_OUT_OF_RANGE;
 
-    /* TODO temporary... */
     if (is_kseg0(vaddr))
     {
         if (paddr)
@@ -92,18 +180,33 @@ status_t arch_mmu_query(arch_aspace_t *aspace, vaddr_t vaddr, paddr_t *paddr, ui
             *paddr = kseg1_to_phys(vaddr);
 
         if (flags) {
-            *flags = 0; // TODO
+            *flags = ARCH_MMU_FLAG_UNCACHED;
         }
 
         return NO_ERROR;
     }
 
-    /* TODO not implemented */
-    return ERR_OUT_OF_RANGE;
+    if (!is_kernel_mapped(vaddr))
+        return ERR_OUT_OF_RANGE;
+
+    pte = kernel_pte(vaddr, false);
+    if (!pte || !(*pte & MMU_VALID))
+        return ERR_NOT_FOUND;
+
+    if (paddr)
+        *paddr = ((*pte >> MMU_FLAG_BITS) << SHIFT_4K) | (vaddr & (PAGE_SIZE - 1));
+
+    if (flags)
+        *flags = pte_to_arch_flags(*pte);
+
+    return NO_ERROR;
 }
 
 int arch_mmu_map(arch_aspace_t *aspace, vaddr_t vaddr, paddr_t paddr, uint count, uint flags)
 {
+    uint32_t *pte;
+    uint mapped;
+
     LTRACEF("vaddr 0x%lx paddr 0x%lx count %u flags 0x%x\n", vaddr, paddr, count, flags);
 
     DEBUG_ASSERT(aspace);
@@ -122,12 +225,42 @@ int arch_mmu_map(arch_aspace_t *aspace, vaddr_t vaddr, paddr_t paddr, uint count
     if (count == 0)
         return NO_ERROR;
 
-    /* TODO not implemented */
-    return NO_ERROR;
+    /* kseg0/kseg1 are mapped by the hardware, only accept their own paddr */
+    if (!is_kernel_mapped(vaddr)) {
+        if (vaddr + count * PAGE_SIZE > MMU_KERNEL_BASE ||
+            (vaddr & LOW_512MB_MASK) != paddr)
+            return ERR_INVALID_ARGS;
+        return count;
+    }
+
+    if (vaddr + count * PAGE_SIZE - 1 < vaddr)
+        return ERR_INVALID_ARGS;
+
+    for (mapped = 0; mapped < count; mapped++) {
+        pte = kernel_pte(vaddr + mapped * PAGE_SIZE, true);
+        if (!pte)
+            break;
+        DEBUG_ASSERT(!(*pte & MMU_VALID));
+        *pte = arch_flags_to_pte(paddr + mapped * PAGE_SIZE, flags);
+    }
+
+    /* a pair loaded while half of it was unmapped is now stale */
+    SYNC;
+    kernel_tlb_flush(vaddr, mapped);
+
+    if (mapped < count) {
+        arch_mmu_unmap(aspace, vaddr, mapped);
+        return ERR_NO_MEMORY;
+    }
+
+    return count;
 }
 
 int arch_mmu_unmap(arch_aspace_t *aspace, vaddr_t vaddr, uint count)
 {
+    uint32_t *pte;
+    uint i;
+
     LTRACEF("vaddr 0x%lx count %u\n", vaddr, count);
 
     DEBUG_ASSERT(aspace);
@@ -144,8 +277,35 @@ int arch_mmu_unmap(arch_aspace_t *aspace, vaddr_t vaddr, uint count)
     if (count == 0)
         return NO_ERROR;
 
-    /* TODO not implemented */
-    return NO_ERROR;
+    if (!is_kernel_mapped(vaddr))
+        return count;
+
+    for (i = 0; i < count; i++) {
+        pte = kernel_pte(vaddr + i * PAGE_SIZE, false);
+        if (pte)
+            *pte = MMU_KERNEL_PTE_EMPTY;
+    }
+
+    SYNC;
+    kernel_tlb_flush(vaddr, count);
+
+    return count;
+}
+
+/*
+ * Dynamic mappings only work in the tlb mapped kseg2/kseg3, keep the vmm
+ * from handing out the unused parts of kseg0/kseg1.
+ */
+vaddr_t arch_mmu_pick_spot(arch_aspace_t *aspace, vaddr_t base, uint prev_region_arch_mmu_flags,
+                           vaddr_t end,  uint next_region_arch_mmu_flags,
+                           vaddr_t align, size_t size, uint arch_mmu_flags)
+{
+    vaddr_t spot = ALIGN(MAX(base, MMU_KERNEL_BASE), align);
+
+    if (spot < base || spot > end || end - spot + 1 < size)
+        return end; /* wrapped around or it does not fit */
+
+    return spot;
 }
 
 /*
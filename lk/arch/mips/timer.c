@@ -138,6 +138,12 @@ lk_bigtime_t current_time_hires(void)
     return res;
 }
 
+/* count register increments per usec */
+uint32_t mips_timer_rate_mhz(void)
+{
+    return tick_rate_mhz;
+}
+
 void mips_init_timer(uint32_t freq)
 {
     tick_rate = freq;
@@ -26,6 +26,9 @@
 #include <mips/m32c0.h>
 #include <arch/mips.h>
 #include <arch/defines.h>
+#include <arch/tlb.h>
+
+struct mips_tlb_stats mips_tlb_stats;
 
 void mips_invalidate_tlb_global(void)
 {
@@ -92,3 +95,31 @@ void mips_tlb_init(void)
     }
 #endif /* WITH_KERNEL_VM */
 }
+
+#if WITH_LIB_CONSOLE
+#include <lib/console.h>
+#include <stdio.h>
+#include <string.h>
+
+static int cmd_tlb(int argc, const cmd_args *argv)
+{
+    if (argc > 1 && !strcmp(argv[1].str, "reset")) {
+        memset(&mips_tlb_stats, 0, sizeof(mips_tlb_stats));
+        return 0;
+    }
+
+    printf("tlb refill %u refill_large %u fault %u reload %u preload %u "
+           "cow %u\n",
+           mips_tlb_stats.refill, mips_tlb_stats.refill_large,
+           mips_tlb_stats.fault, mips_tlb_stats.reload,
+           mips_tlb_stats.preload, mips_tlb_stats.cow);
+#if !MIPS_TLB_STATS
+    printf("refills are not counted, build with MIPS_TLB_STATS=1\n");
+#endif
+    return 0;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("tlb", "tlb miss counters [reset]", &cmd_tlb)
+STATIC_COMMAND_END(mips_tlb);
+#endif
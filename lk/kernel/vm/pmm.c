@@ -30,14 +30,35 @@
 #include <err.h>
 #include <string.h>
 #include <pow2.h>
+#include <platform.h>
 #include <lib/console.h>
 #include <kernel/mutex.h>
+#include <kernel/spinlock.h>
 
 #define LOCAL_TRACE 0
 
 static struct list_node arena_list = LIST_INITIAL_VALUE(arena_list);
 static mutex_t lock = MUTEX_INITIAL_VALUE(lock);
 
+/*
+ * Free pages live in per arena buddy lists. A free block of 2^order pages
+ * starts at a page index that is a multiple of 2^order; its first page is
+ * marked VM_PAGE_FLAG_BUDDY and sits on free_list[order], the rest of the
+ * block is untouched.
+ *
+ * Single pages are also cached per cpu so the common one page alloc and
+ * free skip the arena lock. Cached pages count as allocated, the caches
+ * are drained back into the arenas when a contiguous allocation fails.
+ */
+#define PCP_BATCH 8
+#define PCP_HIGH 32
+
+static struct pmm_pcp {
+    spin_lock_t lock;
+    uint count;
+    struct list_node list;
+} pcp[SMP_MAX_CPUS];
+
 #define PAGE_BELONGS_TO_ARENA(page, arena) \
     (((uintptr_t)(page) >= (uintptr_t)(arena)->page_array) && \
      ((uintptr_t)(page) < ((uintptr_t)(arena)->page_array + (arena)->size / PAGE_SIZE * sizeof(vm_page_t))))
@@ -76,6 +97,171 @@ vm_page_t *paddr_to_vm_page(paddr_t addr)
     return NULL;
 }
 
+static pmm_arena_t *page_to_arena(const vm_page_t *page)
+{
+    pmm_arena_t *a;
+    list_for_every_entry(&arena_list, a, pmm_arena_t, node) {
+        if (PAGE_BELONGS_TO_ARENA(page, a))
+            return a;
+    }
+    return NULL;
+}
+
+static void buddy_add(pmm_arena_t *a, size_t index, uint order)
+{
+    vm_page_t *p = &a->page_array[index];
+
+    DEBUG_ASSERT(order <= PMM_MAX_ORDER);
+    DEBUG_ASSERT((index & ((1UL << order) - 1)) == 0);
+
+    p->flags = VM_PAGE_FLAG_BUDDY;
+    p->order = order;
+    list_add_head(&a->free_list[order], &p->node);
+    a->free_count += 1UL << order;
+}
+
+static void buddy_del(pmm_arena_t *a, vm_page_t *p)
+{
+    DEBUG_ASSERT(p->flags & VM_PAGE_FLAG_BUDDY);
+
+    list_delete(&p->node);
+    p->flags &= ~VM_PAGE_FLAG_BUDDY;
+    a->free_count -= 1UL << p->order;
+}
+
+/* free the page range [start, end) as the largest aligned blocks that fit */
+static void buddy_add_range(pmm_arena_t *a, size_t start, size_t end)
+{
+    while (start < end) {
+        uint order = 0;
+
+        while (order < PMM_MAX_ORDER &&
+                (start & (1UL << order)) == 0 &&
+                start + (2UL << order) <= end)
+            order++;
+
+        buddy_add(a, start, order);
+        start += 1UL << order;
+    }
+}
+
+/* free one page, merging it with its buddies as far as possible */
+static void buddy_free(pmm_arena_t *a, size_t index)
+{
+    size_t page_count = a->size / PAGE_SIZE;
+    uint order = 0;
+
+    DEBUG_ASSERT(a->page_array[index].flags & VM_PAGE_FLAG_NONFREE);
+    a->page_array[index].flags &= ~VM_PAGE_FLAG_NONFREE;
+
+    while (order < PMM_MAX_ORDER) {
+        size_t buddy = index ^ (1UL << order);
+        if (buddy >= page_count)
+            break;
+
+        vm_page_t *b = &a->page_array[buddy];
+        if (!(b->flags & VM_PAGE_FLAG_BUDDY) || b->order != order)
+            break;
+
+        buddy_del(a, b);
+        index &= ~(1UL << order);
+        order++;
+    }
+
+    buddy_add(a, index, order);
+}
+
+/* take a free block of 2^order pages, splitting a larger one if needed */
+static vm_page_t *buddy_alloc(pmm_arena_t *a, uint order)
+{
+    for (uint o = order; o <= PMM_MAX_ORDER; o++) {
+        vm_page_t *p = list_peek_head_type(&a->free_list[o], vm_page_t, node);
+        if (!p)
+            continue;
+
+        buddy_del(a, p);
+
+        /* hand the upper halves back */
+        size_t index = p - a->page_array;
+        while (o > order) {
+            o--;
+            buddy_add(a, index + (1UL << o), o);
+        }
+        return p;
+    }
+    return NULL;
+}
+
+/* pull a specific free page out of the free block that holds it */
+static bool buddy_take(pmm_arena_t *a, size_t index)
+{
+    if (!page_is_free(&a->page_array[index]))
+        return false;
+
+    for (uint o = 0; o <= PMM_MAX_ORDER; o++) {
+        size_t head = index & ~((1UL << o) - 1);
+        vm_page_t *h = &a->page_array[head];
+
+        if (!(h->flags & VM_PAGE_FLAG_BUDDY) || h->order != o)
+            continue;
+
+        buddy_del(a, h);
+
+        /* split down to the page, freeing the halves that don't hold it */
+        while (o > 0) {
+            o--;
+            size_t half = head + (1UL << o);
+            if (index >= half) {
+                buddy_add(a, head, o);
+                head = half;
+            } else {
+                buddy_add(a, half, o);
+            }
+        }
+        return true;
+    }
+
+    panic("pmm: free page %zu in arena %p not in any block\n", index, a);
+}
+
+static void alloc_run(pmm_arena_t *a, size_t index, uint count, struct list_node *list)
+{
+    for (size_t i = index; i < index + count; i++) {
+        vm_page_t *p = &a->page_array[i];
+
+        p->flags |= VM_PAGE_FLAG_NONFREE;
+        if (list)
+            list_add_tail(list, &p->node);
+    }
+}
+
+/* move every cached page back into the buddy lists, called with lock held */
+static uint pcp_drain_locked(void)
+{
+    struct list_node list = LIST_INITIAL_VALUE(list);
+    spin_lock_saved_state_t state;
+    uint count = 0;
+
+    for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+        struct list_node *node;
+
+        spin_lock_save(&pcp[i].lock, &state, SPIN_LOCK_FLAG_INTERRUPTS);
+        while ((node = list_remove_head(&pcp[i].list)))
+            list_add_tail(&list, node);
+        count += pcp[i].count;
+        pcp[i].count = 0;
+        spin_unlock_restore(&pcp[i].lock, state, SPIN_LOCK_FLAG_INTERRUPTS);
+    }
+
+    vm_page_t *page;
+    while ((page = list_remove_head_type(&list, vm_page_t, node))) {
+        pmm_arena_t *a = page_to_arena(page);
+        buddy_free(a, page - a->page_array);
+    }
+
+    return count;
+}
+
 status_t pmm_add_arena(pmm_arena_t *arena)
 {
     LTRACEF("arena %p name '%s' base 0x%lx size 0x%zx\n", arena, arena->name, arena->base, arena->size);
@@ -84,6 +270,14 @@ status_t pmm_add_arena(pmm_arena_t *arena)
     DEBUG_ASSERT(IS_PAGE_ALIGNED(arena->size));
     DEBUG_ASSERT(arena->size > 0);
 
+    /* the first arena is added before anything can allocate */
+    if (list_is_empty(&arena_list)) {
+        for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+            spin_lock_init(&pcp[i].lock);
+            list_initialize(&pcp[i].list);
+        }
+    }
+
     /* walk the arena list and add arena based on priority order */
     pmm_arena_t *a;
     list_for_every_entry(&arena_list, a, pmm_arena_t, node) {
@@ -100,7 +294,8 @@ done_add:
 
     /* zero out some of the structure */
     arena->free_count = 0;
-    list_initialize(&arena->free_list);
+    for (uint i = 0; i <= PMM_MAX_ORDER; i++)
+        list_initialize(&arena->free_list[i]);
 
     /* allocate an array of pages to back this one */
     size_t page_count = arena->size / PAGE_SIZE;
@@ -109,14 +304,8 @@ done_add:
     /* initialize all of the pages */
     memset(arena->page_array, 0, page_count * sizeof(vm_page_t));
 
-    /* add them to the free list */
-    for (size_t i = 0; i < page_count; i++) {
-        vm_page_t *p = &arena->page_array[i];
-
-        list_add_tail(&arena->free_list, &p->node);
-
-        arena->free_count++;
-    }
+    /* add them to the free lists */
+    buddy_add_range(arena, 0, page_count);
 
     return NO_ERROR;
 }
@@ -132,27 +321,63 @@ size_t pmm_alloc_pages(uint count, struct list_node *list)
     if (count == 0)
         return 0;
 
+    /* try the local page cache first */
+    struct pmm_pcp *c = &pcp[arch_curr_cpu_num()];
+    spin_lock_saved_state_t state;
+
+    spin_lock_save(&c->lock, &state, SPIN_LOCK_FLAG_INTERRUPTS);
+    while (allocated < count && c->count) {
+        list_add_tail(list, list_remove_head(&c->list));
+        c->count--;
+        allocated++;
+    }
+    spin_unlock_restore(&c->lock, state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (allocated == count)
+        return allocated;
+
+    /* small requests refill the cache while we hold the lock anyway */
+    struct list_node refill = LIST_INITIAL_VALUE(refill);
+    uint want = count - allocated;
+    if (want < PCP_BATCH)
+        want += PCP_BATCH;
+
+    uint got = 0, cached = 0;
+
     mutex_acquire(&lock);
 
     /* walk the arenas in order, allocating as many pages as we can from each */
     pmm_arena_t *a;
     list_for_every_entry(&arena_list, a, pmm_arena_t, node) {
-        while (allocated < count) {
-            vm_page_t *page = list_remove_head_type(&a->free_list, vm_page_t, node);
+        while (got < want) {
+            vm_page_t *page = buddy_alloc(a, 0);
             if (!page)
-                goto done;
-
-            a->free_count--;
+                break;
 
             page->flags |= VM_PAGE_FLAG_NONFREE;
-            list_add_tail(list, &page->node);
-
-            allocated++;
+            if (allocated < count) {
+                list_add_tail(list, &page->node);
+                allocated++;
+            } else {
+                list_add_tail(&refill, &page->node);
+                cached++;
+            }
+            got++;
         }
     }
 
-done:
     mutex_release(&lock);
+
+    if (cached) {
+        struct list_node *node;
+
+        spin_lock_save(&c->lock, &state, SPIN_LOCK_FLAG_INTERRUPTS);
+        while ((node = list_remove_head(&refill)))
+            list_add_tail(&c->list, node);
+        c->count += cached;
+        spin_unlock_restore(&c->lock, state, SPIN_LOCK_FLAG_INTERRUPTS);
+    }
+
     return allocated;
 }
 
@@ -170,6 +395,9 @@ size_t pmm_alloc_range(paddr_t address, uint count, struct list_node *list)
 
     mutex_acquire(&lock);
 
+    /* cached pages may sit in the range */
+    pcp_drain_locked();
+
     /* walk through the arenas, looking to see if the physical page belongs to it */
     pmm_arena_t *a;
     list_for_every_entry(&arena_list, a, pmm_arena_t, node) {
@@ -178,19 +406,13 @@ size_t pmm_alloc_range(paddr_t address, uint count, struct list_node *list)
 
             DEBUG_ASSERT(index < a->size / PAGE_SIZE);
 
-            vm_page_t *page = &a->page_array[index];
-            if (page->flags & VM_PAGE_FLAG_NONFREE) {
+            if (!buddy_take(a, index)) {
                 /* we hit an allocated page */
                 break;
             }
 
-            DEBUG_ASSERT(list_in_list(&page->node));
-
-            list_delete(&page->node);
-            page->flags |= VM_PAGE_FLAG_NONFREE;
-            list_add_tail(list, &page->node);
+            alloc_run(a, index, 1, list);
 
-            a->free_count--;
             allocated++;
             address += PAGE_SIZE;
         }
@@ -209,9 +431,32 @@ size_t pmm_free(struct list_node *list)
 
     DEBUG_ASSERT(list);
 
+    uint count = 0;
+
+    /* top up the local page cache first */
+    struct pmm_pcp *c = &pcp[arch_curr_cpu_num()];
+    spin_lock_saved_state_t state;
+
+    spin_lock_save(&c->lock, &state, SPIN_LOCK_FLAG_INTERRUPTS);
+    while (c->count < PCP_HIGH && !list_is_empty(list)) {
+        vm_page_t *page = list_peek_head_type(list, vm_page_t, node);
+
+        DEBUG_ASSERT(page->flags & VM_PAGE_FLAG_NONFREE);
+        if (!page_to_arena(page))
+            break;
+
+        list_delete(&page->node);
+        list_add_head(&c->list, &page->node);
+        c->count++;
+        count++;
+    }
+    spin_unlock_restore(&c->lock, state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (list_is_empty(list))
+        return count;
+
     mutex_acquire(&lock);
 
-    uint count = 0;
     while (!list_is_empty(list)) {
         vm_page_t *page = list_remove_head_type(list, vm_page_t, node);
 
@@ -219,16 +464,10 @@ size_t pmm_free(struct list_node *list)
         DEBUG_ASSERT(page->flags & VM_PAGE_FLAG_NONFREE);
 
         /* see which arena this page belongs to and add it */
-        pmm_arena_t *a;
-        list_for_every_entry(&arena_list, a, pmm_arena_t, node) {
-            if (PAGE_BELONGS_TO_ARENA(page, a)) {
-                page->flags &= ~VM_PAGE_FLAG_NONFREE;
-
-                list_add_head(&a->free_list, &page->node);
-                a->free_count++;
-                count++;
-                break;
-            }
+        pmm_arena_t *a = page_to_arena(page);
+        if (a) {
+            buddy_free(a, page - a->page_array);
+            count++;
         }
     }
 
@@ -284,6 +523,71 @@ size_t pmm_free_kpages(void *_ptr, uint count)
     return pmm_free(&list);
 }
 
+/*
+ * find count free pages in arena a starting on an alignment boundary and pull
+ * them out of the free lists. returns the index of the first page or -1.
+ */
+static ssize_t arena_alloc_contiguous(pmm_arena_t *a, uint count, uint8_t alignment_log2)
+{
+    size_t page_count = a->size / PAGE_SIZE;
+    uint order = MAX(log2_uint(round_up_pow2_u32(count)), alignment_log2 - PAGE_SIZE_SHIFT);
+
+    if (count > page_count)
+        return -1;
+
+    /* blocks are aligned relative to the arena base, which is enough if the base is aligned */
+    if (order <= PMM_MAX_ORDER && IS_ALIGNED(a->base, 1UL << alignment_log2)) {
+        vm_page_t *p = buddy_alloc(a, order);
+        if (p) {
+            size_t index = p - a->page_array;
+
+            /* give back the tail of the block */
+            buddy_add_range(a, index + count, index + (1UL << order));
+            return index;
+        }
+    }
+
+    /* no single block will do, look for a run spanning several.
+     * walk the list starting at alignment boundaries.
+     * calculate the starting offset into this arena, based on the
+     * base address of the arena to handle the case where the arena
+     * is not aligned on the same boundary requested.
+     */
+    paddr_t rounded_base = ROUNDUP(a->base, 1UL << alignment_log2);
+    if (rounded_base < a->base || rounded_base > a->base + a->size - 1)
+        return -1;
+
+    uint aligned_offset = (rounded_base - a->base) / PAGE_SIZE;
+    uint start = aligned_offset;
+    LTRACEF("starting search at aligned offset %u\n", start);
+    LTRACEF("arena base 0x%lx size %zu\n", a->base, a->size);
+
+retry:
+    /* search while we're still within the arena and have a chance of finding a slot
+       (start + count < end of arena) */
+    while ((start < page_count) && ((start + count) <= page_count)) {
+        vm_page_t *p = &a->page_array[start];
+        for (uint i = 0; i < count; i++) {
+            if (!page_is_free(p)) {
+                /* this run is broken, break out of the inner loop.
+                 * start over at the next alignment boundary
+                 */
+                start = ROUNDUP(start - aligned_offset + i + 1, 1UL << (alignment_log2 - PAGE_SIZE_SHIFT)) + aligned_offset;
+                goto retry;
+            }
+            p++;
+        }
+
+        /* we found a run, carve it out of the blocks it spans */
+        for (uint i = start; i < start + count; i++)
+            buddy_take(a, i);
+
+        return start;
+    }
+
+    return -1;
+}
+
 size_t pmm_alloc_contiguous(uint count, uint8_t alignment_log2, paddr_t *pa, struct list_node *list)
 {
     LTRACEF("count %u, align %u\n", count, alignment_log2);
@@ -293,70 +597,39 @@ size_t pmm_alloc_contiguous(uint count, uint8_t alignment_log2, paddr_t *pa, str
     if (alignment_log2 < PAGE_SIZE_SHIFT)
         alignment_log2 = PAGE_SIZE_SHIFT;
 
+    bool drained = false;
+    pmm_arena_t *a;
+
     mutex_acquire(&lock);
 
-    pmm_arena_t *a;
+retry:
     list_for_every_entry(&arena_list, a, pmm_arena_t, node) {
         // XXX make this a flag to only search kmap?
         if (a->flags & PMM_ARENA_FLAG_KMAP) {
-            /* walk the list starting at alignment boundaries.
-             * calculate the starting offset into this arena, based on the
-             * base address of the arena to handle the case where the arena
-             * is not aligned on the same boundary requested.
-             */
-            paddr_t rounded_base = ROUNDUP(a->base, 1UL << alignment_log2);
-            if (rounded_base < a->base || rounded_base > a->base + a->size - 1)
+            ssize_t start = arena_alloc_contiguous(a, count, alignment_log2);
+            if (start < 0)
                 continue;
 
-            uint aligned_offset = (rounded_base - a->base) / PAGE_SIZE;
-            uint start = aligned_offset;
-            LTRACEF("starting search at aligned offset %u\n", start);
-            LTRACEF("arena base 0x%lx size %zu\n", a->base, a->size);
+            LTRACEF("found run from pn %u to %u\n", (uint)start, (uint)start + count);
 
-retry:
-            /* search while we're still within the arena and have a chance of finding a slot
-               (start + count < end of arena) */
-            while ((start < a->size / PAGE_SIZE) &&
-                    ((start + count) <= a->size / PAGE_SIZE)) {
-                vm_page_t *p = &a->page_array[start];
-                for (uint i = 0; i < count; i++) {
-                    if (p->flags & VM_PAGE_FLAG_NONFREE) {
-                        /* this run is broken, break out of the inner loop.
-                         * start over at the next alignment boundary
-                         */
-                        start = ROUNDUP(start - aligned_offset + i + 1, 1UL << (alignment_log2 - PAGE_SIZE_SHIFT)) + aligned_offset;
-                        goto retry;
-                    }
-                    p++;
-                }
-
-                /* we found a run */
-                LTRACEF("found run from pn %u to %u\n", start, start + count);
-
-                /* remove the pages from the run out of the free list */
-                for (uint i = start; i < start + count; i++) {
-                    p = &a->page_array[i];
-                    DEBUG_ASSERT(!(p->flags & VM_PAGE_FLAG_NONFREE));
-                    DEBUG_ASSERT(list_in_list(&p->node));
-
-                    list_delete(&p->node);
-                    p->flags |= VM_PAGE_FLAG_NONFREE;
-                    a->free_count--;
-
-                    if (list)
-                        list_add_tail(list, &p->node);
-                }
-
-                if (pa)
-                    *pa = a->base + start * PAGE_SIZE;
-
-                mutex_release(&lock);
-
-                return count;
-            }
+            alloc_run(a, start, count, list);
+
+            if (pa)
+                *pa = a->base + start * PAGE_SIZE;
+
+            mutex_release(&lock);
+
+            return count;
         }
     }
 
+    /* cached single pages may be splitting a run, put them back and try again */
+    if (!drained) {
+        drained = true;
+        if (pcp_drain_locked())
+            goto retry;
+    }
+
     mutex_release(&lock);
 
     LTRACEF("couldn't find run\n");
@@ -368,12 +641,29 @@ static void dump_page(const vm_page_t *page)
     printf("page %p: address 0x%lx flags 0x%x\n", page, vm_page_to_paddr(page), page->flags);
 }
 
-static void dump_arena(const pmm_arena_t *arena, bool dump_pages)
+/* free block counts by order; free pages outside the largest block are fragmented */
+static void dump_free_blocks(pmm_arena_t *arena)
+{
+    size_t largest = 0;
+
+    printf("\tfree blocks by order:");
+    for (uint i = 0; i <= PMM_MAX_ORDER; i++) {
+        size_t n = list_length(&arena->free_list[i]);
+        if (n)
+            largest = 1UL << i;
+        printf(" %zu", n);
+    }
+    printf("\n\tlargest free block %zu pages, %zu of %zu free pages outside it\n",
+           largest, arena->free_count - largest, arena->free_count);
+}
+
+static void dump_arena(pmm_arena_t *arena, bool dump_pages)
 {
     printf("arena %p: name '%s' base 0x%lx size 0x%zx priority %u flags 0x%x\n",
            arena, arena->name, arena->base, arena->size, arena->priority, arena->flags);
     printf("\tpage_array %p, free_count %zu\n",
            arena->page_array, arena->free_count);
+    dump_free_blocks(arena);
 
     /* dump all of the pages */
     if (dump_pages) {
@@ -403,6 +693,59 @@ static void dump_arena(const pmm_arena_t *arena, bool dump_pages)
     }
 }
 
+#define CHURN_SLOTS 64
+
+/* random alloc/free churn, reports latency and how fragmented the arenas end up */
+static void pmm_churn(uint iterations, uint max_pages)
+{
+    static struct list_node slot[CHURN_SLOTS];
+    lk_bigtime_t t, alloc_time = 0, free_time = 0;
+    uint allocs = 0, frees = 0, failed = 0;
+    pmm_arena_t *a;
+
+    for (uint i = 0; i < CHURN_SLOTS; i++)
+        list_initialize(&slot[i]);
+
+    for (uint i = 0; i < iterations; i++) {
+        struct list_node *list = &slot[rand() % CHURN_SLOTS];
+
+        if (!list_is_empty(list)) {
+            t = current_time_hires();
+            pmm_free(list);
+            free_time += current_time_hires() - t;
+            frees++;
+            continue;
+        }
+
+        /* mostly single pages, with contiguous runs mixed in */
+        uint count = (rand() % 4) ? 1 : 1 + rand() % max_pages;
+        size_t ret;
+
+        t = current_time_hires();
+        if (count > 1 && (rand() & 1))
+            ret = pmm_alloc_contiguous(count, PAGE_SIZE_SHIFT, NULL, list);
+        else
+            ret = pmm_alloc_pages(count, list);
+        alloc_time += current_time_hires() - t;
+
+        allocs++;
+        if (ret < count)
+            failed++;
+    }
+
+    printf("%u allocs (%u short), %u frees\n", allocs, failed, frees);
+    printf("avg alloc %llu us, avg free %llu us\n",
+           allocs ? alloc_time / allocs : 0, frees ? free_time / frees : 0);
+
+    list_for_every_entry(&arena_list, a, pmm_arena_t, node) {
+        printf("arena '%s':\n", a->name);
+        dump_free_blocks(a);
+    }
+
+    for (uint i = 0; i < CHURN_SLOTS; i++)
+        pmm_free(&slot[i]);
+}
+
 static int cmd_pmm(int argc, const cmd_args *argv)
 {
     if (argc < 2) {
@@ -417,6 +760,7 @@ usage:
         printf("%s alloc_contig <count> <alignment>\n", argv[0].str);
         printf("%s dump_alloced\n", argv[0].str);
         printf("%s free_alloced\n", argv[0].str);
+        printf("%s churn <iterations> <max pages>\n", argv[0].str);
         return ERR_GENERIC;
     }
 
@@ -495,6 +839,10 @@ usage:
     } else if (!strcmp(argv[1].str, "free_alloced")) {
         size_t err = pmm_free(&allocated);
         printf("pmm_free returns %zu\n", err);
+    } else if (!strcmp(argv[1].str, "churn")) {
+        if (argc < 4) goto notenoughargs;
+
+        pmm_churn(argv[2].u, MAX(argv[3].u, 1));
     } else {
         printf("unknown command\n");
         goto usage;
@@ -96,6 +96,31 @@ static inline void *HEAP_CALLOC(size_t n, size_t s)
 }
 
 /* end cmpctmalloc implementation */
+#elif WITH_LIB_HEAP_SLABHEAP
+/* slabheap implementation */
+#include <lib/slabheap.h>
+
+static inline void *HEAP_MALLOC(size_t s) { return slabheap_alloc(s, 0); }
+static inline void *HEAP_REALLOC(void *ptr, size_t s) { return slabheap_realloc(ptr, s); }
+static inline void *HEAP_MEMALIGN(size_t boundary, size_t s) { return slabheap_alloc(s, boundary); }
+#define HEAP_FREE slabheap_free
+static inline void *HEAP_CALLOC(size_t n, size_t s)
+{
+    size_t realsize = n * s;
+
+    if (s && realsize / s != n)
+        return NULL;
+
+    void *ptr = slabheap_alloc(realsize, 0);
+    if (likely(ptr))
+        memset(ptr, 0, realsize);
+    return ptr;
+}
+#define HEAP_INIT slabheap_init
+#define HEAP_DUMP slabheap_dump
+#define HEAP_TRIM slabheap_trim
+
+/* end slabheap implementation */
 #elif WITH_LIB_HEAP_DLMALLOC
 /* dlmalloc implementation */
 #include <lib/dlmalloc.h>
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2015 Travis Geiselbrecht
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list.h>
+#include <sys/types.h>
+#include <compiler.h>
+#include <kernel/mutex.h>
+#include <kernel/spinlock.h>
+
+__BEGIN_CDECLS;
+
+/*
+ * Object caches for fixed size kernel objects.
+ *
+ * Objects are carved out of slabs of one page, or of up to SLAB_MAX_PAGES
+ * pages for objects too big to fit 8 to a page. Each cpu keeps a small
+ * magazine of free objects per cache so most allocs and frees only take a
+ * per cpu spinlock; the slab lists behind them are refilled and flushed in
+ * batches under the cache mutex. The optional constructor runs once when a
+ * slab is populated, so objects must be freed in their constructed state.
+ *
+ * Caches are usually defined statically:
+ *
+ *   static slab_cache_t foo_cache =
+ *       SLAB_CACHE_INITIAL_VALUE(foo_cache, "foo", sizeof(struct foo), NULL);
+ *
+ * Objects too large for the biggest slab are passed through to the heap.
+ */
+#define SLAB_MAGAZINE_SIZE 16
+
+/* pages in the biggest slab, a power of two */
+#define SLAB_MAX_PAGES 8
+
+/* objects this big or bigger go to the heap, a slab holds at least 8 */
+#define SLAB_MAX_SIZE (SLAB_MAX_PAGES * PAGE_SIZE / 8)
+
+struct slab_magazine {
+    spin_lock_t lock;
+    uint count;
+    void *objs[SLAB_MAGAZINE_SIZE];
+
+    /* stats, summed over the cpus by the slab console command */
+    ulong allocs;
+    ulong frees;
+    ulong hits; /* allocs served straight from the magazine */
+};
+
+typedef struct slab_cache {
+    struct list_node node; /* on the list of all caches once in use */
+    const char *name;
+    size_t size;
+    void (*ctor)(void *obj);
+
+    mutex_t lock;
+    struct list_node partial; /* slabs with free objects */
+    uint slab_pages;
+    uint objs_per_slab;
+    uint slabs;
+    uint empty_slabs;
+
+    struct slab_magazine mag[SMP_MAX_CPUS];
+} slab_cache_t;
+
+#define SLAB_CACHE_INITIAL_VALUE(c, _name, _size, _ctor) \
+{ \
+    .node = { 0, 0 }, \
+    .name = (_name), \
+    .size = (_size), \
+    .ctor = (_ctor), \
+    .lock = MUTEX_INITIAL_VALUE((c).lock), \
+    .partial = LIST_INITIAL_VALUE((c).partial), \
+}
+
+void *slab_alloc(slab_cache_t *cache) __MALLOC;
+void slab_free(slab_cache_t *cache, void *obj);
+
+/* give the pages of completely free slabs back to the page allocator */
+void slab_cache_trim(slab_cache_t *cache);
+
+__END_CDECLS;
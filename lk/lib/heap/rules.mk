@@ -6,7 +6,8 @@ MODULE := $(LOCAL_DIR)
 
 MODULE_SRCS += \
 	$(LOCAL_DIR)/heap_wrapper.c \
-	$(LOCAL_DIR)/page_alloc.c
+	$(LOCAL_DIR)/page_alloc.c \
+	$(LOCAL_DIR)/slab.c
 
 ifeq ($(WITH_CPP_SUPPORT),true)
 MODULE_SRCS += \
@@ -26,6 +27,9 @@ endif
 ifeq ($(LK_HEAP_IMPLEMENTATION),cmpctmalloc)
 MODULE_DEPS := lib/heap/cmpctmalloc
 endif
+ifeq ($(LK_HEAP_IMPLEMENTATION),slabheap)
+MODULE_DEPS := lib/heap/slabheap
+endif
 
 GLOBAL_DEFINES += LK_HEAP_IMPLEMENTATION=$(LK_HEAP_IMPLEMENTATION)
 
@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2015 Travis Geiselbrecht
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <lib/slab.h>
+
+#include <debug.h>
+#include <assert.h>
+#include <trace.h>
+#include <string.h>
+#include <stdlib.h>
+#include <lib/heap.h>
+#include <lib/page_alloc.h>
+#include <arch/ops.h>
+#if WITH_KERNEL_VM
+#include <kernel/vm.h>
+#else
+#include <kernel/novm.h>
+#endif
+
+#define LOCAL_TRACE 0
+
+/* objects come out of the slab aligned like malloc would align them */
+#define SLAB_ALIGN 8
+
+/*
+ * A slab is one or more pages, aligned to its size: this header, a stack of
+ * free object indices, then the objects. Keeping the free list out of the
+ * objects leaves constructed state alone.
+ */
+struct slab {
+    struct list_node node;
+    slab_cache_t *cache;
+    uint16_t nfree;
+    uint16_t free[];
+};
+
+static struct list_node cache_list = LIST_INITIAL_VALUE(cache_list);
+static mutex_t cache_list_lock = MUTEX_INITIAL_VALUE(cache_list_lock);
+
+static inline size_t slab_obj_size(const slab_cache_t *cache)
+{
+    return ROUNDUP(MAX(cache->size, sizeof(void *)), SLAB_ALIGN);
+}
+
+static inline uint8_t *slab_objs(const slab_cache_t *cache, struct slab *s)
+{
+    return (uint8_t *)s + ROUNDUP(sizeof(struct slab) +
+                                  cache->objs_per_slab * sizeof(s->free[0]), SLAB_ALIGN);
+}
+
+static inline struct slab *obj_to_slab(const slab_cache_t *cache, void *obj)
+{
+    return (struct slab *)ROUNDDOWN((uintptr_t)obj, cache->slab_pages * PAGE_SIZE);
+}
+
+/* objects of the given size that fit a slab of the given pages */
+static uint slab_objs_fit(size_t size, uint pages)
+{
+    size_t slab_size = pages * PAGE_SIZE;
+    uint n = (slab_size - sizeof(struct slab)) / (size + sizeof(uint16_t));
+
+    while (ROUNDUP(sizeof(struct slab) + n * sizeof(uint16_t), SLAB_ALIGN) + n * size > slab_size)
+        n--;
+
+    return n;
+}
+
+/* first use of a cache, called with the cache lock held */
+static void slab_cache_setup(slab_cache_t *cache)
+{
+    size_t size = slab_obj_size(cache);
+    uint pages = 1;
+    uint n;
+
+    while ((n = slab_objs_fit(size, pages)) < 8 && pages < SLAB_MAX_PAGES)
+        pages *= 2;
+
+    DEBUG_ASSERT(n >= 8);
+    cache->slab_pages = pages;
+    cache->objs_per_slab = n;
+
+    mutex_acquire(&cache_list_lock);
+    list_add_tail(&cache_list, &cache->node);
+    mutex_release(&cache_list_lock);
+
+    LTRACEF("cache '%s' size %zu, %u objects per %u page slab\n", cache->name,
+            size, n, pages);
+}
+
+/* pages for a slab, aligned to their size so obj_to_slab() finds the header */
+static void *slab_pages_alloc(uint pages)
+{
+    if (pages == 1)
+        return page_alloc(1, PAGE_ALLOC_ANY_ARENA);
+
+#if WITH_KERNEL_VM
+    paddr_t pa;
+
+    if (!pmm_alloc_contiguous(pages, PAGE_SIZE_SHIFT + __builtin_ctz(pages), &pa, NULL))
+        return NULL;
+
+    return paddr_to_kvaddr(pa);
+#else
+    /* take twice the pages and give back what is outside the aligned run */
+    uint8_t *base = page_alloc(2 * pages, PAGE_ALLOC_ANY_ARENA);
+    uint8_t *slab;
+    size_t head;
+
+    if (!base)
+        return NULL;
+
+    slab = (uint8_t *)ROUNDUP((uintptr_t)base, pages * PAGE_SIZE);
+    head = (slab - base) / PAGE_SIZE;
+    if (head)
+        page_free(base, head);
+    page_free(slab + pages * PAGE_SIZE, pages - head);
+
+    return slab;
+#endif
+}
+
+static struct slab *slab_grow(slab_cache_t *cache)
+{
+    struct slab *s = slab_pages_alloc(cache->slab_pages);
+    if (!s)
+        return NULL;
+
+    s->cache = cache;
+    s->nfree = cache->objs_per_slab;
+
+    uint8_t *obj = slab_objs(cache, s);
+    for (uint i = 0; i < cache->objs_per_slab; i++) {
+        s->free[i] = cache->objs_per_slab - 1 - i;
+        if (cache->ctor)
+            cache->ctor(obj + i * slab_obj_size(cache));
+    }
+
+    list_add_head(&cache->partial, &s->node);
+    cache->slabs++;
+    cache->empty_slabs++;
+
+    return s;
+}
+
+/* take up to count objects from the slabs, called with the cache lock held */
+static uint slab_get_locked(slab_cache_t *cache, void **objs, uint count)
+{
+    uint got = 0;
+
+    if (!cache->objs_per_slab)
+        slab_cache_setup(cache);
+
+    while (got < count) {
+        struct slab *s = list_peek_head_type(&cache->partial, struct slab, node);
+        if (!s) {
+            s = slab_grow(cache);
+            if (!s)
+                break;
+        }
+
+        if (s->nfree == cache->objs_per_slab)
+            cache->empty_slabs--;
+
+        uint8_t *base = slab_objs(cache, s);
+        while (got < count && s->nfree)
+            objs[got++] = base + s->free[--s->nfree] * slab_obj_size(cache);
+
+        if (!s->nfree)
+            list_delete(&s->node);
+    }
+
+    return got;
+}
+
+/* return objects to their slabs, called with the cache lock held */
+static void slab_put_locked(slab_cache_t *cache, void **objs, uint count)
+{
+    for (uint i = 0; i < count; i++) {
+        struct slab *s = obj_to_slab(cache, objs[i]);
+        uint index = ((uint8_t *)objs[i] - slab_objs(cache, s)) / slab_obj_size(cache);
+
+        DEBUG_ASSERT(s->cache == cache);
+        DEBUG_ASSERT(index < cache->objs_per_slab);
+        DEBUG_ASSERT(s->nfree < cache->objs_per_slab);
+
+        if (!s->nfree)
+            list_add_head(&cache->partial, &s->node);
+
+        s->free[s->nfree++] = index;
+
+        if (s->nfree == cache->objs_per_slab) {
+            /* keep one empty slab around, free the rest */
+            if (cache->empty_slabs) {
+                list_delete(&s->node);
+                page_free(s, cache->slab_pages);
+                cache->slabs--;
+            } else {
+                cache->empty_slabs++;
+            }
+        }
+    }
+}
+
+void *slab_alloc(slab_cache_t *cache)
+{
+    struct slab_magazine *mag;
+    spin_lock_saved_state_t state;
+    void *objs[SLAB_MAGAZINE_SIZE / 2];
+    void *obj = NULL;
+    uint got;
+
+    DEBUG_ASSERT(cache);
+
+    mag = &cache->mag[arch_curr_cpu_num()];
+
+    if (slab_obj_size(cache) >= SLAB_MAX_SIZE) {
+        obj = malloc(cache->size);
+        if (obj && cache->ctor)
+            cache->ctor(obj);
+
+        spin_lock_save(&mag->lock, &state, SPIN_LOCK_FLAG_INTERRUPTS);
+        if (obj)
+            mag->allocs++;
+        spin_unlock_restore(&mag->lock, state, SPIN_LOCK_FLAG_INTERRUPTS);
+        return obj;
+    }
+
+    spin_lock_save(&mag->lock, &state, SPIN_LOCK_FLAG_INTERRUPTS);
+    if (mag->count) {
+        obj = mag->objs[--mag->count];
+        mag->allocs++;
+        mag->hits++;
+    }
+    spin_unlock_restore(&mag->lock, state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (obj)
+        return obj;
+
+    /* magazine is empty, refill half of it from the slabs */
+    mutex_acquire(&cache->lock);
+    got = slab_get_locked(cache, objs, countof(objs));
+    if (got) {
+        obj = objs[--got];
+
+        spin_lock_save(&mag->lock, &state, SPIN_LOCK_FLAG_INTERRUPTS);
+        mag->allocs++;
+        while (got && mag->count < SLAB_MAGAZINE_SIZE)
+            mag->objs[mag->count++] = objs[--got];
+        spin_unlock_restore(&mag->lock, state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+        /* someone filled it in the meantime */
+        slab_put_locked(cache, objs, got);
+    }
+    mutex_release(&cache->lock);
+
+    return obj;
+}
+
+void slab_free(slab_cache_t *cache, void *obj)
+{
+    struct slab_magazine *mag;
+    spin_lock_saved_state_t state;
+    void *objs[SLAB_MAGAZINE_SIZE / 2];
+    uint count = 0;
+
+    DEBUG_ASSERT(cache);
+
+    if (!obj)
+        return;
+
+    mag = &cache->mag[arch_curr_cpu_num()];
+
+    spin_lock_save(&mag->lock, &state, SPIN_LOCK_FLAG_INTERRUPTS);
+    mag->frees++;
+    if (slab_obj_size(cache) >= SLAB_MAX_SIZE) {
+        spin_unlock_restore(&mag->lock, state, SPIN_LOCK_FLAG_INTERRUPTS);
+        free(obj);
+        return;
+    }
+    if (mag->count == SLAB_MAGAZINE_SIZE) {
+        /* magazine is full, flush half of it to the slabs */
+        while (count < countof(objs))
+            objs[count++] = mag->objs[--mag->count];
+    }
+    mag->objs[mag->count++] = obj;
+    spin_unlock_restore(&mag->lock, state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (count) {
+        mutex_acquire(&cache->lock);
+        slab_put_locked(cache, objs, count);
+        mutex_release(&cache->lock);
+    }
+}
+
+void slab_cache_trim(slab_cache_t *cache)
+{
+    spin_lock_saved_state_t state;
+    struct slab *s, *temp;
+
+    mutex_acquire(&cache->lock);
+
+    /* empty the magazines so their slabs can drain */
+    for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+        struct slab_magazine *mag = &cache->mag[i];
+        void *objs[SLAB_MAGAZINE_SIZE];
+        uint count;
+
+        spin_lock_save(&mag->lock, &state, SPIN_LOCK_FLAG_INTERRUPTS);
+        count = mag->count;
+        memcpy(objs, mag->objs, count * sizeof(objs[0]));
+        mag->count = 0;
+        spin_unlock_restore(&mag->lock, state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+        slab_put_locked(cache, objs, count);
+    }
+
+    list_for_every_entry_safe(&cache->partial, s, temp, struct slab, node) {
+        if (s->nfree == cache->objs_per_slab) {
+            list_delete(&s->node);
+            page_free(s, cache->slab_pages);
+            cache->slabs--;
+            cache->empty_slabs--;
+        }
+    }
+
+    mutex_release(&cache->lock);
+}
+
+#if LK_DEBUGLEVEL > 1
+#if WITH_LIB_CONSOLE
+
+#include <lib/console.h>
+
+static int cmd_slab(int argc, const cmd_args *argv);
+
+STATIC_COMMAND_START
+STATIC_COMMAND("slab", "slab cache stats", &cmd_slab)
+STATIC_COMMAND_END(slab);
+
+static int cmd_slab(int argc, const cmd_args *argv)
+{
+    slab_cache_t *cache;
+
+    mutex_acquire(&cache_list_lock);
+    printf("%-16s %6s %6s %6s %10s %10s %10s\n", "cache", "size", "slabs",
+           "inuse", "allocs", "frees", "mag hits");
+    list_for_every_entry(&cache_list, cache, slab_cache_t, node) {
+        ulong allocs = 0, frees = 0, hits = 0;
+
+        for (uint i = 0; i < SMP_MAX_CPUS; i++) {
+            allocs += cache->mag[i].allocs;
+            frees += cache->mag[i].frees;
+            hits += cache->mag[i].hits;
+        }
+        printf("%-16s %6zu %6u %6lu %10lu %10lu %10lu\n", cache->name,
+               cache->size, cache->slabs, allocs - frees, allocs, frees, hits);
+    }
+    mutex_release(&cache_list_lock);
+
+    return 0;
+}
+
+#endif
+#endif
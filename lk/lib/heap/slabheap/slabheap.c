@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2015 Travis Geiselbrecht
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <lib/slabheap.h>
+
+#include <debug.h>
+#include <assert.h>
+#include <trace.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <list.h>
+#include <kernel/spinlock.h>
+#include <lib/slab.h>
+#include <lib/page_alloc.h>
+#if WITH_KERNEL_VM
+#include <kernel/vm.h>
+#else
+#include <kernel/novm.h>
+#endif
+
+#define LOCAL_TRACE 0
+
+/*
+ * A heap made of size class slab caches. Small requests are rounded up to
+ * the nearest class and served by that class's slab cache, so most mallocs
+ * and frees only touch a per cpu magazine; the slabs behind it are refilled
+ * and flushed in batches and come straight from the page allocator.
+ * Requests too big for the largest class get whole pages.
+ *
+ * Class blocks start with a header naming their class, so free() does not
+ * have to search for the block. memalign() places a second header in front
+ * of the aligned pointer that points back to the start of the block.
+ *
+ * Large blocks carry no header so that a page aligned request costs exactly
+ * its pages; their size is kept in a small hash table instead. Large block
+ * pointers are always page aligned, so only page aligned pointers are looked
+ * up there. The classes from 512 bytes up have multi-page slabs, so a class
+ * block pointer can be page aligned too; it is then just not found.
+ */
+struct alloc_hdr {
+    uint32_t cls;    /* size class */
+    uint32_t offset; /* of this header from the start of the block */
+};
+
+#define HDR_SIZE sizeof(struct alloc_hdr)
+
+/* blocks come out of the slabs 8 byte aligned, keep the payload that way */
+STATIC_ASSERT(sizeof(struct alloc_hdr) == 8);
+
+#define SIZE_CLASS(i, s) \
+    [i] = SLAB_CACHE_INITIAL_VALUE(size_class[i], "malloc-" #s, s, NULL)
+
+/* largest block size, header included, served from a size class */
+#define CLASS_MAX_SIZE 2048
+
+/* every class fits the slabs, or objects would be passed back to the heap */
+STATIC_ASSERT(CLASS_MAX_SIZE < SLAB_MAX_SIZE);
+
+/* block sizes, header included */
+static slab_cache_t size_class[] = {
+    SIZE_CLASS(0, 16),
+    SIZE_CLASS(1, 32),
+    SIZE_CLASS(2, 48),
+    SIZE_CLASS(3, 64),
+    SIZE_CLASS(4, 96),
+    SIZE_CLASS(5, 128),
+    SIZE_CLASS(6, 192),
+    SIZE_CLASS(7, 256),
+    SIZE_CLASS(8, 384),
+    SIZE_CLASS(9, 512),
+    SIZE_CLASS(10, 768),
+    SIZE_CLASS(11, 1024),
+    SIZE_CLASS(12, 1536),
+    SIZE_CLASS(13, CLASS_MAX_SIZE),
+};
+
+/* size class of a block size in CLASS_STEP units, filled in at init */
+#define CLASS_STEP 8
+static uint8_t class_index[CLASS_MAX_SIZE / CLASS_STEP + 1];
+static uint num_classes;
+static size_t max_class_size;
+
+struct large_block {
+    struct large_block *next;
+    void *ptr;  /* as handed out, page aligned */
+    void *base; /* of the pages, below ptr for alignments above a page */
+    uint pages;
+};
+
+#define LARGE_HASH_SIZE 64
+
+static struct large_block *large_hash[LARGE_HASH_SIZE];
+static spin_lock_t large_lock = SPIN_LOCK_INITIAL_VALUE;
+static uint large_pages;
+
+static slab_cache_t large_cache = SLAB_CACHE_INITIAL_VALUE(large_cache,
+        "malloc-large", sizeof(struct large_block), NULL);
+
+static inline struct alloc_hdr *ptr_to_hdr(void *ptr)
+{
+    return (struct alloc_hdr *)ptr - 1;
+}
+
+static inline struct alloc_hdr *hdr_to_block(struct alloc_hdr *hdr)
+{
+    return (struct alloc_hdr *)((uintptr_t)hdr - hdr->offset);
+}
+
+static inline struct large_block **large_bucket(void *ptr)
+{
+    return &large_hash[((uintptr_t)ptr / PAGE_SIZE) % LARGE_HASH_SIZE];
+}
+
+static void *class_alloc(size_t size)
+{
+    uint cls = class_index[(size + HDR_SIZE + CLASS_STEP - 1) / CLASS_STEP];
+    struct alloc_hdr *hdr = slab_alloc(&size_class[cls]);
+
+    if (!hdr)
+        return NULL;
+    hdr->cls = cls;
+    hdr->offset = 0;
+
+    LTRACEF("size %zu -> %p, class %u\n", size, hdr + 1, cls);
+    return hdr + 1;
+}
+
+static void *large_alloc(size_t size, size_t alignment)
+{
+    spin_lock_saved_state_t state;
+    struct large_block *lb, **bucket;
+
+    /* pages are aligned to a page already */
+    if (alignment > PAGE_SIZE)
+        size += alignment - PAGE_SIZE;
+
+    lb = slab_alloc(&large_cache);
+    if (!lb)
+        return NULL;
+
+    lb->pages = ROUNDUP(size, PAGE_SIZE) / PAGE_SIZE;
+    lb->base = page_alloc(lb->pages, PAGE_ALLOC_ANY_ARENA);
+    if (!lb->base) {
+        slab_free(&large_cache, lb);
+        return NULL;
+    }
+    lb->ptr = (void *)ROUNDUP((uintptr_t)lb->base, MAX(alignment, PAGE_SIZE));
+
+    spin_lock_irqsave(&large_lock, state);
+    bucket = large_bucket(lb->ptr);
+    lb->next = *bucket;
+    *bucket = lb;
+    large_pages += lb->pages;
+    spin_unlock_irqrestore(&large_lock, state);
+
+    LTRACEF("size %zu -> %p, %u pages\n", size, lb->ptr, lb->pages);
+    return lb->ptr;
+}
+
+/* look up the large block at ptr, taking it out of the table if remove is set */
+static struct large_block *large_find(void *ptr, bool remove)
+{
+    spin_lock_saved_state_t state;
+    struct large_block *lb, **prev;
+
+    spin_lock_irqsave(&large_lock, state);
+    for (prev = large_bucket(ptr); (lb = *prev); prev = &lb->next) {
+        if (lb->ptr != ptr)
+            continue;
+        if (remove) {
+            *prev = lb->next;
+            large_pages -= lb->pages;
+        }
+        break;
+    }
+    spin_unlock_irqrestore(&large_lock, state);
+
+    return lb;
+}
+
+void *slabheap_alloc(size_t size, size_t alignment)
+{
+    LTRACEF("size %zu, align %zu\n", size, alignment);
+
+    // alignment must be power of 2
+    if (alignment & (alignment - 1))
+        return NULL;
+
+    /* leave room for a heap_delayed_free() list node */
+    size = MAX(size, sizeof(struct list_node));
+
+    if (size > SIZE_MAX - PAGE_SIZE - alignment)
+        return NULL;
+
+    /* class blocks are HDR_SIZE aligned already, pad them for more */
+    size_t pad = (alignment > HDR_SIZE) ? alignment : 0;
+    if (size + pad + HDR_SIZE > max_class_size)
+        return large_alloc(size, alignment);
+
+    uint8_t *ptr = class_alloc(size + pad);
+    if (!ptr || !pad)
+        return ptr;
+
+    uint8_t *aligned = (uint8_t *)ROUNDUP((uintptr_t)ptr, alignment);
+    if (aligned != ptr) {
+        struct alloc_hdr *block = ptr_to_hdr(ptr);
+        struct alloc_hdr *hdr = ptr_to_hdr(aligned);
+
+        hdr->cls = block->cls;
+        hdr->offset = (uintptr_t)hdr - (uintptr_t)block;
+    }
+
+    return aligned;
+}
+
+void *slabheap_realloc(void *ptr, size_t size)
+{
+    size_t usable;
+
+    if (!ptr)
+        return slabheap_alloc(size, 0);
+    if (size == 0) {
+        slabheap_free(ptr);
+        return NULL;
+    }
+
+    struct large_block *lb = NULL;
+
+    if (IS_ALIGNED((uintptr_t)ptr, PAGE_SIZE))
+        lb = large_find(ptr, false);
+
+    if (lb) {
+        usable = (uintptr_t)lb->base + lb->pages * PAGE_SIZE - (uintptr_t)ptr;
+    } else {
+        struct alloc_hdr *hdr = ptr_to_hdr(ptr);
+
+        DEBUG_ASSERT(hdr->cls < num_classes);
+        usable = (uintptr_t)hdr_to_block(hdr) + size_class[hdr->cls].size -
+                 (uintptr_t)ptr;
+    }
+
+    /* fits, and shrinking it would not free up much */
+    if (size <= usable && size >= usable / 2)
+        return ptr;
+
+    void *p = slabheap_alloc(size, 0);
+    if (!p)
+        return NULL;
+
+    memcpy(p, ptr, MIN(size, usable));
+    slabheap_free(ptr);
+
+    return p;
+}
+
+void slabheap_free(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    LTRACEF("ptr %p\n", ptr);
+
+    struct large_block *lb = NULL;
+
+    if (IS_ALIGNED((uintptr_t)ptr, PAGE_SIZE))
+        lb = large_find(ptr, true);
+
+    if (lb) {
+        page_free(lb->base, lb->pages);
+        slab_free(&large_cache, lb);
+    } else {
+        struct alloc_hdr *hdr = hdr_to_block(ptr_to_hdr(ptr));
+
+        DEBUG_ASSERT(hdr->cls < num_classes);
+        slab_free(&size_class[hdr->cls], hdr);
+    }
+}
+
+void slabheap_init(void)
+{
+    uint cls = 0;
+
+    num_classes = countof(size_class);
+    max_class_size = size_class[num_classes - 1].size;
+
+    for (uint i = 0; i <= max_class_size / CLASS_STEP; i++) {
+        while (size_class[cls].size < i * CLASS_STEP)
+            cls++;
+        class_index[i] = cls;
+    }
+
+    LTRACEF("%u size classes, up to %zu bytes\n", num_classes, max_class_size);
+}
+
+void slabheap_dump(void)
+{
+    printf("\tslab heap, %u size classes up to %zu bytes\n", num_classes, max_class_size);
+    for (uint i = 0; i < num_classes; i++) {
+        if (size_class[i].slabs)
+            printf("\t\t%-12s %u slabs\n", size_class[i].name, size_class[i].slabs);
+    }
+    printf("\t\tlarge allocations %u pages\n", large_pages);
+}
+
+void slabheap_trim(void)
+{
+    for (uint i = 0; i < num_classes; i++)
+        slab_cache_trim(&size_class[i]);
+    slab_cache_trim(&large_cache);
+}
@@ -5,6 +5,9 @@ include project/virtual/trusty.mk
 WITH_TRUSTY_IPC := 1
 WITH_KERNEL_VM := 1
 
+# size class slab heap, scales with concurrent TA sessions
+LK_HEAP_IMPLEMENTATION ?= slabheap
+
 ifeq (true,$(call TOBOOL,$(WITH_VIRTIO_VIODEV_SUPPORT)))
 # enable tipc virtio device connection to REE
 WITH_TRUSTY_TIPC_DEV := 1
@@ -21,12 +21,23 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <arch/uthread_mmu.h>
 #include <assert.h>
+#include <err.h>
 #include <lk/init.h>
+#include <platform.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <uthread.h>
 
+#if WITH_LIB_CONSOLE
+#include <lib/console.h>
+#endif
+
+#define BENCH_BUF_SIZE	(64 * 1024)
+#define BENCH_BYTES	(1024 * 1024)
+
 static void usercopy_test(uint level)
 {
 	int ret;
@@ -60,4 +71,87 @@ static void usercopy_test(uint level)
 	printf("PASSED - %s\n", __func__);
 }
 
+#if WITH_LIB_CONSOLE
+/* time copies between a kernel buffer and the same buffer mapped in a uthread */
+static int usercopy_bench(int argc, const cmd_args *argv)
+{
+	uthread_t *ut;
+	uint8_t *kbuf, *ubuf;
+	vaddr_t uaddr = 0;
+	lk_bigtime_t start, to_us, from_us;
+	size_t len;
+	uint off, i, passes;
+	status_t err = NO_ERROR;
+
+	kbuf = malloc(BENCH_BUF_SIZE + 4);
+	ubuf = memalign(PAGE_SIZE, BENCH_BUF_SIZE + PAGE_SIZE);
+	ut = uthread_create("usercopy_bench", 0x8000, DEFAULT_PRIORITY,
+			MAX_USR_VA >> 1, PAGE_SIZE, NULL);
+	if (!kbuf || !ubuf || !ut) {
+		printf("%s: out of memory\n", __func__);
+		err = ERR_NO_MEMORY;
+		goto out;
+	}
+
+	err = uthread_map_contig(ut, &uaddr, vaddr_to_paddr(ubuf),
+			BENCH_BUF_SIZE + PAGE_SIZE, UTM_R | UTM_W,
+			UT_MAP_ALIGN_DEFAULT);
+	if (err) {
+		printf("%s: map failed %d\n", __func__, err);
+		uaddr = 0;
+		goto out;
+	}
+	memset(kbuf, 0x5a, BENCH_BUF_SIZE + 4);
+
+	/* borrow the uthread address space for this kernel thread */
+	tls_set(TLS_ENTRY_UTHREAD, (uintptr_t)ut);
+	arch_uthread_context_switch(NULL, ut);
+
+	for (off = 0; off < 2; off++) {
+		for (len = 16; len <= BENCH_BUF_SIZE; len *= 4) {
+			passes = BENCH_BYTES / len;
+
+			start = current_time_hires();
+			for (i = 0; i < passes; i++)
+				copy_to_user(uaddr + off, kbuf, len);
+			to_us = current_time_hires() - start;
+
+			start = current_time_hires();
+			for (i = 0; i < passes; i++)
+				copy_from_user(kbuf, uaddr + off, len);
+			from_us = current_time_hires() - start;
+
+			printf("%s: %6zu bytes%s: to_user %llu us, from_user %llu us per MB\n",
+					__func__, len, off ? " unaligned" : "",
+					(unsigned long long)to_us,
+					(unsigned long long)from_us);
+		}
+	}
+
+	/* give the address space back before tearing it down */
+	arch_uthread_context_switch(ut, NULL);
+	tls_set(TLS_ENTRY_UTHREAD, 0);
+
+out:
+	if (ut) {
+		/* drop the mapping and its tlb entries before ubuf is freed */
+		if (uaddr)
+			uthread_unmap(ut, uaddr, BENCH_BUF_SIZE + PAGE_SIZE);
+		/*
+		 * The uthread's own thread was never resumed; thread_kill
+		 * takes it straight from suspended to dead and frees it.
+		 */
+		uthread_kill(ut, 0);
+	}
+	free(ubuf);
+	free(kbuf);
+
+	return err;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("usercopy_bench", "time copy_to_user and copy_from_user", &usercopy_bench)
+STATIC_COMMAND_END(usercopytest);
+#endif /* WITH_LIB_CONSOLE */
+
 LK_INIT_HOOK(usercopy_test, usercopy_test, LK_INIT_LEVEL_APPS);
@@ -46,6 +46,13 @@ struct rijndael_key {
 };
 #endif
 
+#ifdef LTC_RIJNDAEL_CT
+struct aes_ct_key {
+   ulong32 sk[120];
+   int Nr;
+};
+#endif
+
 #ifdef LTC_KSEED
 struct kseed_key {
     ulong32 K[32], dK[32];
@@ -183,6 +190,9 @@ typedef union Symmetric_key {
 #ifdef LTC_RIJNDAEL
    struct rijndael_key rijndael;
 #endif
+#ifdef LTC_RIJNDAEL_CT
+   struct aes_ct_key   aes_ct;
+#endif
 #ifdef LTC_XTEA
    struct xtea_key     xtea;
 #endif
@@ -689,6 +699,23 @@ extern const struct ltc_cipher_descriptor rijndael_desc, aes_desc;
 extern const struct ltc_cipher_descriptor rijndael_enc_desc, aes_enc_desc;
 #endif
 
+#ifdef LTC_RIJNDAEL_CT
+int aes_ct_setup(const unsigned char *key, int keylen, int num_rounds, symmetric_key *skey);
+int aes_ct_ecb_encrypt(const unsigned char *pt, unsigned char *ct, symmetric_key *skey);
+int aes_ct_ecb_decrypt(const unsigned char *ct, unsigned char *pt, symmetric_key *skey);
+int aes_ct_accel_ecb_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks, symmetric_key *skey);
+int aes_ct_accel_ecb_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long blocks, symmetric_key *skey);
+int aes_ct_accel_cbc_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks, unsigned char *IV, symmetric_key *skey);
+int aes_ct_accel_cbc_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long blocks, unsigned char *IV, symmetric_key *skey);
+int aes_ct_accel_ctr_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks, unsigned char *IV, int mode, symmetric_key *skey);
+int aes_ct_accel_xts_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks, unsigned char *tweak, symmetric_key *skey1, symmetric_key *skey2);
+int aes_ct_accel_xts_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long blocks, unsigned char *tweak, symmetric_key *skey1, symmetric_key *skey2);
+int aes_ct_test(void);
+void aes_ct_done(symmetric_key *skey);
+int aes_ct_keysize(int *keysize);
+extern const struct ltc_cipher_descriptor aes_ct_desc;
+#endif
+
 #ifdef LTC_XTEA
 int xtea_setup(const unsigned char *key, int keylen, int num_rounds, symmetric_key *skey);
 int xtea_ecb_encrypt(const unsigned char *pt, unsigned char *ct, symmetric_key *skey);
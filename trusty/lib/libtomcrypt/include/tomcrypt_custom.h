@@ -145,6 +145,9 @@
 
 #ifdef CFG_CRYPTO_AES
    #define LTC_RIJNDAEL
+#ifdef CFG_CRYPTO_AES_CT
+   #define LTC_RIJNDAEL_CT
+#endif
 #endif
 #ifdef CFG_CRYPTO_DES
    #define LTC_DES
@@ -206,6 +209,11 @@
 #endif
 #ifdef CFG_CRYPTO_GCM
    #define LTC_GCM_MODE
+   #if defined(CFG_CRYPTO_GCM_TABLE_8BIT)
+      #define LTC_GCM_TABLES_8BIT
+   #elif defined(CFG_CRYPTO_GCM_TABLE_4BIT)
+      #define LTC_GCM_TABLES_4BIT
+   #endif
 #endif
 
 #define LTC_NO_PRNGS
@@ -420,7 +428,7 @@
 #define LTC_CHACHA20POLY1305_MODE
 
 /* Use 64KiB tables */
-#ifndef LTC_NO_TABLES
+#if !defined(LTC_NO_TABLES) && !defined(LTC_GCM_TABLES_4BIT) && !defined(LTC_GCM_TABLES_8BIT)
    #define LTC_GCM_TABLES
 #endif
 
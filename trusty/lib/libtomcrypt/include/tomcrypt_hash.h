@@ -335,6 +335,12 @@ int sha256_done(hash_state * md, unsigned char *hash);
 int sha256_test(void);
 extern const struct ltc_hash_descriptor sha256_desc;
 
+extern const ulong32 sha256_mb_iv[8];
+int sha256_mb_memory(const ulong32 *iv, ulong64 prelen,
+                     const unsigned char * const *in,
+                     const unsigned long *inlen,
+                     unsigned char * const *out, unsigned long n);
+
 #ifdef LTC_SHA224
 #ifndef LTC_SHA256
    #error LTC_SHA256 is required for LTC_SHA224
@@ -372,7 +372,7 @@ void gcm_gf_mult(const unsigned char *a, const unsigned char *b, unsigned char *
 
 
 /* table shared between GCM and LRW */
-#if defined(LTC_GCM_TABLES) || defined(LTC_LRW_TABLES) || ((defined(LTC_GCM_MODE) || defined(LTC_GCM_MODE)) && defined(LTC_FAST))
+#if defined(LTC_GCM_TABLES) || defined(LTC_GCM_TABLES_8BIT) || defined(LTC_LRW_TABLES) || ((defined(LTC_GCM_MODE) || defined(LTC_GCM_MODE)) && defined(LTC_FAST))
 extern const unsigned char gcm_shift_table[];
 #endif
 
@@ -408,9 +408,18 @@ __attribute__ ((aligned (16)))
 #endif
 ;
 #endif
+#if defined(LTC_GCM_TABLES_8BIT)
+   ulong32             HT[256][4];   /* H * i for each byte value */
+#elif defined(LTC_GCM_TABLES_4BIT)
+   ulong32             HT[16][4];    /* H * i for each nibble value */
+#endif
 } gcm_state;
 
 void gcm_mult_h(gcm_state *gcm, unsigned char *I);
+void gcm_ghash(gcm_state *gcm, const unsigned char *in, unsigned long blocks);
+#if defined(LTC_GCM_TABLES_4BIT) || defined(LTC_GCM_TABLES_8BIT)
+void gcm_gen_table(gcm_state *gcm);
+#endif
 
 int gcm_init(gcm_state *gcm, int cipher,
              const unsigned char *key, int keylen);
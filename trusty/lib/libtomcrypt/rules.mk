@@ -33,6 +33,7 @@ MODULE_CFLAGS += -DLTC_SOURCE
 MODULE_SRCS += \
 	$(LOCAL_DIR)/src/mpa_desc.c \
 	$(LOCAL_DIR)/src/tee_ltc_provider.c \
+	$(LOCAL_DIR)/src/tee_ltc_bench.c \
 
 MODULE_DEPS += lib/libmpa
 
@@ -0,0 +1,1104 @@
+/*
+ * Copyright (c) 2018, MIPS Tech, LLC and/or its affiliated group companies
+ * (“MIPS”).
+ * Copyright (c) 2016 Thomas Pornin <pornin@bolet.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+  @file aes_ct.c
+  Constant-time bitsliced AES, based on the BearSSL "aes_ct" core.
+
+  The state of two blocks is held in eight 32-bit words, one word per bit of
+  each state byte, so SubBytes is evaluated as a boolean circuit and no
+  secret-dependent table lookup or branch is ever performed.  This removes
+  the 4 KB T-table working set of aes.c (and its cache-timing leak), which
+  matters on the small L1 caches of our MIPS cores.
+
+  Single-block operations (ecb_encrypt/ecb_decrypt, CBC encryption) run the
+  core with one lane in use.  The accelerated ECB, CBC decryption, CTR and
+  XTS hooks process two blocks per pass.
+*/
+
+#include "tomcrypt.h"
+
+#ifdef LTC_RIJNDAEL_CT
+
+const struct ltc_cipher_descriptor aes_ct_desc =
+{
+    "aes",
+    6,
+    16, 32, 16, 10,
+    aes_ct_setup, aes_ct_ecb_encrypt, aes_ct_ecb_decrypt, aes_ct_test,
+    aes_ct_done, aes_ct_keysize,
+    aes_ct_accel_ecb_encrypt, aes_ct_accel_ecb_decrypt,
+    aes_ct_accel_cbc_encrypt, aes_ct_accel_cbc_decrypt,
+#ifdef LTC_CTR_MODE
+    aes_ct_accel_ctr_encrypt,
+#else
+    NULL,
+#endif
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+#ifdef LTC_XTS_MODE
+    aes_ct_accel_xts_encrypt, aes_ct_accel_xts_decrypt
+#else
+    NULL, NULL
+#endif
+};
+
+/*
+ * Bitsliced S-box (Boyar-Peralta circuit, 113 gates).  q[0..7] hold bit 0..7
+ * of every byte of the state.
+ */
+static void _bitslice_sbox(ulong32 *q)
+{
+   ulong32 x0, x1, x2, x3, x4, x5, x6, x7;
+   ulong32 y1, y2, y3, y4, y5, y6, y7, y8, y9;
+   ulong32 y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+   ulong32 y20, y21;
+   ulong32 z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+   ulong32 z10, z11, z12, z13, z14, z15, z16, z17;
+   ulong32 t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+   ulong32 t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+   ulong32 t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+   ulong32 t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+   ulong32 t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+   ulong32 t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+   ulong32 t60, t61, t62, t63, t64, t65, t66, t67;
+   ulong32 s0, s1, s2, s3, s4, s5, s6, s7;
+
+   x0 = q[7];
+   x1 = q[6];
+   x2 = q[5];
+   x3 = q[4];
+   x4 = q[3];
+   x5 = q[2];
+   x6 = q[1];
+   x7 = q[0];
+
+   /* top linear transformation */
+   y14 = x3 ^ x5;
+   y13 = x0 ^ x6;
+   y9 = x0 ^ x3;
+   y8 = x0 ^ x5;
+   t0 = x1 ^ x2;
+   y1 = t0 ^ x7;
+   y4 = y1 ^ x3;
+   y12 = y13 ^ y14;
+   y2 = y1 ^ x0;
+   y5 = y1 ^ x6;
+   y3 = y5 ^ y8;
+   t1 = x4 ^ y12;
+   y15 = t1 ^ x5;
+   y20 = t1 ^ x1;
+   y6 = y15 ^ x7;
+   y10 = y15 ^ t0;
+   y11 = y20 ^ y9;
+   y7 = x7 ^ y11;
+   y17 = y10 ^ y11;
+   y19 = y10 ^ y8;
+   y16 = t0 ^ y11;
+   y21 = y13 ^ y16;
+   y18 = x0 ^ y16;
+
+   /* non-linear section */
+   t2 = y12 & y15;
+   t3 = y3 & y6;
+   t4 = t3 ^ t2;
+   t5 = y4 & x7;
+   t6 = t5 ^ t2;
+   t7 = y13 & y16;
+   t8 = y5 & y1;
+   t9 = t8 ^ t7;
+   t10 = y2 & y7;
+   t11 = t10 ^ t7;
+   t12 = y9 & y11;
+   t13 = y14 & y17;
+   t14 = t13 ^ t12;
+   t15 = y8 & y10;
+   t16 = t15 ^ t12;
+   t17 = t4 ^ t14;
+   t18 = t6 ^ t16;
+   t19 = t9 ^ t14;
+   t20 = t11 ^ t16;
+   t21 = t17 ^ y20;
+   t22 = t18 ^ y19;
+   t23 = t19 ^ y21;
+   t24 = t20 ^ y18;
+
+   t25 = t21 ^ t22;
+   t26 = t21 & t23;
+   t27 = t24 ^ t26;
+   t28 = t25 & t27;
+   t29 = t28 ^ t22;
+   t30 = t23 ^ t24;
+   t31 = t22 ^ t26;
+   t32 = t31 & t30;
+   t33 = t32 ^ t24;
+   t34 = t23 ^ t33;
+   t35 = t27 ^ t33;
+   t36 = t24 & t35;
+   t37 = t36 ^ t34;
+   t38 = t27 ^ t36;
+   t39 = t29 & t38;
+   t40 = t25 ^ t39;
+
+   t41 = t40 ^ t37;
+   t42 = t29 ^ t33;
+   t43 = t29 ^ t40;
+   t44 = t33 ^ t37;
+   t45 = t42 ^ t41;
+   z0 = t44 & y15;
+   z1 = t37 & y6;
+   z2 = t33 & x7;
+   z3 = t43 & y16;
+   z4 = t40 & y1;
+   z5 = t29 & y7;
+   z6 = t42 & y11;
+   z7 = t45 & y17;
+   z8 = t41 & y10;
+   z9 = t44 & y12;
+   z10 = t37 & y3;
+   z11 = t33 & y4;
+   z12 = t43 & y13;
+   z13 = t40 & y5;
+   z14 = t29 & y2;
+   z15 = t42 & y9;
+   z16 = t45 & y14;
+   z17 = t41 & y8;
+
+   /* bottom linear transformation */
+   t46 = z15 ^ z16;
+   t47 = z10 ^ z11;
+   t48 = z5 ^ z13;
+   t49 = z9 ^ z10;
+   t50 = z2 ^ z12;
+   t51 = z2 ^ z5;
+   t52 = z7 ^ z8;
+   t53 = z0 ^ z3;
+   t54 = z6 ^ z7;
+   t55 = z16 ^ z17;
+   t56 = z12 ^ t48;
+   t57 = t50 ^ t53;
+   t58 = z4 ^ t46;
+   t59 = z3 ^ t54;
+   t60 = t46 ^ t57;
+   t61 = z14 ^ t57;
+   t62 = t52 ^ t58;
+   t63 = t49 ^ t58;
+   t64 = z4 ^ t59;
+   t65 = t61 ^ t62;
+   t66 = z1 ^ t63;
+   s0 = t59 ^ t63;
+   s6 = t56 ^ ~t62;
+   s7 = t48 ^ ~t60;
+   t67 = t64 ^ t65;
+   s3 = t53 ^ t66;
+   s4 = t51 ^ t66;
+   s5 = t47 ^ t65;
+   s1 = t64 ^ ~s3;
+   s2 = t55 ^ ~t67;
+
+   q[7] = s0;
+   q[6] = s1;
+   q[5] = s2;
+   q[4] = s3;
+   q[3] = s4;
+   q[2] = s5;
+   q[1] = s6;
+   q[0] = s7;
+}
+
+/*
+ * Inverse S-box, expressed through the forward one:
+ *   iS(x) = B(S(B(x ^ 0x63)) ^ 0x63)
+ * where B() is the inverse of the S-box affine transform.  This keeps the
+ * code small; decryption is rarely the hot path except for CBC, which
+ * processes two blocks per pass anyway.
+ */
+static void _inv_affine(ulong32 *q)
+{
+   ulong32 q0, q1, q2, q3, q4, q5, q6, q7;
+
+   q0 = ~q[0];
+   q1 = ~q[1];
+   q2 = q[2];
+   q3 = q[3];
+   q4 = q[4];
+   q5 = ~q[5];
+   q6 = ~q[6];
+   q7 = q[7];
+   q[7] = q1 ^ q4 ^ q6;
+   q[6] = q0 ^ q3 ^ q5;
+   q[5] = q7 ^ q2 ^ q4;
+   q[4] = q6 ^ q1 ^ q3;
+   q[3] = q5 ^ q0 ^ q2;
+   q[2] = q4 ^ q7 ^ q1;
+   q[1] = q3 ^ q6 ^ q0;
+   q[0] = q2 ^ q5 ^ q7;
+}
+
+static void _bitslice_inv_sbox(ulong32 *q)
+{
+   _inv_affine(q);
+   _bitslice_sbox(q);
+   _inv_affine(q);
+}
+
+/*
+ * Convert two blocks held as q[0,2,4,6] / q[1,3,5,7] (little-endian words)
+ * to and from the bitsliced representation.  The transform is an involution.
+ */
+static void _ortho(ulong32 *q)
+{
+#define SWAPN(cl, ch, s, x, y)   do { \
+      ulong32 a, b; \
+      a = (x); \
+      b = (y); \
+      (x) = (a & (ulong32)(cl)) | ((b & (ulong32)(cl)) << (s)); \
+      (y) = ((a & (ulong32)(ch)) >> (s)) | (b & (ulong32)(ch)); \
+   } while (0)
+
+#define SWAP2(x, y)   SWAPN(0x55555555, 0xAAAAAAAA, 1, x, y)
+#define SWAP4(x, y)   SWAPN(0x33333333, 0xCCCCCCCC, 2, x, y)
+#define SWAP8(x, y)   SWAPN(0x0F0F0F0F, 0xF0F0F0F0, 4, x, y)
+
+   SWAP2(q[0], q[1]);
+   SWAP2(q[2], q[3]);
+   SWAP2(q[4], q[5]);
+   SWAP2(q[6], q[7]);
+
+   SWAP4(q[0], q[2]);
+   SWAP4(q[1], q[3]);
+   SWAP4(q[4], q[6]);
+   SWAP4(q[5], q[7]);
+
+   SWAP8(q[0], q[4]);
+   SWAP8(q[1], q[5]);
+   SWAP8(q[2], q[6]);
+   SWAP8(q[3], q[7]);
+
+#undef SWAP8
+#undef SWAP4
+#undef SWAP2
+#undef SWAPN
+}
+
+static ulong32 _sub_word(ulong32 x)
+{
+   ulong32 q[8];
+   int i;
+
+   for (i = 0; i < 8; i++) {
+      q[i] = x;
+   }
+   _ortho(q);
+   _bitslice_sbox(q);
+   _ortho(q);
+   return q[0];
+}
+
+static void _add_round_key(ulong32 *q, const ulong32 *sk)
+{
+   q[0] ^= sk[0];
+   q[1] ^= sk[1];
+   q[2] ^= sk[2];
+   q[3] ^= sk[3];
+   q[4] ^= sk[4];
+   q[5] ^= sk[5];
+   q[6] ^= sk[6];
+   q[7] ^= sk[7];
+}
+
+static void _shift_rows(ulong32 *q)
+{
+   int i;
+
+   for (i = 0; i < 8; i++) {
+      ulong32 x = q[i];
+
+      q[i] = (x & 0x000000FF)
+           | ((x & 0x0000FC00) >> 2) | ((x & 0x00000300) << 6)
+           | ((x & 0x00F00000) >> 4) | ((x & 0x000F0000) << 4)
+           | ((x & 0xC0000000) >> 6) | ((x & 0x3F000000) << 2);
+   }
+}
+
+static void _inv_shift_rows(ulong32 *q)
+{
+   int i;
+
+   for (i = 0; i < 8; i++) {
+      ulong32 x = q[i];
+
+      q[i] = (x & 0x000000FF)
+           | ((x & 0x00003F00) << 2) | ((x & 0x0000C000) >> 6)
+           | ((x & 0x000F0000) << 4) | ((x & 0x00F00000) >> 4)
+           | ((x & 0x03000000) << 6) | ((x & 0xFC000000) >> 2);
+   }
+}
+
+#define ROTR16(x)  (((x) << 16) | ((x) >> 16))
+#define ROTR8(x)   (((x) >> 8) | ((x) << 24))
+
+static void _mix_columns(ulong32 *q)
+{
+   ulong32 q0, q1, q2, q3, q4, q5, q6, q7;
+   ulong32 r0, r1, r2, r3, r4, r5, r6, r7;
+
+   q0 = q[0]; q1 = q[1]; q2 = q[2]; q3 = q[3];
+   q4 = q[4]; q5 = q[5]; q6 = q[6]; q7 = q[7];
+   r0 = ROTR8(q0); r1 = ROTR8(q1); r2 = ROTR8(q2); r3 = ROTR8(q3);
+   r4 = ROTR8(q4); r5 = ROTR8(q5); r6 = ROTR8(q6); r7 = ROTR8(q7);
+
+   q[0] = q7 ^ r7 ^ r0 ^ ROTR16(q0 ^ r0);
+   q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ ROTR16(q1 ^ r1);
+   q[2] = q1 ^ r1 ^ r2 ^ ROTR16(q2 ^ r2);
+   q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ ROTR16(q3 ^ r3);
+   q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ ROTR16(q4 ^ r4);
+   q[5] = q4 ^ r4 ^ r5 ^ ROTR16(q5 ^ r5);
+   q[6] = q5 ^ r5 ^ r6 ^ ROTR16(q6 ^ r6);
+   q[7] = q6 ^ r6 ^ r7 ^ ROTR16(q7 ^ r7);
+}
+
+static void _inv_mix_columns(ulong32 *q)
+{
+   ulong32 q0, q1, q2, q3, q4, q5, q6, q7;
+   ulong32 r0, r1, r2, r3, r4, r5, r6, r7;
+
+   q0 = q[0]; q1 = q[1]; q2 = q[2]; q3 = q[3];
+   q4 = q[4]; q5 = q[5]; q6 = q[6]; q7 = q[7];
+   r0 = ROTR8(q0); r1 = ROTR8(q1); r2 = ROTR8(q2); r3 = ROTR8(q3);
+   r4 = ROTR8(q4); r5 = ROTR8(q5); r6 = ROTR8(q6); r7 = ROTR8(q7);
+
+   q[0] = q5 ^ q6 ^ q7 ^ r0 ^ r5 ^ r7 ^ ROTR16(q0 ^ q5 ^ q6 ^ r0 ^ r5);
+   q[1] = q0 ^ q5 ^ r0 ^ r1 ^ r5 ^ r6 ^ r7 ^ ROTR16(q1 ^ q5 ^ q7 ^ r1 ^ r5 ^ r6);
+   q[2] = q0 ^ q1 ^ q6 ^ r1 ^ r2 ^ r6 ^ r7 ^ ROTR16(q0 ^ q2 ^ q6 ^ r2 ^ r6 ^ r7);
+   q[3] = q0 ^ q1 ^ q2 ^ q5 ^ q6 ^ r0 ^ r2 ^ r3 ^ r5
+        ^ ROTR16(q0 ^ q1 ^ q3 ^ q5 ^ q6 ^ q7 ^ r0 ^ r3 ^ r5 ^ r7);
+   q[4] = q1 ^ q2 ^ q3 ^ q5 ^ r1 ^ r3 ^ r4 ^ r5 ^ r6 ^ r7
+        ^ ROTR16(q1 ^ q2 ^ q4 ^ q5 ^ q7 ^ r1 ^ r4 ^ r5 ^ r6);
+   q[5] = q2 ^ q3 ^ q4 ^ q6 ^ r2 ^ r4 ^ r5 ^ r6 ^ r7
+        ^ ROTR16(q2 ^ q3 ^ q5 ^ q6 ^ r2 ^ r5 ^ r6 ^ r7);
+   q[6] = q3 ^ q4 ^ q5 ^ q7 ^ r3 ^ r5 ^ r6 ^ r7
+        ^ ROTR16(q3 ^ q4 ^ q6 ^ q7 ^ r3 ^ r6 ^ r7);
+   q[7] = q4 ^ q5 ^ q6 ^ r4 ^ r6 ^ r7 ^ ROTR16(q4 ^ q5 ^ q7 ^ r4 ^ r7);
+}
+
+#undef ROTR8
+#undef ROTR16
+
+static void _bitslice_encrypt(int Nr, const ulong32 *sk, ulong32 *q)
+{
+   int u;
+
+   _add_round_key(q, sk);
+   for (u = 1; u < Nr; u++) {
+      _bitslice_sbox(q);
+      _shift_rows(q);
+      _mix_columns(q);
+      _add_round_key(q, sk + (u << 3));
+   }
+   _bitslice_sbox(q);
+   _shift_rows(q);
+   _add_round_key(q, sk + (Nr << 3));
+}
+
+static void _bitslice_decrypt(int Nr, const ulong32 *sk, ulong32 *q)
+{
+   int u;
+
+   _add_round_key(q, sk + (Nr << 3));
+   for (u = Nr - 1; u > 0; u--) {
+      _inv_shift_rows(q);
+      _bitslice_inv_sbox(q);
+      _add_round_key(q, sk + (u << 3));
+      _inv_mix_columns(q);
+   }
+   _inv_shift_rows(q);
+   _bitslice_inv_sbox(q);
+   _add_round_key(q, sk);
+}
+
+/* Load up to two blocks into the bitsliced state (b1 may be NULL) */
+static void _load_blocks(ulong32 *q, const unsigned char *b0,
+                         const unsigned char *b1)
+{
+   LOAD32L(q[0], b0);
+   LOAD32L(q[2], b0 + 4);
+   LOAD32L(q[4], b0 + 8);
+   LOAD32L(q[6], b0 + 12);
+   if (b1 != NULL) {
+      LOAD32L(q[1], b1);
+      LOAD32L(q[3], b1 + 4);
+      LOAD32L(q[5], b1 + 8);
+      LOAD32L(q[7], b1 + 12);
+   } else {
+      q[1] = q[3] = q[5] = q[7] = 0;
+   }
+   _ortho(q);
+}
+
+static void _store_blocks(ulong32 *q, unsigned char *b0, unsigned char *b1)
+{
+   _ortho(q);
+   STORE32L(q[0], b0);
+   STORE32L(q[2], b0 + 4);
+   STORE32L(q[4], b0 + 8);
+   STORE32L(q[6], b0 + 12);
+   if (b1 != NULL) {
+      STORE32L(q[1], b1);
+      STORE32L(q[3], b1 + 4);
+      STORE32L(q[5], b1 + 8);
+      STORE32L(q[7], b1 + 12);
+   }
+}
+
+static void _xor_block(unsigned char *dst, const unsigned char *a,
+                       const unsigned char *b)
+{
+   int x;
+
+#ifdef LTC_FAST
+   for (x = 0; x < 16; x += sizeof(LTC_FAST_TYPE)) {
+      *(LTC_FAST_TYPE_PTR_CAST(dst + x)) = *(LTC_FAST_TYPE_PTR_CAST(a + x)) ^
+                                          *(LTC_FAST_TYPE_PTR_CAST(b + x));
+   }
+#else
+   for (x = 0; x < 16; x++) {
+      dst[x] = a[x] ^ b[x];
+   }
+#endif
+}
+
+ /**
+    Initialize the constant-time AES block cipher
+    @param key The symmetric key you wish to pass
+    @param keylen The key length in bytes
+    @param num_rounds The number of rounds desired (0 for default)
+    @param skey The key in as scheduled by this function.
+    @return CRYPT_OK if successful
+ */
+int aes_ct_setup(const unsigned char *key, int keylen, int num_rounds, symmetric_key *skey)
+{
+   ulong32 tmp, *sk;
+   ulong32 w[120];
+   int i, j, k, nk, nkf, Nr;
+   static const unsigned char rcon[] = {
+      0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36
+   };
+
+   LTC_ARGCHK(key  != NULL);
+   LTC_ARGCHK(skey != NULL);
+
+   if (keylen != 16 && keylen != 24 && keylen != 32) {
+      return CRYPT_INVALID_KEYSIZE;
+   }
+
+   Nr = 10 + ((keylen/8)-2)*2;
+   if (num_rounds != 0 && num_rounds != Nr) {
+      return CRYPT_INVALID_ROUNDS;
+   }
+
+   skey->aes_ct.Nr = Nr;
+   nk = keylen >> 2;
+   nkf = (Nr + 1) << 2;
+
+   /* expand the key, each word duplicated for both bitslice lanes */
+   tmp = 0;
+   for (i = 0; i < nk; i++) {
+      LOAD32L(tmp, key + (i << 2));
+      w[(i << 1) + 0] = tmp;
+      w[(i << 1) + 1] = tmp;
+   }
+   for (i = nk, j = 0, k = 0; i < nkf; i++) {
+      if (j == 0) {
+         tmp = (tmp << 24) | (tmp >> 8);
+         tmp = _sub_word(tmp) ^ rcon[k];
+      } else if (nk > 6 && j == 4) {
+         tmp = _sub_word(tmp);
+      }
+      tmp ^= w[(i - nk) << 1];
+      w[(i << 1) + 0] = tmp;
+      w[(i << 1) + 1] = tmp;
+      if (++j == nk) {
+         j = 0;
+         k++;
+      }
+   }
+
+   /* convert round keys to the bitsliced representation */
+   sk = skey->aes_ct.sk;
+   for (i = 0; i < nkf; i += 4) {
+      _ortho(w + (i << 1));
+   }
+   for (i = 0, j = 0; i < nkf; i++, j += 2) {
+      ulong32 x, y;
+
+      x = (w[j + 0] & 0x55555555) | (w[j + 1] & 0xAAAAAAAA);
+      y = x;
+      x &= 0x55555555;
+      sk[j + 0] = x | (x << 1);
+      y &= 0xAAAAAAAA;
+      sk[j + 1] = y | (y >> 1);
+   }
+
+   zeromem(w, sizeof(w));
+   return CRYPT_OK;
+}
+
+/**
+  Encrypts a block of text with constant-time AES
+  @param pt The input plaintext (16 bytes)
+  @param ct The output ciphertext (16 bytes)
+  @param skey The key as scheduled
+  @return CRYPT_OK if successful
+*/
+int aes_ct_ecb_encrypt(const unsigned char *pt, unsigned char *ct, symmetric_key *skey)
+{
+   ulong32 q[8];
+
+   LTC_ARGCHK(pt != NULL);
+   LTC_ARGCHK(ct != NULL);
+   LTC_ARGCHK(skey != NULL);
+
+   _load_blocks(q, pt, NULL);
+   _bitslice_encrypt(skey->aes_ct.Nr, skey->aes_ct.sk, q);
+   _store_blocks(q, ct, NULL);
+   return CRYPT_OK;
+}
+
+/**
+  Decrypts a block of text with constant-time AES
+  @param ct The input ciphertext (16 bytes)
+  @param pt The output plaintext (16 bytes)
+  @param skey The key as scheduled
+  @return CRYPT_OK if successful
+*/
+int aes_ct_ecb_decrypt(const unsigned char *ct, unsigned char *pt, symmetric_key *skey)
+{
+   ulong32 q[8];
+
+   LTC_ARGCHK(pt != NULL);
+   LTC_ARGCHK(ct != NULL);
+   LTC_ARGCHK(skey != NULL);
+
+   _load_blocks(q, ct, NULL);
+   _bitslice_decrypt(skey->aes_ct.Nr, skey->aes_ct.sk, q);
+   _store_blocks(q, pt, NULL);
+   return CRYPT_OK;
+}
+
+/**
+  Encrypts blocks in ECB mode, two blocks per bitsliced pass
+  @param pt Plaintext
+  @param ct [out] Ciphertext
+  @param blocks Number of 16-byte blocks
+  @param skey The key as scheduled
+  @return CRYPT_OK if successful
+*/
+int aes_ct_accel_ecb_encrypt(const unsigned char *pt, unsigned char *ct,
+                             unsigned long blocks, symmetric_key *skey)
+{
+   ulong32 q[8];
+
+   LTC_ARGCHK(pt != NULL);
+   LTC_ARGCHK(ct != NULL);
+   LTC_ARGCHK(skey != NULL);
+
+   while (blocks >= 2) {
+      _load_blocks(q, pt, pt + 16);
+      _bitslice_encrypt(skey->aes_ct.Nr, skey->aes_ct.sk, q);
+      _store_blocks(q, ct, ct + 16);
+      pt += 32;
+      ct += 32;
+      blocks -= 2;
+   }
+   if (blocks) {
+      _load_blocks(q, pt, NULL);
+      _bitslice_encrypt(skey->aes_ct.Nr, skey->aes_ct.sk, q);
+      _store_blocks(q, ct, NULL);
+   }
+   return CRYPT_OK;
+}
+
+/**
+  Decrypts blocks in ECB mode, two blocks per bitsliced pass
+  @param ct Ciphertext
+  @param pt [out] Plaintext
+  @param blocks Number of 16-byte blocks
+  @param skey The key as scheduled
+  @return CRYPT_OK if successful
+*/
+int aes_ct_accel_ecb_decrypt(const unsigned char *ct, unsigned char *pt,
+                             unsigned long blocks, symmetric_key *skey)
+{
+   ulong32 q[8];
+
+   LTC_ARGCHK(pt != NULL);
+   LTC_ARGCHK(ct != NULL);
+   LTC_ARGCHK(skey != NULL);
+
+   while (blocks >= 2) {
+      _load_blocks(q, ct, ct + 16);
+      _bitslice_decrypt(skey->aes_ct.Nr, skey->aes_ct.sk, q);
+      _store_blocks(q, pt, pt + 16);
+      pt += 32;
+      ct += 32;
+      blocks -= 2;
+   }
+   if (blocks) {
+      _load_blocks(q, ct, NULL);
+      _bitslice_decrypt(skey->aes_ct.Nr, skey->aes_ct.sk, q);
+      _store_blocks(q, pt, NULL);
+   }
+   return CRYPT_OK;
+}
+
+/**
+  CBC encryption; inherently serial, so this is the single-block path
+  @param pt Plaintext
+  @param ct [out] Ciphertext
+  @param blocks Number of 16-byte blocks
+  @param IV [in/out] Chaining value
+  @param skey The key as scheduled
+  @return CRYPT_OK if successful
+*/
+int aes_ct_accel_cbc_encrypt(const unsigned char *pt, unsigned char *ct,
+                             unsigned long blocks, unsigned char *IV,
+                             symmetric_key *skey)
+{
+   ulong32 q[8];
+   unsigned char buf[16];
+
+   LTC_ARGCHK(pt != NULL);
+   LTC_ARGCHK(ct != NULL);
+   LTC_ARGCHK(IV != NULL);
+   LTC_ARGCHK(skey != NULL);
+
+   while (blocks--) {
+      _xor_block(buf, pt, IV);
+      _load_blocks(q, buf, NULL);
+      _bitslice_encrypt(skey->aes_ct.Nr, skey->aes_ct.sk, q);
+      _store_blocks(q, IV, NULL);
+      XMEMCPY(ct, IV, 16);
+      pt += 16;
+      ct += 16;
+   }
+   return CRYPT_OK;
+}
+
+/**
+  CBC decryption, two blocks per bitsliced pass
+  @param ct Ciphertext
+  @param pt [out] Plaintext
+  @param blocks Number of 16-byte blocks
+  @param IV [in/out] Chaining value
+  @param skey The key as scheduled
+  @return CRYPT_OK if successful
+*/
+int aes_ct_accel_cbc_decrypt(const unsigned char *ct, unsigned char *pt,
+                             unsigned long blocks, unsigned char *IV,
+                             symmetric_key *skey)
+{
+   ulong32 q[8];
+   unsigned char tmp[32], ivn[16];
+
+   LTC_ARGCHK(pt != NULL);
+   LTC_ARGCHK(ct != NULL);
+   LTC_ARGCHK(IV != NULL);
+   LTC_ARGCHK(skey != NULL);
+
+   /* ct and pt may alias, so keep the last ciphertext before overwriting */
+   while (blocks >= 2) {
+      XMEMCPY(ivn, ct + 16, 16);
+      _load_blocks(q, ct, ct + 16);
+      _bitslice_decrypt(skey->aes_ct.Nr, skey->aes_ct.sk, q);
+      _store_blocks(q, tmp, tmp + 16);
+      _xor_block(tmp + 16, tmp + 16, ct);
+      _xor_block(pt, tmp, IV);
+      XMEMCPY(pt + 16, tmp + 16, 16);
+      XMEMCPY(IV, ivn, 16);
+      pt += 32;
+      ct += 32;
+      blocks -= 2;
+   }
+   if (blocks) {
+      XMEMCPY(ivn, ct, 16);
+      _load_blocks(q, ct, NULL);
+      _bitslice_decrypt(skey->aes_ct.Nr, skey->aes_ct.sk, q);
+      _store_blocks(q, tmp, NULL);
+      _xor_block(pt, tmp, IV);
+      XMEMCPY(IV, ivn, 16);
+   }
+   return CRYPT_OK;
+}
+
+#ifdef LTC_CTR_MODE
+static void _ctr_inc(unsigned char *ctr, int mode)
+{
+   int x;
+
+   if (mode == CTR_COUNTER_LITTLE_ENDIAN) {
+      for (x = 0; x < 16; x++) {
+         ctr[x] = (ctr[x] + 1) & 255;
+         if (ctr[x] != 0) {
+            break;
+         }
+      }
+   } else {
+      for (x = 15; x >= 0; x--) {
+         ctr[x] = (ctr[x] + 1) & 255;
+         if (ctr[x] != 0) {
+            break;
+         }
+      }
+   }
+}
+
+/**
+  CTR encryption, two counter blocks per bitsliced pass.  Follows the
+  ctr_encrypt() convention: the counter is incremented before each block
+  is encrypted.  The whole 16-byte block is the counter; ctr_encrypt() only
+  calls this for counters that span the block.
+  @param pt Plaintext
+  @param ct [out] Ciphertext
+  @param blocks Number of 16-byte blocks
+  @param IV [in/out] Counter
+  @param mode CTR_COUNTER_LITTLE_ENDIAN or CTR_COUNTER_BIG_ENDIAN
+  @param skey The key as scheduled
+  @return CRYPT_OK if successful
+*/
+int aes_ct_accel_ctr_encrypt(const unsigned char *pt, unsigned char *ct,
+                             unsigned long blocks, unsigned char *IV,
+                             int mode, symmetric_key *skey)
+{
+   ulong32 q[8];
+   unsigned char c1[16], ks[32];
+
+   LTC_ARGCHK(pt != NULL);
+   LTC_ARGCHK(ct != NULL);
+   LTC_ARGCHK(IV != NULL);
+   LTC_ARGCHK(skey != NULL);
+
+   while (blocks >= 2) {
+      _ctr_inc(IV, mode);
+      XMEMCPY(c1, IV, 16);
+      _ctr_inc(IV, mode);
+      _load_blocks(q, c1, IV);
+      _bitslice_encrypt(skey->aes_ct.Nr, skey->aes_ct.sk, q);
+      _store_blocks(q, ks, ks + 16);
+      _xor_block(ct, pt, ks);
+      _xor_block(ct + 16, pt + 16, ks + 16);
+      pt += 32;
+      ct += 32;
+      blocks -= 2;
+   }
+   if (blocks) {
+      _ctr_inc(IV, mode);
+      _load_blocks(q, IV, NULL);
+      _bitslice_encrypt(skey->aes_ct.Nr, skey->aes_ct.sk, q);
+      _store_blocks(q, ks, NULL);
+      _xor_block(ct, pt, ks);
+   }
+   return CRYPT_OK;
+}
+#endif /* LTC_CTR_MODE */
+
+#ifdef LTC_XTS_MODE
+static int _xts_crypt(const unsigned char *in, unsigned char *out,
+                      unsigned long blocks, unsigned char *tweak,
+                      symmetric_key *skey1, symmetric_key *skey2, int enc)
+{
+   ulong32 q[8];
+   unsigned char T[32], buf[32];
+
+   LTC_ARGCHK(in != NULL);
+   LTC_ARGCHK(out != NULL);
+   LTC_ARGCHK(tweak != NULL);
+   LTC_ARGCHK(skey1 != NULL);
+   LTC_ARGCHK(skey2 != NULL);
+
+   /* encrypt the tweak, the caller expects it back in that form */
+   aes_ct_ecb_encrypt(tweak, T, skey2);
+
+   while (blocks >= 2) {
+      XMEMCPY(T + 16, T, 16);
+      xts_mult_x(T + 16);
+      _xor_block(buf, in, T);
+      _xor_block(buf + 16, in + 16, T + 16);
+      _load_blocks(q, buf, buf + 16);
+      if (enc) {
+         _bitslice_encrypt(skey1->aes_ct.Nr, skey1->aes_ct.sk, q);
+      } else {
+         _bitslice_decrypt(skey1->aes_ct.Nr, skey1->aes_ct.sk, q);
+      }
+      _store_blocks(q, buf, buf + 16);
+      _xor_block(out, buf, T);
+      _xor_block(out + 16, buf + 16, T + 16);
+      XMEMCPY(T, T + 16, 16);
+      xts_mult_x(T);
+      in += 32;
+      out += 32;
+      blocks -= 2;
+   }
+   if (blocks) {
+      _xor_block(buf, in, T);
+      _load_blocks(q, buf, NULL);
+      if (enc) {
+         _bitslice_encrypt(skey1->aes_ct.Nr, skey1->aes_ct.sk, q);
+      } else {
+         _bitslice_decrypt(skey1->aes_ct.Nr, skey1->aes_ct.sk, q);
+      }
+      _store_blocks(q, buf, NULL);
+      _xor_block(out, buf, T);
+      xts_mult_x(T);
+   }
+
+   XMEMCPY(tweak, T, 16);
+   return CRYPT_OK;
+}
+
+/**
+  XTS encryption of whole blocks, two blocks per bitsliced pass
+  @param pt Plaintext
+  @param ct [out] Ciphertext
+  @param blocks Number of 16-byte blocks
+  @param tweak [in/out] Tweak; encrypted and advanced on return
+  @param skey1 Data key
+  @param skey2 Tweak key
+  @return CRYPT_OK if successful
+*/
+int aes_ct_accel_xts_encrypt(const unsigned char *pt, unsigned char *ct,
+                             unsigned long blocks, unsigned char *tweak,
+                             symmetric_key *skey1, symmetric_key *skey2)
+{
+   return _xts_crypt(pt, ct, blocks, tweak, skey1, skey2, 1);
+}
+
+/**
+  XTS decryption of whole blocks, two blocks per bitsliced pass
+  @param ct Ciphertext
+  @param pt [out] Plaintext
+  @param blocks Number of 16-byte blocks
+  @param tweak [in/out] Tweak; encrypted and advanced on return
+  @param skey1 Data key
+  @param skey2 Tweak key
+  @return CRYPT_OK if successful
+*/
+int aes_ct_accel_xts_decrypt(const unsigned char *ct, unsigned char *pt,
+                             unsigned long blocks, unsigned char *tweak,
+                             symmetric_key *skey1, symmetric_key *skey2)
+{
+   return _xts_crypt(ct, pt, blocks, tweak, skey1, skey2, 0);
+}
+#endif /* LTC_XTS_MODE */
+
+#if defined(LTC_TEST) && defined(LTC_CTR_MODE)
+/*
+  Run CTR test vectors through ctr_encrypt() with aes_ct registered, as a
+  16 byte call followed by a 36 byte one.  The second call starts on an
+  empty pad, so it takes the accel_ctr_encrypt hook for two blocks and the
+  generic path for the 4 byte tail.  The second vector uses a 32-bit
+  counter that wraps inside the hooked blocks.
+*/
+static int _ctr_test(void)
+{
+   static const struct {
+      int mode;
+      unsigned char IV[16], ct[52];
+   } tests[] = {
+      { CTR_COUNTER_BIG_ENDIAN,
+        { 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+          0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff },
+        {
+        0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26,
+        0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+        0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff,
+        0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+        0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e,
+        0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+        0x1e, 0x03, 0x1d, 0xda }
+      }, {
+        CTR_COUNTER_BIG_ENDIAN | 4,
+        { 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+          0xf8, 0xf9, 0xfa, 0xfb, 0xff, 0xff, 0xff, 0xfe },
+        {
+        0x44, 0x9c, 0x73, 0x73, 0x03, 0x54, 0xb3, 0xab,
+        0xae, 0x24, 0x55, 0x50, 0xa2, 0x64, 0x34, 0x6f,
+        0x92, 0xcc, 0xea, 0xd4, 0x7e, 0xdb, 0x97, 0x6f,
+        0xe6, 0x1d, 0x00, 0xac, 0x4a, 0xce, 0x0c, 0x93,
+        0x79, 0xec, 0x8d, 0x15, 0xfa, 0xc4, 0x1e, 0x35,
+        0xfb, 0x00, 0x0a, 0x1a, 0x00, 0xb4, 0x54, 0x88,
+        0xb5, 0xde, 0xb2, 0x60 }
+      }
+   };
+   /* SP 800-38A F.5.1 key and plaintext */
+   static const unsigned char key[16] = {
+      0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+      0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+   };
+   static const unsigned char pt[52] = {
+      0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+      0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+      0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+      0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+      0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+      0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+      0xf6, 0x9f, 0x24, 0x45
+   };
+   symmetric_CTR ctr;
+   unsigned char buf[52];
+   int err, idx, x, i, registered = 1;
+
+   for (x = 0; x < TAB_SIZE; x++) {
+      if (cipher_descriptor[x].name != NULL &&
+          !XMEMCMP(&cipher_descriptor[x], &aes_ct_desc, sizeof(aes_ct_desc))) {
+         registered = 0;
+         break;
+      }
+   }
+   if ((idx = register_cipher(&aes_ct_desc)) < 0) {
+      return CRYPT_NOP;
+   }
+
+   err = CRYPT_OK;
+   for (i = 0; err == CRYPT_OK && i < (int)(sizeof(tests)/sizeof(tests[0])); i++) {
+      if ((err = ctr_start(idx, tests[i].IV, key, 16, 0, tests[i].mode, &ctr)) != CRYPT_OK) {
+         break;
+      }
+      if ((err = ctr_encrypt(pt, buf, 16, &ctr)) == CRYPT_OK) {
+         err = ctr_encrypt(pt + 16, buf + 16, 36, &ctr);
+      }
+      ctr_done(&ctr);
+      if (err == CRYPT_OK &&
+          compare_testvector(buf, 52, tests[i].ct, 52, "AES-CT CTR", i)) {
+         err = CRYPT_FAIL_TESTVECTOR;
+      }
+   }
+
+   if (registered) {
+      unregister_cipher(&aes_ct_desc);
+   }
+   return err;
+}
+#endif /* LTC_TEST && LTC_CTR_MODE */
+
+/**
+  Performs a self-test of the constant-time AES block cipher
+  @return CRYPT_OK if functional, CRYPT_NOP if self-test has been disabled
+*/
+int aes_ct_test(void)
+{
+#ifndef LTC_TEST
+   return CRYPT_NOP;
+#else
+   static const struct {
+      int keylen;
+      unsigned char key[32], pt[16], ct[16];
+   } tests[] = {
+      { 16,
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+          0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f },
+        { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+          0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff },
+        { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+          0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a }
+      }, {
+        24,
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+          0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+          0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17 },
+        { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+          0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff },
+        { 0xdd, 0xa9, 0x7c, 0xa4, 0x86, 0x4c, 0xdf, 0xe0,
+          0x6e, 0xaf, 0x70, 0xa0, 0xec, 0x0d, 0x71, 0x91 }
+      }, {
+        32,
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+          0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+          0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+          0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f },
+        { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+          0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff },
+        { 0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+          0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89 }
+      }
+   };
+   symmetric_key key;
+   unsigned char tmp[4][16];
+   int err, i;
+
+   for (i = 0; i < (int)(sizeof(tests)/sizeof(tests[0])); i++) {
+      zeromem(&key, sizeof(key));
+      if ((err = aes_ct_setup(tests[i].key, tests[i].keylen, 0, &key)) != CRYPT_OK) {
+         return err;
+      }
+
+      aes_ct_ecb_encrypt(tests[i].pt, tmp[0], &key);
+      aes_ct_ecb_decrypt(tmp[0], tmp[1], &key);
+      if (compare_testvector(tmp[0], 16, tests[i].ct, 16, "AES-CT Encrypt", i) ||
+          compare_testvector(tmp[1], 16, tests[i].pt, 16, "AES-CT Decrypt", i)) {
+         return CRYPT_FAIL_TESTVECTOR;
+      }
+
+      /* both bitslice lanes must agree with the single-block path */
+      XMEMCPY(tmp[2], tests[i].pt, 16);
+      XMEMCPY(tmp[3], tests[i].pt, 16);
+      aes_ct_accel_ecb_encrypt(tmp[2], tmp[2], 2, &key);
+      if (compare_testvector(tmp[2], 16, tests[i].ct, 16, "AES-CT Encrypt x2", i) ||
+          compare_testvector(tmp[3], 16, tests[i].ct, 16, "AES-CT Encrypt x2", i)) {
+         return CRYPT_FAIL_TESTVECTOR;
+      }
+      aes_ct_accel_ecb_decrypt(tmp[2], tmp[2], 2, &key);
+      if (compare_testvector(tmp[2], 16, tests[i].pt, 16, "AES-CT Decrypt x2", i) ||
+          compare_testvector(tmp[3], 16, tests[i].pt, 16, "AES-CT Decrypt x2", i)) {
+         return CRYPT_FAIL_TESTVECTOR;
+      }
+   }
+#ifdef LTC_CTR_MODE
+   if ((err = _ctr_test()) != CRYPT_OK && err != CRYPT_NOP) {
+      return err;
+   }
+#endif
+   return CRYPT_OK;
+#endif
+}
+
+/** Terminate the context
+   @param skey    The scheduled key
+*/
+void aes_ct_done(symmetric_key *skey)
+{
+   LTC_UNUSED_PARAM(skey);
+}
+
+/**
+  Gets suitable key size
+  @param keysize [in/out] The length of the recommended key (in bytes).  This function will store the suitable size back in this variable.
+  @return CRYPT_OK if the input key size is acceptable.
+*/
+int aes_ct_keysize(int *keysize)
+{
+   return rijndael_keysize(keysize);
+}
+
+#endif /* LTC_RIJNDAEL_CT */
@@ -1,3 +1,4 @@
 cflags-y += -Wno-unused-parameter
 
 srcs-$(CFG_CRYPTO_AES) += aes.c
+srcs-$(CFG_CRYPTO_AES_CT) += aes_ct.c
@@ -27,9 +27,6 @@ int gcm_add_aad(gcm_state *gcm,
 {
    unsigned long x;
    int           err;
-#ifdef LTC_FAST
-   unsigned long y;
-#endif
 
    LTC_ARGCHK(gcm    != NULL);
    if (adatalen > 0) {
@@ -88,18 +85,13 @@ int gcm_add_aad(gcm_state *gcm,
    }
 
    x = 0;
-#ifdef LTC_FAST
    if (gcm->buflen == 0) {
-      for (x = 0; x < (adatalen & ~15); x += 16) {
-          for (y = 0; y < 16; y += sizeof(LTC_FAST_TYPE)) {
-              *(LTC_FAST_TYPE_PTR_CAST(&gcm->X[y])) ^= *(LTC_FAST_TYPE_PTR_CAST(&adata[x + y]));
-          }
-          gcm_mult_h(gcm, gcm->X);
-          gcm->totlen += 128;
-      }
+      /* whole blocks go straight through GHASH */
+      x = adatalen & ~15UL;
+      gcm_ghash(gcm, adata, x >> 4);
+      gcm->totlen += (ulong64)x * 8;
       adata += x;
    }
-#endif
 
 
    /* start adding AAD data to the state */
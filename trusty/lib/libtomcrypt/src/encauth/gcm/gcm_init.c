@@ -70,7 +70,9 @@ int gcm_init(gcm_state *gcm, int cipher,
    gcm->totlen   = 0;
    gcm->pttotlen = 0;
 
-#ifdef LTC_GCM_TABLES
+#if defined(LTC_GCM_TABLES_4BIT) || defined(LTC_GCM_TABLES_8BIT)
+   gcm_gen_table(gcm);
+#elif defined(LTC_GCM_TABLES)
    /* setup tables */
 
    /* generate the first table as it has no shifting (from which we make the other tables) */
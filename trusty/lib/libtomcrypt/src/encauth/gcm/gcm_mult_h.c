@@ -14,6 +14,131 @@
 #include "tomcrypt.h"
 
 #if defined(LTC_GCM_MODE)
+
+#if defined(LTC_GCM_TABLES_4BIT) || defined(LTC_GCM_TABLES_8BIT)
+/*
+ * Shoup's method with a per-key table of multiples of H, kept as four
+ * big-endian 32-bit words so the inner loop is plain word shifts and XORs.
+ * The 4-bit table is 256 bytes per key (plus the 64-byte reduction table
+ * below), the 8-bit table is 4 KB per key and reuses gcm_shift_table.
+ */
+
+#ifdef LTC_GCM_TABLES_4BIT
+/* reduction of the nibble shifted out, in the top 16 bits of the result */
+static const ulong32 _gcm_last4[16] = {
+   0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+   0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+#define GCM_HT_SIZE   16
+#define GCM_HT_TOP    8
+#else
+#define GCM_HT_SIZE   256
+#define GCM_HT_TOP    128
+#endif
+
+/**
+  Build the per-key multiplication table from gcm->H
+  @param gcm   The GCM state which holds the H value
+ */
+void gcm_gen_table(gcm_state *gcm)
+{
+   ulong32 v0, v1, v2, v3, t;
+   int i, j;
+
+   LOAD32H(v0, gcm->H);
+   LOAD32H(v1, gcm->H + 4);
+   LOAD32H(v2, gcm->H + 8);
+   LOAD32H(v3, gcm->H + 12);
+
+   /* the most significant index bit is the coefficient of x^0 */
+   gcm->HT[GCM_HT_TOP][0] = v0;
+   gcm->HT[GCM_HT_TOP][1] = v1;
+   gcm->HT[GCM_HT_TOP][2] = v2;
+   gcm->HT[GCM_HT_TOP][3] = v3;
+   gcm->HT[0][0] = gcm->HT[0][1] = gcm->HT[0][2] = gcm->HT[0][3] = 0;
+
+   /* multiply by x, branch free since H is secret */
+   for (i = GCM_HT_TOP >> 1; i > 0; i >>= 1) {
+      t  = (0 - (v3 & 1)) & 0xe1000000UL;
+      v3 = (v3 >> 1) | (v2 << 31);
+      v2 = (v2 >> 1) | (v1 << 31);
+      v1 = (v1 >> 1) | (v0 << 31);
+      v0 = (v0 >> 1) ^ t;
+      gcm->HT[i][0] = v0;
+      gcm->HT[i][1] = v1;
+      gcm->HT[i][2] = v2;
+      gcm->HT[i][3] = v3;
+   }
+
+   /* the rest follows by linearity */
+   for (i = 2; i <= GCM_HT_TOP; i <<= 1) {
+      for (j = 1; j < i; j++) {
+         gcm->HT[i + j][0] = gcm->HT[i][0] ^ gcm->HT[j][0];
+         gcm->HT[i + j][1] = gcm->HT[i][1] ^ gcm->HT[j][1];
+         gcm->HT[i + j][2] = gcm->HT[i][2] ^ gcm->HT[j][2];
+         gcm->HT[i + j][3] = gcm->HT[i][3] ^ gcm->HT[j][3];
+      }
+   }
+}
+
+/* v = v * H, v held as four big-endian words */
+static void _gcm_mult_table(ulong32 (*HT)[4], ulong32 *v)
+{
+   ulong32 z0, z1, z2, z3, rem;
+   const ulong32 *h;
+   int i;
+   unsigned b;
+
+#ifdef LTC_GCM_TABLES_4BIT
+   h = HT[v[3] & 0xf];
+   z0 = h[0]; z1 = h[1]; z2 = h[2]; z3 = h[3];
+
+   for (i = 15; i >= 0; i--) {
+      b = (v[i >> 2] >> (24 - ((i & 3) << 3))) & 0xff;
+
+      if (i != 15) {
+         rem = z3 & 0xf;
+         z3 = (z3 >> 4) | (z2 << 28);
+         z2 = (z2 >> 4) | (z1 << 28);
+         z1 = (z1 >> 4) | (z0 << 28);
+         z0 = (z0 >> 4) ^ (_gcm_last4[rem] << 16);
+         h = HT[b & 0xf];
+         z0 ^= h[0]; z1 ^= h[1]; z2 ^= h[2]; z3 ^= h[3];
+      }
+
+      rem = z3 & 0xf;
+      z3 = (z3 >> 4) | (z2 << 28);
+      z2 = (z2 >> 4) | (z1 << 28);
+      z1 = (z1 >> 4) | (z0 << 28);
+      z0 = (z0 >> 4) ^ (_gcm_last4[rem] << 16);
+      h = HT[b >> 4];
+      z0 ^= h[0]; z1 ^= h[1]; z2 ^= h[2]; z3 ^= h[3];
+   }
+#else
+   h = HT[v[3] & 0xff];
+   z0 = h[0]; z1 = h[1]; z2 = h[2]; z3 = h[3];
+
+   for (i = 14; i >= 0; i--) {
+      b = (v[i >> 2] >> (24 - ((i & 3) << 3))) & 0xff;
+
+      rem = z3 & 0xff;
+      z3 = (z3 >> 8) | (z2 << 24);
+      z2 = (z2 >> 8) | (z1 << 24);
+      z1 = (z1 >> 8) | (z0 << 24);
+      z0 = (z0 >> 8) ^ ((ulong32)gcm_shift_table[rem << 1] << 24) ^
+                       ((ulong32)gcm_shift_table[(rem << 1) + 1] << 16);
+      h = HT[b];
+      z0 ^= h[0]; z1 ^= h[1]; z2 ^= h[2]; z3 ^= h[3];
+   }
+#endif
+
+   v[0] = z0;
+   v[1] = z1;
+   v[2] = z2;
+   v[3] = z3;
+}
+#endif /* LTC_GCM_TABLES_4BIT || LTC_GCM_TABLES_8BIT */
+
 /**
   GCM multiply by H
   @param gcm   The GCM state which holds the H value
@@ -21,6 +146,19 @@
  */
 void gcm_mult_h(gcm_state *gcm, unsigned char *I)
 {
+#if defined(LTC_GCM_TABLES_4BIT) || defined(LTC_GCM_TABLES_8BIT)
+   ulong32 v[4];
+
+   LOAD32H(v[0], I);
+   LOAD32H(v[1], I + 4);
+   LOAD32H(v[2], I + 8);
+   LOAD32H(v[3], I + 12);
+   _gcm_mult_table(gcm->HT, v);
+   STORE32H(v[0], I);
+   STORE32H(v[1], I + 4);
+   STORE32H(v[2], I + 8);
+   STORE32H(v[3], I + 12);
+#else
    unsigned char T[16];
 #ifdef LTC_GCM_TABLES
    int x;
@@ -49,6 +187,48 @@ void gcm_mult_h(gcm_state *gcm, unsigned char *I)
    gcm_gf_mult(gcm->H, I, T);
 #endif
    XMEMCPY(I, T, 16);
+#endif /* LTC_GCM_TABLES_4BIT || LTC_GCM_TABLES_8BIT */
+}
+
+/**
+  GHASH whole blocks into the accumulator: X = (X ^ in_i) * H for each block
+  @param gcm     The GCM state
+  @param in      The data to hash
+  @param blocks  The number of 16-byte blocks in the input
+ */
+void gcm_ghash(gcm_state *gcm, const unsigned char *in, unsigned long blocks)
+{
+#if defined(LTC_GCM_TABLES_4BIT) || defined(LTC_GCM_TABLES_8BIT)
+   ulong32 v[4], t;
+
+   /* keep the accumulator in registers across the whole run */
+   LOAD32H(v[0], gcm->X);
+   LOAD32H(v[1], gcm->X + 4);
+   LOAD32H(v[2], gcm->X + 8);
+   LOAD32H(v[3], gcm->X + 12);
+   while (blocks--) {
+      LOAD32H(t, in);      v[0] ^= t;
+      LOAD32H(t, in + 4);  v[1] ^= t;
+      LOAD32H(t, in + 8);  v[2] ^= t;
+      LOAD32H(t, in + 12); v[3] ^= t;
+      _gcm_mult_table(gcm->HT, v);
+      in += 16;
+   }
+   STORE32H(v[0], gcm->X);
+   STORE32H(v[1], gcm->X + 4);
+   STORE32H(v[2], gcm->X + 8);
+   STORE32H(v[3], gcm->X + 12);
+#else
+   int x;
+
+   while (blocks--) {
+      for (x = 0; x < 16; x++) {
+         gcm->X[x] ^= in[x];
+      }
+      gcm_mult_h(gcm, gcm->X);
+      in += 16;
+   }
+#endif
 }
 #endif
 
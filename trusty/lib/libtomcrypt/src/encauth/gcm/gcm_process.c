@@ -15,6 +15,79 @@
 
 #ifdef LTC_GCM_MODE
 
+/* number of counter blocks encrypted per cipher call in the block path */
+#define GCM_STITCH_BLOCKS 8
+
+/*
+  Block path: encrypt the counters for a run of blocks in one cipher call,
+  apply the key stream and GHASH the ciphertext of the whole run at once.
+  Entered with buflen == 0 and gcm->buf holding E(Y) for the first block,
+  left in the same state for the block after the last one.
+ */
+static int _gcm_process_blocks(gcm_state *gcm,
+                               unsigned char *pt, unsigned char *ct,
+                               unsigned long blocks, int direction)
+{
+   const struct ltc_cipher_descriptor *desc = &cipher_descriptor[gcm->cipher];
+   unsigned char ctr[GCM_STITCH_BLOCKS][16];
+   unsigned char ks[GCM_STITCH_BLOCKS + 1][16];
+   unsigned long n, i, y;
+   int           z, err = CRYPT_OK;
+
+   while (blocks) {
+      n = MIN(blocks, GCM_STITCH_BLOCKS);
+
+      /* counters for the rest of this run and the first block of the next */
+      for (i = 0; i < n; i++) {
+         for (z = 15; z >= 12; z--) {
+            if (++gcm->Y[z] & 255) { break; }
+         }
+         XMEMCPY(ctr[i], gcm->Y, 16);
+      }
+      XMEMCPY(ks[0], gcm->buf, 16);
+      if (desc->accel_ecb_encrypt != NULL) {
+         err = desc->accel_ecb_encrypt(ctr[0], ks[1], n, &gcm->K);
+      } else {
+         for (i = 0; i < n && err == CRYPT_OK; i++) {
+            err = desc->ecb_encrypt(ctr[i], ks[i + 1], &gcm->K);
+         }
+      }
+      if (err != CRYPT_OK) {
+         break;
+      }
+
+      if (direction == GCM_ENCRYPT) {
+         for (i = 0; i < n; i++) {
+            for (y = 0; y < 16; y++) {
+               ct[y] = pt[y] ^ ks[i][y];
+            }
+            pt += 16;
+            ct += 16;
+         }
+         gcm_ghash(gcm, ct - n * 16, n);
+      } else {
+         /* hash first, pt and ct may overlap */
+         gcm_ghash(gcm, ct, n);
+         for (i = 0; i < n; i++) {
+            for (y = 0; y < 16; y++) {
+               pt[y] = ct[y] ^ ks[i][y];
+            }
+            pt += 16;
+            ct += 16;
+         }
+      }
+
+      XMEMCPY(gcm->buf, ks[n], 16);
+      gcm->pttotlen += (ulong64)n * 128;
+      blocks -= n;
+   }
+
+#ifdef LTC_CLEAN_STACK
+   zeromem(ks, sizeof(ks));
+#endif
+   return err;
+}
+
 /**
   Process plaintext/ciphertext through GCM
   @param gcm       The GCM state
@@ -83,47 +156,12 @@ int gcm_process(gcm_state *gcm,
    }
 
    x = 0;
-#ifdef LTC_FAST
-   if (gcm->buflen == 0) {
-      if (direction == GCM_ENCRYPT) {
-         for (x = 0; x < (ptlen & ~15); x += 16) {
-             /* ctr encrypt */
-             for (y = 0; y < 16; y += sizeof(LTC_FAST_TYPE)) {
-                 *(LTC_FAST_TYPE_PTR_CAST(&ct[x + y])) = *(LTC_FAST_TYPE_PTR_CAST(&pt[x+y])) ^ *(LTC_FAST_TYPE_PTR_CAST(&gcm->buf[y]));
-                 *(LTC_FAST_TYPE_PTR_CAST(&gcm->X[y])) ^= *(LTC_FAST_TYPE_PTR_CAST(&ct[x+y]));
-             }
-             /* GMAC it */
-             gcm->pttotlen += 128;
-             gcm_mult_h(gcm, gcm->X);
-             /* increment counter */
-             for (y = 15; y >= 12; y--) {
-                 if (++gcm->Y[y] & 255) { break; }
-             }
-             if ((err = cipher_descriptor[gcm->cipher].ecb_encrypt(gcm->Y, gcm->buf, &gcm->K)) != CRYPT_OK) {
-                return err;
-             }
-         }
-      } else {
-         for (x = 0; x < (ptlen & ~15); x += 16) {
-             /* ctr encrypt */
-             for (y = 0; y < 16; y += sizeof(LTC_FAST_TYPE)) {
-                 *(LTC_FAST_TYPE_PTR_CAST(&gcm->X[y])) ^= *(LTC_FAST_TYPE_PTR_CAST(&ct[x+y]));
-                 *(LTC_FAST_TYPE_PTR_CAST(&pt[x + y])) = *(LTC_FAST_TYPE_PTR_CAST(&ct[x+y])) ^ *(LTC_FAST_TYPE_PTR_CAST(&gcm->buf[y]));
-             }
-             /* GMAC it */
-             gcm->pttotlen += 128;
-             gcm_mult_h(gcm, gcm->X);
-             /* increment counter */
-             for (y = 15; y >= 12; y--) {
-                 if (++gcm->Y[y] & 255) { break; }
-             }
-             if ((err = cipher_descriptor[gcm->cipher].ecb_encrypt(gcm->Y, gcm->buf, &gcm->K)) != CRYPT_OK) {
-                return err;
-             }
-         }
+   if (gcm->buflen == 0 && ptlen >= 16) {
+      if ((err = _gcm_process_blocks(gcm, pt, ct, ptlen >> 4, direction)) != CRYPT_OK) {
+         return err;
       }
+      x = ptlen & ~15UL;
    }
-#endif
 
    /* process text */
    for (; x < ptlen; x++) {
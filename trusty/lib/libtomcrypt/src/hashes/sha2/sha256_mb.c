@@ -0,0 +1,246 @@
+/* LibTomCrypt, modular cryptographic library -- Tom St Denis
+ *
+ * LibTomCrypt is a library that provides various cryptographic
+ * algorithms in a highly modular and flexible manner.
+ *
+ * The library is free for all purposes without any express
+ * guarantee it works.
+ */
+#include "tomcrypt.h"
+
+/**
+  @file sha256_mb.c
+  Multi-buffer LTC_SHA256: hashes several independent messages with the
+  compression rounds of SHA256_MB_LANES messages interleaved.
+*/
+
+#ifdef LTC_SHA256
+
+/* two lanes keep both working states in registers on a 32-register core */
+#define SHA256_MB_LANES 2
+
+static const ulong32 K[64] = {
+    0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL, 0x3956c25bUL,
+    0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL, 0xd807aa98UL, 0x12835b01UL,
+    0x243185beUL, 0x550c7dc3UL, 0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL,
+    0xc19bf174UL, 0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL,
+    0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL, 0x983e5152UL,
+    0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL, 0xc6e00bf3UL, 0xd5a79147UL,
+    0x06ca6351UL, 0x14292967UL, 0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL,
+    0x53380d13UL, 0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+    0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL, 0xd192e819UL,
+    0xd6990624UL, 0xf40e3585UL, 0x106aa070UL, 0x19a4c116UL, 0x1e376c08UL,
+    0x2748774cUL, 0x34b0bcb5UL, 0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL,
+    0x682e6ff3UL, 0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL,
+    0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+};
+
+/** The SHA-256 initial hash value, for use as the iv of sha256_mb_memory() */
+const ulong32 sha256_mb_iv[8] = {
+    0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+    0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL
+};
+
+/* Various logical functions */
+#define Ch(x,y,z)       (z ^ (x & (y ^ z)))
+#define Maj(x,y,z)      (((x | y) & z) | (x & y))
+#define S(x, n)         RORc((x),(n))
+#define R(x, n)         (((x)&0xFFFFFFFFUL)>>(n))
+#define Sigma0(x)       (S(x, 2) ^ S(x, 13) ^ S(x, 22))
+#define Sigma1(x)       (S(x, 6) ^ S(x, 11) ^ S(x, 25))
+#define Gamma0(x)       (S(x, 7) ^ S(x, 18) ^ R(x, 3))
+#define Gamma1(x)       (S(x, 17) ^ S(x, 19) ^ R(x, 10))
+
+/*
+ * One round for both lanes. The two dependency chains are independent so a
+ * single-issue in-order core can schedule one lane's ALU ops into the other
+ * lane's load and rotate latencies.
+ */
+#define RND2(a,b,c,d,e,f,g,h,i)                                   \
+     t0 = S0[h] + Sigma1(S0[e]) + Ch(S0[e], S0[f], S0[g]) + K[i] + W0[i]; \
+     u0 = S1[h] + Sigma1(S1[e]) + Ch(S1[e], S1[f], S1[g]) + K[i] + W1[i]; \
+     t1 = Sigma0(S0[a]) + Maj(S0[a], S0[b], S0[c]);               \
+     u1 = Sigma0(S1[a]) + Maj(S1[a], S1[b], S1[c]);               \
+     S0[d] += t0;                                                 \
+     S1[d] += u0;                                                 \
+     S0[h]  = t0 + t1;                                            \
+     S1[h]  = u0 + u1;
+
+/* compress one 512-bit block in each of the two lanes */
+static void _sha256_mb_compress(ulong32 *st0, const unsigned char *buf0,
+                                ulong32 *st1, const unsigned char *buf1)
+{
+    ulong32 S0[8], S1[8], W0[64], W1[64], t0, t1, u0, u1;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        S0[i] = st0[i];
+        S1[i] = st1[i];
+    }
+
+    for (i = 0; i < 16; i++) {
+        LOAD32H(W0[i], buf0 + (4*i));
+        LOAD32H(W1[i], buf1 + (4*i));
+    }
+
+    for (i = 16; i < 64; i++) {
+        W0[i] = Gamma1(W0[i - 2]) + W0[i - 7] + Gamma0(W0[i - 15]) + W0[i - 16];
+        W1[i] = Gamma1(W1[i - 2]) + W1[i - 7] + Gamma0(W1[i - 15]) + W1[i - 16];
+    }
+
+    for (i = 0; i < 64; i += 8) {
+        RND2(0,1,2,3,4,5,6,7,i+0);
+        RND2(7,0,1,2,3,4,5,6,i+1);
+        RND2(6,7,0,1,2,3,4,5,i+2);
+        RND2(5,6,7,0,1,2,3,4,i+3);
+        RND2(4,5,6,7,0,1,2,3,i+4);
+        RND2(3,4,5,6,7,0,1,2,i+5);
+        RND2(2,3,4,5,6,7,0,1,i+6);
+        RND2(1,2,3,4,5,6,7,0,i+7);
+    }
+
+    for (i = 0; i < 8; i++) {
+        st0[i] += S0[i];
+        st1[i] += S1[i];
+    }
+
+#ifdef LTC_CLEAN_STACK
+    zeromem(W0, sizeof(W0));
+    zeromem(W1, sizeof(W1));
+#endif
+}
+#undef RND2
+
+struct sha256_mb_lane {
+    ulong32 state[8];
+    const unsigned char *in;
+    unsigned char *out;
+    unsigned long full;    /* blocks read straight from the message */
+    unsigned long blocks;  /* total blocks, including the padding */
+    unsigned long cur;
+    unsigned char pad[128];
+};
+
+static void _sha256_mb_lane_start(struct sha256_mb_lane *lane,
+                                  const ulong32 *iv, ulong64 prelen,
+                                  const unsigned char *in, unsigned long inlen,
+                                  unsigned char *out)
+{
+    unsigned long rem = inlen & 63;
+    unsigned long padlen;
+
+    XMEMCPY(lane->state, iv, sizeof(lane->state));
+    lane->in = in;
+    lane->out = out;
+    lane->full = inlen >> 6;
+    lane->cur = 0;
+
+    /* message tail, 0x80, zeros, then the 64-bit bit length */
+    padlen = (rem + 9 > 64) ? 128 : 64;
+    XMEMCPY(lane->pad, in + (inlen - rem), rem);
+    lane->pad[rem] = 0x80;
+    zeromem(lane->pad + rem + 1, padlen - rem - 1);
+    STORE64H((prelen + inlen) * 8, lane->pad + padlen - 8);
+    lane->blocks = lane->full + (padlen >> 6);
+}
+
+static const unsigned char *_sha256_mb_lane_block(const struct sha256_mb_lane *lane)
+{
+    if (lane->cur < lane->full) {
+        return lane->in + (lane->cur << 6);
+    }
+    return lane->pad + ((lane->cur - lane->full) << 6);
+}
+
+/**
+  Hash n independent messages.
+  Every message is hashed as the continuation of a SHA-256 computation that
+  has already compressed prelen bytes (a multiple of 64) into the chaining
+  value iv, which allows precomputed HMAC inner and outer states to be used.
+  Pass sha256_mb_iv and 0 for a plain SHA-256.
+  @param iv      The initial chaining value (8 words)
+  @param prelen  The number of bytes already compressed into iv
+  @param in      The messages
+  @param inlen   The length of each message (octets)
+  @param out     [out] Where to store each 32-byte digest
+  @param n       The number of messages
+  @return CRYPT_OK if successful
+*/
+int sha256_mb_memory(const ulong32 *iv, ulong64 prelen,
+                     const unsigned char * const *in,
+                     const unsigned long *inlen,
+                     unsigned char * const *out, unsigned long n)
+{
+    struct sha256_mb_lane lane[SHA256_MB_LANES];
+    ulong32 idle_state[8];
+    const unsigned char *blk[SHA256_MB_LANES];
+    ulong32 *st[SHA256_MB_LANES];
+    int active[SHA256_MB_LANES];
+    unsigned long next = 0;
+    int l, busy, i;
+
+    LTC_ARGCHK(iv != NULL);
+    if (n == 0) {
+        return CRYPT_OK;
+    }
+    LTC_ARGCHK(in != NULL);
+    LTC_ARGCHK(inlen != NULL);
+    LTC_ARGCHK(out != NULL);
+    if (prelen & 63) {
+        return CRYPT_INVALID_ARG;
+    }
+
+    for (l = 0; l < SHA256_MB_LANES; l++) {
+        active[l] = 0;
+    }
+    /* idle lanes compress into this; its contents never reach an output */
+    zeromem(idle_state, sizeof(idle_state));
+
+    for (;;) {
+        /* refill idle lanes so messages of different lengths share passes */
+        busy = 0;
+        for (l = 0; l < SHA256_MB_LANES; l++) {
+            if (!active[l] && next < n) {
+                LTC_ARGCHK(in[next] != NULL || inlen[next] == 0);
+                LTC_ARGCHK(out[next] != NULL);
+                _sha256_mb_lane_start(&lane[l], iv, prelen, in[next],
+                                      inlen[next], out[next]);
+                active[l] = 1;
+                next++;
+            }
+            busy |= active[l];
+        }
+        if (!busy) {
+            break;
+        }
+
+        for (l = 0; l < SHA256_MB_LANES; l++) {
+            if (active[l]) {
+                st[l] = lane[l].state;
+                blk[l] = _sha256_mb_lane_block(&lane[l]);
+            } else {
+                /* nothing left for this lane, run it on scratch */
+                st[l] = idle_state;
+                blk[l] = lane[0].pad;
+            }
+        }
+        _sha256_mb_compress(st[0], blk[0], st[1], blk[1]);
+
+        for (l = 0; l < SHA256_MB_LANES; l++) {
+            if (active[l] && ++lane[l].cur == lane[l].blocks) {
+                for (i = 0; i < 8; i++) {
+                    STORE32H(lane[l].state[i], lane[l].out + (4*i));
+                }
+                active[l] = 0;
+            }
+        }
+    }
+
+#ifdef LTC_CLEAN_STACK
+    zeromem(lane, sizeof(lane));
+    zeromem(idle_state, sizeof(idle_state));
+#endif
+    return CRYPT_OK;
+}
+
+#endif /* LTC_SHA256 */
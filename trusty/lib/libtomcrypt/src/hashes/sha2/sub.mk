@@ -4,6 +4,7 @@ srcs-$(CFG_CRYPTO_SHA224) += sha224.c
 SHA256 := $(call cfg-one-enabled, CFG_CRYPTO_SHA224 CFG_CRYPTO_SHA256)
 ifeq ($(SHA256),y)
 srcs-y += sha256.c
+srcs-y += sha256_mb.c
 endif
 
 srcs-$(CFG_CRYPTO_SHA384) += sha384.c
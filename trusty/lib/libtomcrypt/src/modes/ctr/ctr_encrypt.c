@@ -48,11 +48,15 @@ int ctr_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long len, s
    }
 #endif
 
-   /* handle acceleration only if pad is empty, accelerator is present and length is >= a block size */
-   if ((ctr->padlen == ctr->blocklen) && cipher_descriptor[ctr->cipher].accel_ctr_encrypt != NULL && (len >= (unsigned long)ctr->blocklen)) {
+   /* handle acceleration only if pad is empty, accelerator is present, length is >= a block size
+    * and the counter spans the whole block, as accelerators do not know about narrower counters */
+   if ((ctr->padlen == ctr->blocklen) && cipher_descriptor[ctr->cipher].accel_ctr_encrypt != NULL && (len >= (unsigned long)ctr->blocklen) &&
+       ctr->ctrlen == (ctr->mode == CTR_COUNTER_LITTLE_ENDIAN ? ctr->blocklen : 0)) {
       if ((err = cipher_descriptor[ctr->cipher].accel_ctr_encrypt(pt, ct, len/ctr->blocklen, ctr->ctr, ctr->mode, &ctr->key)) != CRYPT_OK) {
          return err;
       }
+      pt += (len / ctr->blocklen) * ctr->blocklen;
+      ct += (len / ctr->blocklen) * ctr->blocklen;
       len %= ctr->blocklen;
    }
 
@@ -28,6 +28,7 @@ MODULE := $(LOCAL_DIR)
 
 MODULE_SRCS += \
 	$(LOCAL_DIR)/ciphers/aes/aes.c \
+	$(LOCAL_DIR)/ciphers/aes/aes_ct.c \
 	$(LOCAL_DIR)/ciphers/des.c \
 	$(LOCAL_DIR)/encauth/ccm/ccm_reset.c \
 	$(LOCAL_DIR)/encauth/ccm/ccm_add_aad.c \
@@ -66,6 +67,7 @@ MODULE_SRCS += \
 	$(LOCAL_DIR)/hashes/md5.c \
 	$(LOCAL_DIR)/hashes/sha1.c \
 	$(LOCAL_DIR)/hashes/sha2/sha256.c \
+	$(LOCAL_DIR)/hashes/sha2/sha256_mb.c \
 	$(LOCAL_DIR)/hashes/sha2/sha512_224.c \
 	$(LOCAL_DIR)/hashes/sha2/sha512_256.c \
 	$(LOCAL_DIR)/hashes/sha2/sha512.c \
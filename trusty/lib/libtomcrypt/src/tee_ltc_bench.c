@@ -0,0 +1,426 @@
+/*
+ * Copyright (c) 2018, MIPS Tech, LLC and/or its affiliated group companies
+ * (“MIPS”).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Kernel console benchmarks for the LibTomCrypt provider.
+ *
+ *   ltc_bench aes [event]
+ *   ltc_bench gcm [event]
+ *
+ * Reports throughput of the T-table and the constant-time AES cores for the
+ * block modes used by the TEE, together with a hardware performance counter
+ * reading.  The counter event is core specific; the default (11 on counter
+ * 1) is the L1 D-cache miss event of the 24K/34K/74K/interAptiv family.
+ *
+ * The gcm benchmark runs a full init/IV/AAD/encrypt/tag sequence per
+ * message, so the per-key GHASH table setup is part of the measurement.
+ */
+
+#if LK_DEBUGLEVEL > 1 && WITH_LIB_CONSOLE
+
+#include <lib/console.h>
+#include <platform.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tomcrypt.h>
+#if ARCH_MIPS
+#include <arch/mips.h>
+#endif
+
+#define BENCH_TOTAL_BYTES	(256 * 1024)
+#define BENCH_MAX_LEN		4096
+#define BENCH_DEFAULT_EVENT	11
+#define BENCH_GCM_MAX_LEN	(64 * 1024)
+#define BENCH_GCM_TOTAL_BYTES	(1024 * 1024)
+
+#if ARCH_MIPS
+#define MIPS_CONFIG1_PC		(1u << 4)
+#define MIPS_PERFCTL_EXL	(1u << 0)
+#define MIPS_PERFCTL_K		(1u << 1)
+#define MIPS_PERFCTL_EVENT_SHIFT 5
+
+static bool bench_perf_start(unsigned int event)
+{
+	if (!(mips_read_c0_config1() & MIPS_CONFIG1_PC))
+		return false;
+
+	mips_write_c0_perfctl1(0);
+	mips_write_c0_perfcnt1(0);
+	mips_write_c0_perfctl1((event << MIPS_PERFCTL_EVENT_SHIFT) |
+			       MIPS_PERFCTL_K | MIPS_PERFCTL_EXL);
+	return true;
+}
+
+static uint32_t bench_perf_stop(void)
+{
+	uint32_t count = mips_read_c0_perfcnt1();
+
+	mips_write_c0_perfctl1(0);
+	return count;
+}
+#else
+static bool bench_perf_start(unsigned int event)
+{
+	return false;
+}
+
+static uint32_t bench_perf_stop(void)
+{
+	return 0;
+}
+#endif
+
+struct bench_cipher {
+	const char *name;
+	const struct ltc_cipher_descriptor *desc;
+};
+
+static const struct bench_cipher bench_ciphers[] = {
+	{ "aes-tab", &aes_desc },
+#if defined(LTC_RIJNDAEL_CT)
+	{ "aes-ct", &aes_ct_desc },
+#endif
+};
+
+enum bench_mode {
+	BENCH_ECB,
+	BENCH_CBC_ENC,
+	BENCH_CBC_DEC,
+	BENCH_CTR,
+	BENCH_XTS,
+	BENCH_MODE_COUNT,
+};
+
+static const char * const bench_mode_names[BENCH_MODE_COUNT] = {
+	[BENCH_ECB] = "ecb",
+	[BENCH_CBC_ENC] = "cbc-enc",
+	[BENCH_CBC_DEC] = "cbc-dec",
+	[BENCH_CTR] = "ctr",
+	[BENCH_XTS] = "xts",
+};
+
+static const size_t bench_lens[] = { 16, 64, 256, 1024, BENCH_MAX_LEN };
+
+/*
+ * Register the descriptor for the duration of the benchmark. Returns the
+ * cipher index and whether the caller must unregister it again.
+ */
+static int bench_register(const struct ltc_cipher_descriptor *desc,
+			  bool *registered)
+{
+	int x;
+
+	for (x = 0; x < TAB_SIZE; x++) {
+		if (cipher_descriptor[x].name != NULL &&
+		    !memcmp(&cipher_descriptor[x], desc, sizeof(*desc))) {
+			*registered = false;
+			return x;
+		}
+	}
+	*registered = true;
+	return register_cipher(desc);
+}
+
+static int bench_run_once(int idx, enum bench_mode mode, uint8_t *buf,
+			  size_t len)
+{
+	static const uint8_t key[32] = { 0x2b, 0x7e, 0x15, 0x16 };
+	uint8_t iv[16] = { 0 };
+	int res = CRYPT_OK;
+
+	switch (mode) {
+	case BENCH_ECB: {
+		symmetric_key skey;
+		size_t n;
+
+		/* single-block path, as used by CMAC/CCM/GCM block calls */
+		res = cipher_descriptor[idx].setup(key, 16, 0, &skey);
+		for (n = 0; res == CRYPT_OK && n < len; n += 16)
+			res = cipher_descriptor[idx].ecb_encrypt(buf + n,
+								 buf + n,
+								 &skey);
+		break;
+	}
+#if defined(LTC_CBC_MODE)
+	case BENCH_CBC_ENC:
+	case BENCH_CBC_DEC: {
+		symmetric_CBC cbc;
+
+		res = cbc_start(idx, iv, key, 16, 0, &cbc);
+		if (res != CRYPT_OK)
+			break;
+		if (mode == BENCH_CBC_ENC)
+			res = cbc_encrypt(buf, buf, len, &cbc);
+		else
+			res = cbc_decrypt(buf, buf, len, &cbc);
+		cbc_done(&cbc);
+		break;
+	}
+#endif
+#if defined(LTC_CTR_MODE)
+	case BENCH_CTR: {
+		symmetric_CTR ctr;
+
+		res = ctr_start(idx, iv, key, 16, 0, CTR_COUNTER_BIG_ENDIAN,
+				&ctr);
+		if (res != CRYPT_OK)
+			break;
+		res = ctr_encrypt(buf, buf, len, &ctr);
+		ctr_done(&ctr);
+		break;
+	}
+#endif
+#if defined(LTC_XTS_MODE)
+	case BENCH_XTS: {
+		symmetric_xts xts;
+
+		res = xts_start(idx, key, key + 16, 16, 0, &xts);
+		if (res != CRYPT_OK)
+			break;
+		res = xts_encrypt(buf, len, buf, iv, &xts);
+		xts_done(&xts);
+		break;
+	}
+#endif
+	default:
+		res = CRYPT_NOP;
+		break;
+	}
+
+	return res;
+}
+
+static void bench_aes(unsigned int event)
+{
+	uint8_t *buf;
+	size_t c, l;
+	int m, err;
+
+	buf = malloc(BENCH_MAX_LEN);
+	if (!buf) {
+		printf("failed to allocate buffer\n");
+		return;
+	}
+	memset(buf, 0x5a, BENCH_MAX_LEN);
+
+	printf("%-8s %-8s %6s %10s %10s %10s\n", "core", "mode", "len",
+	       "usecs", "KB/s", "events");
+
+	for (c = 0; c < countof(bench_ciphers); c++) {
+		bool registered;
+		int idx = bench_register(bench_ciphers[c].desc, &registered);
+
+		if (idx < 0) {
+			printf("%s: register_cipher failed\n",
+			       bench_ciphers[c].name);
+			continue;
+		}
+
+		/* no numbers for a core that gets the answers wrong */
+		err = bench_ciphers[c].desc->test();
+		if (err != CRYPT_OK && err != CRYPT_NOP) {
+			printf("%-8s self-test failed: %s\n",
+			       bench_ciphers[c].name, error_to_string(err));
+			goto next;
+		}
+
+		for (m = 0; m < BENCH_MODE_COUNT; m++) {
+			for (l = 0; l < countof(bench_lens); l++) {
+				size_t len = bench_lens[l];
+				size_t iters = BENCH_TOTAL_BYTES / len;
+				lk_bigtime_t start, usecs;
+				bool have_perf;
+				uint32_t events = 0;
+				size_t i;
+				int res = CRYPT_OK;
+
+				have_perf = bench_perf_start(event);
+				start = current_time_hires();
+				for (i = 0; i < iters && res == CRYPT_OK; i++)
+					res = bench_run_once(idx, m, buf, len);
+				usecs = current_time_hires() - start;
+				if (have_perf)
+					events = bench_perf_stop();
+
+				if (res == CRYPT_NOP)
+					break;
+				if (res != CRYPT_OK) {
+					printf("%-8s %-8s %6zu failed: %s\n",
+					       bench_ciphers[c].name,
+					       bench_mode_names[m], len,
+					       error_to_string(res));
+					break;
+				}
+				printf("%-8s %-8s %6zu %10llu %10llu %10u\n",
+				       bench_ciphers[c].name,
+				       bench_mode_names[m], len, usecs,
+				       usecs ? (BENCH_TOTAL_BYTES * 1000000ULL /
+						1024) / usecs : 0,
+				       events);
+			}
+		}
+
+next:
+		if (registered)
+			unregister_cipher(bench_ciphers[c].desc);
+	}
+
+	free(buf);
+}
+
+#if defined(LTC_GCM_MODE)
+static const size_t bench_gcm_lens[] = { 1024, 16 * 1024, BENCH_GCM_MAX_LEN };
+
+static int bench_gcm_once(int idx, uint8_t *buf, size_t len)
+{
+	static const uint8_t key[16] = { 0xfe, 0xff, 0xe9, 0x92 };
+	static const uint8_t iv[12] = { 0xca, 0xfe, 0xba, 0xbe };
+	static const uint8_t aad[20] = { 0xfe, 0xed, 0xfa, 0xce };
+	gcm_state *gcm;
+	uint8_t tag[16];
+	unsigned long taglen = sizeof(tag);
+	int res;
+
+	gcm = malloc(sizeof(*gcm));
+	if (!gcm)
+		return CRYPT_MEM;
+
+	res = gcm_init(gcm, idx, key, sizeof(key));
+	if (res == CRYPT_OK)
+		res = gcm_add_iv(gcm, iv, sizeof(iv));
+	if (res == CRYPT_OK)
+		res = gcm_add_aad(gcm, aad, sizeof(aad));
+	if (res == CRYPT_OK)
+		res = gcm_process(gcm, buf, len, buf, GCM_ENCRYPT);
+	if (res == CRYPT_OK)
+		res = gcm_done(gcm, tag, &taglen);
+
+	free(gcm);
+	return res;
+}
+
+static void bench_gcm(unsigned int event)
+{
+	uint8_t *buf;
+	size_t c, l;
+
+	buf = malloc(BENCH_GCM_MAX_LEN);
+	if (!buf) {
+		printf("failed to allocate buffer\n");
+		return;
+	}
+	memset(buf, 0x5a, BENCH_GCM_MAX_LEN);
+
+#if defined(LTC_GCM_TABLES_8BIT)
+	printf("GHASH: 8-bit table\n");
+#elif defined(LTC_GCM_TABLES_4BIT)
+	printf("GHASH: 4-bit table\n");
+#elif defined(LTC_GCM_TABLES)
+	printf("GHASH: 64 KB tables\n");
+#else
+	printf("GHASH: no tables\n");
+#endif
+	printf("%-8s %6s %10s %10s %10s\n", "core", "len", "usecs", "KB/s",
+	       "events");
+
+	for (c = 0; c < countof(bench_ciphers); c++) {
+		bool registered;
+		int idx = bench_register(bench_ciphers[c].desc, &registered);
+
+		if (idx < 0) {
+			printf("%s: register_cipher failed\n",
+			       bench_ciphers[c].name);
+			continue;
+		}
+
+		for (l = 0; l < countof(bench_gcm_lens); l++) {
+			size_t len = bench_gcm_lens[l];
+			size_t iters = BENCH_GCM_TOTAL_BYTES / len;
+			lk_bigtime_t start, usecs;
+			bool have_perf;
+			uint32_t events = 0;
+			size_t i;
+			int res = CRYPT_OK;
+
+			have_perf = bench_perf_start(event);
+			start = current_time_hires();
+			for (i = 0; i < iters && res == CRYPT_OK; i++)
+				res = bench_gcm_once(idx, buf, len);
+			usecs = current_time_hires() - start;
+			if (have_perf)
+				events = bench_perf_stop();
+
+			if (res != CRYPT_OK) {
+				printf("%-8s %6zu failed: %s\n",
+				       bench_ciphers[c].name, len,
+				       error_to_string(res));
+				break;
+			}
+			printf("%-8s %6zu %10llu %10llu %10u\n",
+			       bench_ciphers[c].name, len, usecs,
+			       usecs ? (BENCH_GCM_TOTAL_BYTES * 1000000ULL /
+					1024) / usecs : 0,
+			       events);
+		}
+
+		if (registered)
+			unregister_cipher(bench_ciphers[c].desc);
+	}
+
+	free(buf);
+}
+#endif
+
+static int cmd_ltc_bench(int argc, const cmd_args *argv)
+{
+	if (argc < 2) {
+usage:
+		printf("usage:\n");
+		printf("\t%s aes [perf event]\n", argv[0].str);
+#if defined(LTC_GCM_MODE)
+		printf("\t%s gcm [perf event]\n", argv[0].str);
+#endif
+		return -1;
+	}
+
+	if (!strcmp(argv[1].str, "aes")) {
+		bench_aes(argc > 2 ? argv[2].u : BENCH_DEFAULT_EVENT);
+#if defined(LTC_GCM_MODE)
+	} else if (!strcmp(argv[1].str, "gcm")) {
+		bench_gcm(argc > 2 ? argv[2].u : BENCH_DEFAULT_EVENT);
+#endif
+	} else {
+		printf("unknown benchmark\n");
+		goto usage;
+	}
+
+	return 0;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("ltc_bench", "LibTomCrypt provider benchmarks", &cmd_ltc_bench)
+STATIC_COMMAND_END(ltc_bench);
+
+#endif /* LK_DEBUGLEVEL > 1 && WITH_LIB_CONSOLE */
@@ -187,8 +187,13 @@ static TEE_Result tee_ltc_prng_init(struct tee_ltc_prng *prng)
 static void tee_ltc_reg_algs(void)
 {
 #if defined(CFG_CRYPTO_AES)
+#if defined(CFG_CRYPTO_AES_CT)
+	/* Table-free constant-time core, registered under the name "aes" */
+	register_cipher(&aes_ct_desc);
+#else
 	register_cipher(&aes_desc);
 #endif
+#endif
 #if defined(CFG_CRYPTO_DES)
 	register_cipher(&des_desc);
 	register_cipher(&des3_desc);
@@ -467,6 +472,44 @@ static TEE_Result hash_final(void *ctx, uint32_t algo, uint8_t *digest,
 	return TEE_SUCCESS;
 }
 
+/* Messages handed to sha256_mb_memory() per call */
+#define HASH_BATCH_MAX	16
+
+#if defined(CFG_CRYPTO_SHA256)
+static TEE_Result sha256_batch(const ulong32 *iv, ulong64 prelen, size_t num,
+			       const uint8_t * const *data, const size_t *len,
+			       uint8_t * const *digest)
+{
+	unsigned long ltc_len[HASH_BATCH_MAX];
+	size_t done, n, i;
+
+	for (done = 0; done < num; done += n) {
+		n = MIN(num - done, (size_t)HASH_BATCH_MAX);
+		for (i = 0; i < n; i++)
+			ltc_len[i] = len[done + i];
+		if (sha256_mb_memory(iv, prelen, data + done, ltc_len,
+				     digest + done, n) != CRYPT_OK)
+			return TEE_ERROR_BAD_STATE;
+	}
+
+	return TEE_SUCCESS;
+}
+#endif
+
+static TEE_Result hash_batch(uint32_t algo, size_t num,
+			     const uint8_t * const *data, const size_t *len,
+			     uint8_t * const *digest)
+{
+	switch (algo) {
+#if defined(CFG_CRYPTO_SHA256)
+	case TEE_ALG_SHA256:
+		return sha256_batch(sha256_mb_iv, 0, num, data, len, digest);
+#endif
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+}
+
 #endif /* _CFG_CRYPTO_WITH_HASH */
 
 /******************************************************************************
@@ -2143,6 +2186,67 @@ static TEE_Result cipher_init(void *ctx, uint32_t algo,
 		return TEE_ERROR_BAD_STATE;
 }
 
+static TEE_Result cipher_reinit(void *ctx, const void *cached, uint32_t algo,
+				TEE_OperationMode mode __unused,
+				const uint8_t *iv __maybe_unused,
+				size_t iv_len __maybe_unused)
+{
+	TEE_Result res;
+	size_t ctx_size;
+	int ltc_res;
+
+	res = cipher_get_ctx_size(algo, &ctx_size);
+	if (res != TEE_SUCCESS)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	/* the key schedule is in the mode context, only the IV changes */
+	switch (algo) {
+#if defined(CFG_CRYPTO_ECB)
+	case TEE_ALG_AES_ECB_NOPAD:
+	case TEE_ALG_DES_ECB_NOPAD:
+	case TEE_ALG_DES3_ECB_NOPAD:
+		memcpy(ctx, cached, ctx_size);
+		ltc_res = CRYPT_OK;
+		break;
+#endif
+#if defined(CFG_CRYPTO_CBC)
+	case TEE_ALG_AES_CBC_NOPAD:
+	case TEE_ALG_DES_CBC_NOPAD:
+	case TEE_ALG_DES3_CBC_NOPAD:
+		if (iv_len != (size_t)((const symmetric_CBC *)cached)->blocklen)
+			return TEE_ERROR_BAD_PARAMETERS;
+		memcpy(ctx, cached, ctx_size);
+		ltc_res = cbc_setiv(iv, iv_len, ctx);
+		break;
+#endif
+#if defined(CFG_CRYPTO_CTR)
+	case TEE_ALG_AES_CTR:
+		if (iv_len != (size_t)((const symmetric_CTR *)cached)->blocklen)
+			return TEE_ERROR_BAD_PARAMETERS;
+		memcpy(ctx, cached, ctx_size);
+		ltc_res = ctr_setiv(iv, iv_len, ctx);
+		break;
+#endif
+#if defined(CFG_CRYPTO_CTS)
+	case TEE_ALG_AES_CTS:
+		if (iv_len != (size_t)((const struct tee_symmetric_cts *)
+				       cached)->cbc.blocklen)
+			return TEE_ERROR_BAD_PARAMETERS;
+		memcpy(ctx, cached, ctx_size);
+		ltc_res = cbc_setiv(iv, iv_len,
+				    &((struct tee_symmetric_cts *)ctx)->cbc);
+		break;
+#endif
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+
+	if (ltc_res == CRYPT_OK)
+		return TEE_SUCCESS;
+	else
+		return TEE_ERROR_BAD_STATE;
+}
+
 static TEE_Result cipher_update(void *ctx, uint32_t algo,
 				TEE_OperationMode mode,
 				bool last_block __maybe_unused,
@@ -2400,6 +2504,35 @@ static TEE_Result mac_init(void *ctx, uint32_t algo, const uint8_t *key,
 	return TEE_SUCCESS;
 }
 
+static TEE_Result mac_reinit(void *ctx, const void *cached, uint32_t algo)
+{
+	TEE_Result res;
+	size_t ctx_size;
+
+	switch (algo) {
+#if defined(CFG_CRYPTO_CBC_MAC)
+	case TEE_ALG_AES_CBC_MAC_NOPAD:
+	case TEE_ALG_AES_CBC_MAC_PKCS5:
+	case TEE_ALG_DES_CBC_MAC_NOPAD:
+	case TEE_ALG_DES_CBC_MAC_PKCS5:
+	case TEE_ALG_DES3_CBC_MAC_NOPAD:
+	case TEE_ALG_DES3_CBC_MAC_PKCS5:
+#endif
+#if defined(CFG_CRYPTO_CMAC)
+	case TEE_ALG_AES_CMAC:
+#endif
+		/* a freshly initialized context holds no per-message data */
+		res = mac_get_ctx_size(algo, &ctx_size);
+		if (res != TEE_SUCCESS)
+			return TEE_ERROR_NOT_SUPPORTED;
+		memcpy(ctx, cached, ctx_size);
+		return TEE_SUCCESS;
+	default:
+		/* HMAC contexts own a heap copy of the key */
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+}
+
 static TEE_Result mac_update(void *ctx, uint32_t algo, const uint8_t *data,
 			     size_t len)
 {
@@ -2550,6 +2683,80 @@ static TEE_Result mac_final(void *ctx, uint32_t algo, uint8_t *digest,
 
 	return TEE_SUCCESS;
 }
+
+#if defined(CFG_CRYPTO_HMAC) && defined(CFG_CRYPTO_SHA256)
+/*
+ * HMAC-SHA256 of many messages under one key: the inner and outer padded
+ * key blocks are compressed once, then the inner and outer hashes of all
+ * messages continue from those chaining values in the multi-buffer core.
+ */
+static TEE_Result hmac_sha256_batch(const uint8_t *key, size_t key_len,
+				    size_t num, const uint8_t * const *data,
+				    const size_t *len, uint8_t * const *digest)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t pad[64];
+	hash_state ipad, opad;
+	uint8_t inner[HASH_BATCH_MAX][32];
+	uint8_t *inner_ptr[HASH_BATCH_MAX];
+	size_t inner_len[HASH_BATCH_MAX];
+	size_t done, n, i;
+
+	memset(pad, 0, sizeof(pad));
+	if (key_len > sizeof(pad)) {
+		if (sha256_init(&ipad) != CRYPT_OK ||
+		    sha256_process(&ipad, key, key_len) != CRYPT_OK ||
+		    sha256_done(&ipad, pad) != CRYPT_OK)
+			return TEE_ERROR_BAD_STATE;
+	} else {
+		memcpy(pad, key, key_len);
+	}
+
+	for (i = 0; i < sizeof(pad); i++)
+		pad[i] ^= 0x36;
+	sha256_init(&ipad);
+	sha256_process(&ipad, pad, sizeof(pad));
+	for (i = 0; i < sizeof(pad); i++)
+		pad[i] ^= 0x36 ^ 0x5c;
+	sha256_init(&opad);
+	sha256_process(&opad, pad, sizeof(pad));
+
+	for (i = 0; i < HASH_BATCH_MAX; i++) {
+		inner_ptr[i] = inner[i];
+		inner_len[i] = sizeof(inner[i]);
+	}
+
+	for (done = 0; done < num && res == TEE_SUCCESS; done += n) {
+		n = MIN(num - done, (size_t)HASH_BATCH_MAX);
+		res = sha256_batch(ipad.sha256.state, sizeof(pad), n,
+				   data + done, len + done, inner_ptr);
+		if (res == TEE_SUCCESS)
+			res = sha256_batch(opad.sha256.state, sizeof(pad), n,
+					   (const uint8_t * const *)inner_ptr,
+					   inner_len, digest + done);
+	}
+
+	memset(pad, 0, sizeof(pad));
+	memset(&ipad, 0, sizeof(ipad));
+	memset(&opad, 0, sizeof(opad));
+	memset(inner, 0, sizeof(inner));
+	return res;
+}
+#endif
+
+static TEE_Result mac_batch(uint32_t algo, const uint8_t *key, size_t key_len,
+			    size_t num, const uint8_t * const *data,
+			    const size_t *len, uint8_t * const *digest)
+{
+	switch (algo) {
+#if defined(CFG_CRYPTO_HMAC) && defined(CFG_CRYPTO_SHA256)
+	case TEE_ALG_HMAC_SHA256:
+		return hmac_sha256_batch(key, key_len, num, data, len, digest);
+#endif
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+}
 #endif /* _CFG_CRYPTO_WITH_MAC */
 
 /******************************************************************************
@@ -2674,6 +2881,37 @@ static TEE_Result authenc_init(void *ctx, uint32_t algo,
 	return TEE_SUCCESS;
 }
 
+static TEE_Result authenc_reinit(void *ctx __maybe_unused,
+				 const void *cached __maybe_unused,
+				 uint32_t algo, TEE_OperationMode mode __unused,
+				 const uint8_t *nonce __maybe_unused,
+				 size_t nonce_len __maybe_unused,
+				 size_t tag_len __maybe_unused,
+				 size_t aad_len __unused,
+				 size_t payload_len __unused)
+{
+#if defined(CFG_CRYPTO_GCM)
+	struct tee_gcm_state *gcm;
+#endif
+
+	switch (algo) {
+#if defined(CFG_CRYPTO_GCM)
+	case TEE_ALG_AES_GCM:
+		/* keep the key schedule and the GHASH tables, redo the rest */
+		gcm = ctx;
+		memcpy(gcm, cached, sizeof(struct tee_gcm_state));
+		gcm->tag_len = tag_len;
+		if (gcm_reset(&gcm->ctx) != CRYPT_OK ||
+		    gcm_add_iv(&gcm->ctx, nonce, nonce_len) != CRYPT_OK)
+			return TEE_ERROR_BAD_STATE;
+		return TEE_SUCCESS;
+#endif
+	default:
+		/* CCM binds the lengths into its initial state */
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+}
+
 static TEE_Result authenc_update_aad(void *ctx, uint32_t algo,
 				     TEE_OperationMode mode __unused,
 				     const uint8_t *data, size_t len)
@@ -3011,6 +3249,7 @@ const struct crypto_ops crypto_ops = {
 		.init = hash_init,
 		.update = hash_update,
 		.final = hash_final,
+		.batch = hash_batch,
 	},
 #endif
 #if defined(_CFG_CRYPTO_WITH_CIPHER)
@@ -3020,6 +3259,7 @@ const struct crypto_ops crypto_ops = {
 		.get_ctx_size = cipher_get_ctx_size,
 		.init = cipher_init,
 		.update = cipher_update,
+		.reinit = cipher_reinit,
 	},
 #endif
 #if defined(_CFG_CRYPTO_WITH_MAC)
@@ -3028,6 +3268,8 @@ const struct crypto_ops crypto_ops = {
 		.init = mac_init,
 		.update = mac_update,
 		.final = mac_final,
+		.batch = mac_batch,
+		.reinit = mac_reinit,
 	},
 #endif
 #if defined(_CFG_CRYPTO_WITH_AUTHENC)
@@ -3039,6 +3281,7 @@ const struct crypto_ops crypto_ops = {
 		.init = authenc_init,
 		.update_aad = authenc_update_aad,
 		.update_payload = authenc_update_payload,
+		.reinit = authenc_reinit,
 	},
 #endif
 #if defined(_CFG_CRYPTO_WITH_ACIPHER)
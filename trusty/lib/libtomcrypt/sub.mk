@@ -5,6 +5,8 @@ ifeq (y,$(CFG_CRYPTO))
 
 # Ciphers
 CFG_CRYPTO_AES ?= y
+# Constant-time bitsliced AES core instead of the T-table one
+CFG_CRYPTO_AES_CT ?= n
 CFG_CRYPTO_DES ?= y
 
 # Cipher block modes
@@ -36,6 +38,9 @@ CFG_CRYPTO_ECC ?= y
 # Authenticated encryption
 CFG_CRYPTO_CCM ?= y
 CFG_CRYPTO_GCM ?= y
+# GHASH multiplication table per key: 4-bit (256 bytes) or 8-bit (4 KB)
+CFG_CRYPTO_GCM_TABLE_4BIT ?= y
+CFG_CRYPTO_GCM_TABLE_8BIT ?= n
 
 endif
 
@@ -102,6 +107,7 @@ $(eval $(call cryp-dep-one, GCM, AES))
 $(eval $(call cryp-dep-one, AES, ECB CBC CTR CTS XTS))
 # If no DES cipher mode is left, disable DES
 $(eval $(call cryp-dep-one, DES, ECB CBC))
+$(eval $(call cryp-dep-one, AES_CT, AES))
 
 # dsa_make_params() needs all three SHA-2 algorithms.
 # Disable DSA if any is missing.
@@ -24,7 +24,9 @@
 
 #include <stdint.h>
 #include <err.h>
+#include <platform.h>
 #include <arch/mips.h>
+#include <lib/syscall.h>
 
 extern long sys_undefined(int num);
 extern const unsigned long syscall_table[];
@@ -67,26 +69,54 @@ __WEAK long syscall_privilege_check(unsigned long num)
  * - When an odd-numbered 32-bit argument is followed by a 64-bit argument the
  *   compiler reserves one register for padding and the total number of
  *   parameters for that syscall prototype is reduced by one.
+ *
+ * Handlers of syscalls using at most four argument words, per syscall_info,
+ * are called with a0-a3 only so t0-t3 are not read or pushed for them, and
+ * syscall_privilege_check() only runs for syscalls marked privileged.
  */
+typedef uint32_t (*syscall_fn4_t)(uint32_t, uint32_t, uint32_t, uint32_t);
+typedef uint32_t (*syscall_fn8_t)(uint32_t, uint32_t, uint32_t, uint32_t,
+		uint32_t, uint32_t, uint32_t, uint32_t);
+
 void mips_syscall(struct mips_iframe *iframe)
 {
 	long ret;
 	unsigned long syscall_num = iframe->v0;
-	uint32_t (*fn8)(uint32_t, uint32_t, uint32_t, uint32_t,
-			uint32_t, uint32_t, uint32_t, uint32_t) = 0;
+	const struct syscall_info *info;
+	void *fn = NULL;
+#if SYSCALL_STATS
+	lk_bigtime_t start;
+#endif
+
+	if (syscall_num >= nr_syscalls || syscall_num >= nr_syscall_info) {
+		iframe->v0 = sys_undefined(syscall_num);
+		return;
+	}
 
-	if (syscall_num < nr_syscalls)
-		fn8 = (void*)syscall_table[syscall_num];
+	info = &syscall_info[syscall_num];
+	if (!(info->flags & SYSCALL_F_PRIVILEGED) ||
+	    syscall_privilege_check(syscall_num) == NO_ERROR)
+		fn = (void *)syscall_table[syscall_num];
 
-	ret = syscall_privilege_check(syscall_num);
-	if (ret)
-		fn8 = 0;
+	if (!fn) {
+		iframe->v0 = sys_undefined(syscall_num);
+		return;
+	}
 
-	if (fn8)
-		ret = fn8(iframe->a0, iframe->a1, iframe->a2, iframe->a3,
-			  iframe->t0, iframe->t1, iframe->t2, iframe->t3);
+#if SYSCALL_STATS
+	start = current_time_hires();
+#endif
+	if (info->nr_words <= 4)
+		ret = ((syscall_fn4_t)fn)(iframe->a0, iframe->a1,
+					  iframe->a2, iframe->a3);
 	else
-		ret = sys_undefined(syscall_num);
+		ret = ((syscall_fn8_t)fn)(iframe->a0, iframe->a1,
+					  iframe->a2, iframe->a3,
+					  iframe->t0, iframe->t1,
+					  iframe->t2, iframe->t3);
+#if SYSCALL_STATS
+	syscall_stats_record(syscall_num, current_time_hires() - start);
+#endif
 
 	iframe->v0 = ret;
 }
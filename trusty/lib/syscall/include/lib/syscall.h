@@ -24,8 +24,43 @@
 #ifndef __LIB_SYSCALL_H
 #define __LIB_SYSCALL_H
 
+#include <compiler.h>
+#include <stdint.h>
+#include <sys/types.h>
+
 #define __SYSCALL
 
+/* syscall_info flags */
+#define SYSCALL_F_PRIVILEGED	(1U << 0)	/* call syscall_privilege_check() */
+
+/* argument words assumed for a syscall without generated dispatch data */
+#define SYSCALL_MAX_ARG_WORDS	8
+
+#ifndef SYSCALL_STATS
+#define SYSCALL_STATS (LK_DEBUGLEVEL > 1)
+#endif
+
+/*
+ * Dispatch data, indexed by syscall number. With WITH_SYSCALL_DISPATCH it
+ * comes from the stubgen generated syscall_dispatch.h: nr_words is the
+ * number of argument registers the syscall reads, a 64-bit argument taking
+ * an aligned pair. Without it, every syscall is taken to read
+ * SYSCALL_MAX_ARG_WORDS words and to need the privilege check.
+ */
+struct syscall_info {
+	const char *name;
+	uint8_t nr_words;
+	uint8_t flags;
+};
+
+extern const struct syscall_info syscall_info[];
+extern unsigned long nr_syscall_info;
+
+#if SYSCALL_STATS
+/* account one syscall that returned after usecs */
+void syscall_stats_record(unsigned long num, lk_bigtime_t usecs);
+#endif
+
 #ifdef WITH_SYSCALL_TABLE
 
 /* Generate syscall numbers */
@@ -51,6 +51,15 @@ Another file with a enumeration of all syscalls is also generated:
 #define __NR_write 0x4
 ...
 
+Optionally, a kernel dispatch table with the number of argument registers
+each syscall uses, 64-bit arguments counted as an aligned register pair, and
+whether it is listed as privileged in the table with
+SYSCALL_PRIVILEGED(syscall_name):
+
+DEF_SYSCALL_DISPATCH(0x3, read, 3, 0)
+DEF_SYSCALL_DISPATCH(0x4, write, 3, SYSCALL_F_PRIVILEGED)
+...
+
 
 The max number of arguments is architecture specific.
 """
@@ -118,6 +127,8 @@ syscall_define = "#define __NR_%(sys_fn)-36s\t%(sys_nr)s\n"
 
 syscall_proto = "%(sys_rt)s %(sys_fn)s(%(sys_args)s);\n"
 
+syscall_dispatch = "DEF_SYSCALL_DISPATCH(%(sys_nr)s, %(sys_fn)s, %(sys_nr_words)d, %(sys_flags)s)\n"
+
 asm_ifdef = "\n#ifndef ASSEMBLY\n"
 asm_endif = "\n#endif\n"
 
@@ -140,12 +151,34 @@ syscall_pat = (
 
 syscall_re = re.compile(syscall_pat)
 
+privileged_def = "SYSCALL_PRIVILEGED"
+
+privileged_re = re.compile(r'SYSCALL_PRIVILEGED\s*\(\s*(?P<sys_fn>\w+)\s*\)\s*$')
+
+# non-pointer argument types passed in a register pair
+arg_64bit_re = re.compile(r'^(const\s+)?(u?int64_t|lk_bigtime_t|'
+                          r'(unsigned\s+)?long\s+long(\s+int)?)\b')
+
 
 def perror(line, err_str):
     sys.stderr.write("Error processing line %s:\n%s" % (line, err_str))
 
 
 
+def arg_words(sys_args_list):
+    """
+    Number of argument registers used by an argument list, with 64-bit
+    arguments passed in an even/odd register pair.
+    """
+    words = 0
+    for arg in sys_args_list:
+        if '*' not in arg and arg_64bit_re.match(arg):
+            words += (words & 1) + 2
+        else:
+            words += 1
+    return words
+
+
 def parse_check_def(line, max_nr_args):
     """
     Parse a DEF_SYSCALL line and check for errors
@@ -173,12 +206,19 @@ def parse_check_def(line, max_nr_args):
             elif len(sys_args_list) < sys_nr_args:
                 perror(line, "Too few arguments supplied\n")
                 return None
+
+            gd['sys_nr_words'] = arg_words(sys_args_list)
+            if gd['sys_nr_words'] > max_nr_args:
+                perror(line, "Exceeded maximum number of argument registers"
+                             " in syscall definition.\n")
+                return None
         else:
             if sys_args != None:
                 perror(line, "Too many arguments supplied\n")
                 return None
 
             gd['sys_args'] = 'void'
+            gd['sys_nr_words'] = 0
 
         return gd
 
@@ -190,16 +230,20 @@ def parse_check_def(line, max_nr_args):
         return None
 
 
-def process_table(table_file, std_file, stubs_file, verify, arch):
+def process_table(table_file, std_file, stubs_file, kernel_file, verify,
+                  arch):
     """
     Process a syscall table and generate:
     1. A sycall stubs file
     2. A trusty_std.h header file with syscall definitions
        and function prototypes
+    3. A kernel dispatch table with argument and privilege metadata
     """
     define_lines = ""
     proto_lines = "\n"
     stub_lines = ""
+    syscalls = []
+    privileged = set()
     syscall_stub = syscall_stub_arch[arch]
     max_nr_args = syscall_nr_arg_arch[arch]
 
@@ -207,6 +251,14 @@ def process_table(table_file, std_file, stubs_file, verify, arch):
     for line in tbl:
         line = line.strip()
 
+        if line.startswith(privileged_def):
+            m = privileged_re.match(line)
+            if m is None:
+                perror(line, "Malformed privileged syscall marker\n")
+                sys.exit(2)
+            privileged.add(m.group('sys_fn'))
+            continue
+
         # skip all lines that don't start with a syscall definition
         # multi-line defintions are not supported.
         if not line.startswith(syscall_def):
@@ -217,6 +269,8 @@ def process_table(table_file, std_file, stubs_file, verify, arch):
         if params is None:
             sys.exit(2)
 
+        syscalls.append(params)
+
         if not verify:
             define_lines += syscall_define % params
             proto_lines += syscall_proto % params
@@ -225,6 +279,12 @@ def process_table(table_file, std_file, stubs_file, verify, arch):
 
     tbl.close()
 
+    unknown = privileged - set(p['sys_fn'] for p in syscalls)
+    if unknown:
+        sys.stderr.write("Privileged syscalls not in table: %s\n" %
+                         ", ".join(sorted(unknown)))
+        sys.exit(2)
+
     if verify:
         return
 
@@ -242,6 +302,16 @@ def process_table(table_file, std_file, stubs_file, verify, arch):
                 stubs.writelines(includes_header % std_file)
             stubs.writelines(stub_lines)
 
+    if kernel_file is not None:
+        with open(kernel_file, "w") as kernel:
+            kernel.writelines(copyright_header + autogen_header)
+            for params in syscalls:
+                if params['sys_fn'] in privileged:
+                    params['sys_flags'] = "SYSCALL_F_PRIVILEGED"
+                else:
+                    params['sys_flags'] = "0"
+                kernel.writelines(syscall_dispatch % params)
+
 def main():
 
     usage = "usage:  %prog [options] <syscall-table>"
@@ -256,6 +326,9 @@ def main():
     op.add_option("-s", "--stubs-file", type="string",
             dest="stub_file", default=None,
             help="path to syscall assembly stubs file.")
+    op.add_option("-k", "--kernel-table", type="string",
+            dest="kernel_file", default=None,
+            help="path to kernel syscall dispatch table file.")
     op.add_option("-a", "--arch", type="string",
             dest="arch", default=None,
             help="Select architecture for assembly stubs. "
@@ -268,7 +341,8 @@ def main():
         sys.exit(1)
 
     if not opts.verify:
-        if opts.std_file is None and opts.stub_file is None:
+        if opts.std_file is None and opts.stub_file is None and \
+                opts.kernel_file is None:
             op.print_help()
             sys.exit(1)
 
@@ -277,7 +351,8 @@ def main():
         op.print_help()
         sys.exit(1)
 
-    process_table(args[0], opts.std_file, opts.stub_file, opts.verify, opts.arch)
+    process_table(args[0], opts.std_file, opts.stub_file, opts.kernel_file,
+                  opts.verify, opts.arch)
 
 
 if __name__ == '__main__':
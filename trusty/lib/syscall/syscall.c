@@ -30,11 +30,22 @@
  * - provide a file named syscall_table.h in the include path
  * - provide DEF_SYSCALL macros in syscall_table.h with
  *   number, name, #args followed by argument type defintions.
+ *
+ * It may also define WITH_SYSCALL_DISPATCH and provide syscall_dispatch.h,
+ * generated from syscall_table.h by stubgen.py -k, to give the dispatcher
+ * the argument count and privilege flag of each syscall.
  */
 #include <compiler.h>
 #include <debug.h>
 #include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <kernel/thread.h>
+#include <lib/syscall.h>
+#if WITH_LIB_CONSOLE
+#include <lib/console.h>
+#endif
 
 long sys_undefined(int num)
 {
@@ -65,3 +76,215 @@ const unsigned long syscall_table [] = {
 #undef DEF_SYSCALL
 
 unsigned long nr_syscalls = countof(syscall_table);
+
+#if defined(WITH_SYSCALL_TABLE) && defined(WITH_SYSCALL_DISPATCH)
+
+/*
+ * Fail the build if syscall_dispatch.h no longer matches syscall_table.h:
+ * every syscall needs an entry with the same number, at least one argument
+ * word per argument and the privilege flag exactly where the table has a
+ * SYSCALL_PRIVILEGED mark.
+ */
+#define DEF_SYSCALL_DISPATCH(nr, fn, nr_words, flags) \
+	STATIC_ASSERT(__NR_##fn == (nr));
+#include <syscall_dispatch.h>
+#undef DEF_SYSCALL_DISPATCH
+
+#define DEF_SYSCALL_DISPATCH(nr, fn, nr_words, flags) \
+	__dispatch_words_##fn = (nr_words), \
+	__dispatch_flags_##fn = (flags),
+enum {
+#include <syscall_dispatch.h>
+};
+#undef DEF_SYSCALL_DISPATCH
+
+#undef SYSCALL_PRIVILEGED
+#define DEF_SYSCALL(nr, fn, rtype, nr_args, ...) \
+	STATIC_ASSERT(__dispatch_words_##fn >= (nr_args));
+#define SYSCALL_PRIVILEGED(fn) \
+	STATIC_ASSERT(__dispatch_flags_##fn & SYSCALL_F_PRIVILEGED);
+#include <syscall_table.h>
+#undef SYSCALL_PRIVILEGED
+#undef DEF_SYSCALL
+
+/* and no entry is privileged that the table does not mark */
+#define DEF_SYSCALL(nr, fn, ...)
+#define SYSCALL_PRIVILEGED(fn) + 1
+enum { __table_privileged = 0
+#include <syscall_table.h>
+};
+#undef SYSCALL_PRIVILEGED
+#undef DEF_SYSCALL
+
+#define DEF_SYSCALL_DISPATCH(nr, fn, nr_words, flags) \
+	+ !!((flags) & SYSCALL_F_PRIVILEGED)
+enum { __dispatch_privileged = 0
+#include <syscall_dispatch.h>
+};
+#undef DEF_SYSCALL_DISPATCH
+
+STATIC_ASSERT((int)__table_privileged == (int)__dispatch_privileged);
+
+#define DEF_SYSCALL_DISPATCH(nr, fn, nr_words, flags) \
+	[(nr)] = { #fn, (nr_words), (flags) },
+const struct syscall_info syscall_info[] = {
+#include <syscall_dispatch.h>
+};
+#undef DEF_SYSCALL_DISPATCH
+
+#else
+
+#define DEF_SYSCALL(nr, fn, rtype, nr_args, ...) \
+	[(nr)] = { #fn, SYSCALL_MAX_ARG_WORDS, SYSCALL_F_PRIVILEGED },
+const struct syscall_info syscall_info[] = {
+
+#ifdef WITH_SYSCALL_TABLE
+#include <syscall_table.h>
+#endif
+
+};
+#undef DEF_SYSCALL
+
+#endif
+
+unsigned long nr_syscall_info = countof(syscall_info);
+
+#if SYSCALL_STATS
+
+/*
+ * Bucket i counts calls under 2^i us, above the previous bucket; the last
+ * one counts everything from 2^(SYSCALL_HIST_BUCKETS - 2) us up.
+ */
+#define SYSCALL_HIST_BUCKETS	16
+
+struct syscall_stats {
+	uint32_t count;
+	uint32_t max_us;
+	uint64_t total_us;
+	uint32_t hist[SYSCALL_HIST_BUCKETS];
+};
+
+/*
+ * Updated without a lock from every thread making syscalls, so a preempted
+ * update can lose a count; good enough for a profile. Syscalls that do not
+ * return, exit_group and ta_dead, are never counted.
+ */
+static struct syscall_stats syscall_stats[countof(syscall_info)];
+
+void syscall_stats_record(unsigned long num, lk_bigtime_t usecs)
+{
+	struct syscall_stats *st;
+	u_int b = 0;
+
+	if (num >= countof(syscall_stats))
+		return;
+
+	st = &syscall_stats[num];
+	while (b < SYSCALL_HIST_BUCKETS - 1 && usecs >= (1ULL << b))
+		b++;
+
+	st->count++;
+	st->total_us += usecs;
+	if (usecs > st->max_us)
+		st->max_us = MIN(usecs, UINT32_MAX);
+	st->hist[b]++;
+}
+
+#if WITH_LIB_CONSOLE
+
+/* bound of the bucket holding the pct percentile call, as "<us" or ">=us" */
+static void syscall_hist_pct(const struct syscall_stats *st, u_int pct,
+		char *buf, size_t len)
+{
+	uint32_t seen = 0;
+	uint32_t rank = (uint32_t)((uint64_t)st->count * pct / 100);
+	u_int b;
+
+	for (b = 0; b < SYSCALL_HIST_BUCKETS - 1; b++) {
+		seen += st->hist[b];
+		if (seen > rank)
+			break;
+	}
+
+	if (b == SYSCALL_HIST_BUCKETS - 1)
+		snprintf(buf, len, ">=%u", 1U << (b - 1));
+	else
+		snprintf(buf, len, "<%u", 1U << b);
+}
+
+static void syscall_stats_hist(const struct syscall_stats *st)
+{
+	u_int b;
+
+	for (b = 0; b < SYSCALL_HIST_BUCKETS; b++) {
+		if (!st->hist[b])
+			continue;
+		if (b == SYSCALL_HIST_BUCKETS - 1)
+			printf("  >= %6u us %10u\n", 1U << (b - 1), st->hist[b]);
+		else
+			printf("  <  %6u us %10u\n", 1U << b, st->hist[b]);
+	}
+}
+
+/*
+ * Count and latency of every syscall made so far, or the latency
+ * histogram of one syscall given by name.
+ */
+static int cmd_syscalls(int argc, const cmd_args *argv)
+{
+	struct syscall_stats st;
+	unsigned long num;
+	uint64_t calls = 0;
+	char p50[12], p99[12];
+
+	if (argc > 1 && !strcmp(argv[1].str, "reset")) {
+		memset(syscall_stats, 0, sizeof(syscall_stats));
+		return 0;
+	}
+
+	if (argc == 1)
+		printf(" nr name                                  count"
+		       "   avg us   max us    p50 us    p99 us\n");
+
+	for (num = 0; num < countof(syscall_stats); num++) {
+		if (!syscall_info[num].name)
+			continue;
+		if (argc > 1 && strcmp(argv[1].str, syscall_info[num].name))
+			continue;
+
+		st = syscall_stats[num];
+		if (argc > 1) {
+			printf("%s: %u calls, %llu us total, max %u us\n",
+			       syscall_info[num].name, st.count,
+			       (unsigned long long)st.total_us, st.max_us);
+			syscall_stats_hist(&st);
+			return 0;
+		}
+		if (!st.count)
+			continue;
+
+		calls += st.count;
+		syscall_hist_pct(&st, 50, p50, sizeof(p50));
+		syscall_hist_pct(&st, 99, p99, sizeof(p99));
+		printf("%3lx %-32s %10u %8llu %8u %9s %9s\n", num,
+		       syscall_info[num].name, st.count,
+		       (unsigned long long)(st.total_us / st.count),
+		       st.max_us, p50, p99);
+	}
+
+	if (argc > 1) {
+		printf("no syscall %s\n", argv[1].str);
+		return ERR_NOT_FOUND;
+	}
+	printf("calls %llu\n", (unsigned long long)calls);
+
+	return 0;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("syscalls", "syscall counts and latency [reset|<name>]", &cmd_syscalls)
+STATIC_COMMAND_END(syscall);
+
+#endif /* WITH_LIB_CONSOLE */
+
+#endif /* SYSCALL_STATS */
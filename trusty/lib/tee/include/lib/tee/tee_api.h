@@ -31,6 +31,7 @@
 
 #include <lib/trusty/uctx.h>
 #include <lib/trusty/trusty_app.h>
+#include <lib/tee/tee_handle.h>
 #include <tee_common_uapi.h>
 #include <tee_api_properties.h>
 
@@ -63,6 +64,10 @@ typedef struct tee_api_info {
 	struct list_node operation_list;
 	struct list_node cryp_states;
 	struct list_node objects;
+	struct list_node shm_maps;	// cached registered shm mappings
+	struct utee_ta_data *ta_data;	// page the TA reads without syscalls
+	struct tee_handle_db cryp_state_handles;
+	struct tee_handle_db obj_handles;
 } tee_api_info_t;
 
 status_t mmu_check_access_rights(const struct uthread *ut, uint32_t flags,
@@ -92,4 +97,12 @@ static inline tee_api_info_t *tee_current_ta_info(void)
 	return tee_api_info(tee_get_current_ta());
 }
 
+/* Mirror the cancellation state into the TA's data page */
+static inline void tee_api_sync_cancel(tee_api_info_t *ta_info)
+{
+	if (ta_info->ta_data)
+		ta_info->ta_data->cancel = ta_info->cancel &&
+					   !ta_info->cancel_masked;
+}
+
 #endif /* TEE_API_H */
@@ -56,6 +56,15 @@ struct hash_ops {
 			     const uint8_t *data, size_t len);
 	TEE_Result (*final)(void *ctx, uint32_t algo, uint8_t *digest,
 			    size_t len);
+	/*
+	 * Optional. Computes the full-size digest of each of @num independent
+	 * messages. Returns TEE_ERROR_NOT_SUPPORTED for algorithms without a
+	 * batched implementation, the caller then falls back to init/update/
+	 * final per message.
+	 */
+	TEE_Result (*batch)(uint32_t algo, size_t num,
+			    const uint8_t * const *data, const size_t *len,
+			    uint8_t * const *digest);
 };
 
 /* Symmetric ciphers */
@@ -72,6 +81,15 @@ struct cipher_ops {
 			     size_t len, uint8_t *dst);
 	void       (*final)(void *ctx, uint32_t algo);
 	TEE_Result (*get_block_size)(uint32_t algo, size_t *size);
+	/*
+	 * Optional: set up ctx from cached, a copy of a context that init()
+	 * prepared with the same algo, mode and key, for a new IV without
+	 * expanding the key again. Returns TEE_ERROR_NOT_SUPPORTED, with ctx
+	 * untouched, if contexts of algo can't be reused that way.
+	 */
+	TEE_Result (*reinit)(void *ctx, const void *cached, uint32_t algo,
+			     TEE_OperationMode mode,
+			     const uint8_t *iv, size_t iv_len);
 };
 
 /* Message Authentication Code functions */
@@ -83,6 +101,12 @@ struct mac_ops {
 			     const uint8_t *data, size_t len);
 	TEE_Result (*final)(void *ctx, uint32_t algo,
 			    uint8_t *digest, size_t digest_len);
+	/* Optional, as hash_ops.batch with all messages under one key */
+	TEE_Result (*batch)(uint32_t algo, const uint8_t *key, size_t key_len,
+			    size_t num, const uint8_t * const *data,
+			    const size_t *len, uint8_t * const *digest);
+	/* Optional, as cipher_ops.reinit */
+	TEE_Result (*reinit)(void *ctx, const void *cached, uint32_t algo);
 };
 
 /* Authenticated encryption */
@@ -115,6 +139,12 @@ struct authenc_ops {
 				size_t tag_len);
 
 	void       (*final)(void *ctx, uint32_t algo);
+	/* Optional, as cipher_ops.reinit */
+	TEE_Result (*reinit)(void *ctx, const void *cached, uint32_t algo,
+			     TEE_OperationMode mode,
+			     const uint8_t *nonce, size_t nonce_len,
+			     size_t tag_len, size_t aad_len,
+			     size_t payload_len);
 };
 
 /* Implementation-defined big numbers */
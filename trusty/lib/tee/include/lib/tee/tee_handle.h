@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2018, MIPS Tech, LLC and/or its affiliated group companies
+ * (“MIPS”).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TEE_HANDLE_H
+#define TEE_HANDLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+
+/*
+ * Handle ids are made of a slot index in the low bits and the slot's
+ * generation in the high bits. The generation is bumped each time a slot is
+ * released so that a stale id does not resolve to a later occupant of the
+ * same slot. Id 0 is never handed out.
+ */
+#define TEE_HANDLE_SLOT_BITS	16
+#define TEE_HANDLE_SLOT_MASK	((1U << TEE_HANDLE_SLOT_BITS) - 1)
+#define TEE_HANDLE_MAX_SLOTS	TEE_HANDLE_SLOT_MASK
+
+struct tee_handle_slot {
+	void *ptr;
+	uint16_t gen;
+	uint16_t next_free;	/* next free slot + 1, 0 ends the list */
+};
+
+struct tee_handle_db {
+	struct tee_handle_slot *slots;
+	uint32_t num_slots;
+	uint32_t free_head;	/* first free slot + 1, 0 if none */
+};
+
+/* Store ptr in a free slot and return its id */
+TEE_Result tee_handle_get(struct tee_handle_db *db, void *ptr, uint32_t *id);
+
+/* Release the slot of id, returns the pointer stored there or NULL */
+void *tee_handle_put(struct tee_handle_db *db, uint32_t id);
+
+/* Free the slot array, the stored pointers are not touched */
+void tee_handle_db_destroy(struct tee_handle_db *db);
+
+/* Return the pointer stored for id, NULL if id is unknown or stale */
+static inline void *tee_handle_lookup(const struct tee_handle_db *db,
+				      uint32_t id)
+{
+	uint32_t idx = (id & TEE_HANDLE_SLOT_MASK) - 1;
+	const struct tee_handle_slot *slot;
+
+	/* id 0 wraps to a huge index */
+	if (idx >= db->num_slots)
+		return NULL;
+	slot = db->slots + idx;
+	if (slot->gen != (id >> TEE_HANDLE_SLOT_BITS))
+		return NULL;
+	return slot->ptr;
+}
+
+#endif /* TEE_HANDLE_H */
@@ -39,6 +39,7 @@
 
 struct tee_obj {
 	struct list_node node;
+	uint32_t id;		/* handle id given to the TA */
 	TEE_ObjectInfo info;
 	bool busy;		/* true if used by an operation */
 	uint32_t have_attrs;	/* bitfield identifying set properties */
@@ -47,17 +48,25 @@ struct tee_obj {
 	struct tee_pobj *pobj;	/* ptr to persistant object */
 	struct tee_file_handle *fh;
 	uint32_t flags;		/* permission flags for persistent objects */
+	void *key_cache;	/* crypto ctx after init, see tee_svc_cryp.c */
+	size_t key_cache_size;
+	uint32_t key_cache_algo;
+	uint32_t key_cache_mode;
+	bool key_cache_off;	/* provider can't reuse the ctx */
 };
 
-void tee_obj_add(tee_api_info_t *ta_info, struct tee_obj *o);
+TEE_Result tee_obj_add(tee_api_info_t *ta_info, struct tee_obj *o);
 
 TEE_Result tee_obj_get(tee_api_info_t *ta_info, uint32_t obj_id,
 		       struct tee_obj **obj);
 
-void tee_obj_close(struct tee_obj *o);
+void tee_obj_close(tee_api_info_t *ta_info, struct tee_obj *o);
 
 void tee_obj_close_all(tee_api_info_t *ta_info);
 
+/* Forget the cached key schedule, on any change to the key attributes */
+void tee_obj_key_cache_drop(struct tee_obj *o);
+
 struct tee_obj *tee_obj_alloc(void);
 void tee_obj_free(struct tee_obj *o);
 
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2018, MIPS Tech, LLC and/or its affiliated group companies
+ * (“MIPS”).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TEE_SHM_H
+#define TEE_SHM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <list.h>
+#include <lib/trusty/trusty_app.h>
+
+/*
+ * Shared memory the REE registered once (GP TEEC_RegisterSharedMemory) is
+ * kept mapped in a TA after an invoke, so later memrefs into the same range
+ * skip the grant and revoke. A TA keeps at most TEE_SHM_TA_MAPS such
+ * mappings, least recently used first out. Unregistering a range that a
+ * TA still maps fails with TEE_ERROR_BUSY until the TA has finished its
+ * current or next message.
+ */
+#define TEE_SHM_MAX_REGS	64
+#define TEE_SHM_TA_MAPS		8
+
+struct tee_shm;
+
+struct tee_shm_map {
+	struct list_node node;
+	struct tee_shm *shm;
+	ext_vaddr_t buf;
+	size_t size;
+	u_int flags;
+	vaddr_t uaddr;
+};
+
+TEE_Result tee_shm_register(ext_vaddr_t buf, size_t size);
+TEE_Result tee_shm_unregister(ext_vaddr_t buf, size_t size);
+
+/* Map an NS memref into ta, from the cache if it is registered memory */
+status_t tee_shm_map_memref(trusty_app_t *ta, ext_vaddr_t buf, size_t size,
+		u_int flags, vaddr_t *uaddr);
+/* Map an NS memref described by a page list into ta */
+status_t tee_shm_map_pagelist(trusty_app_t *ta, ext_vaddr_t pagelist,
+		size_t size, u_int flags, vaddr_t *uaddr);
+/* True if uaddr is a cached mapping that must not be revoked */
+bool tee_shm_cached(trusty_app_t *ta, vaddr_t uaddr);
+/* Revoke the cached mappings of ranges the REE wants to unregister */
+void tee_shm_purge(trusty_app_t *ta);
+/* Drop the cache of a TA that is going away, its mappings go with it */
+void tee_shm_release(trusty_app_t *ta);
+
+#endif /* TEE_SHM_H */
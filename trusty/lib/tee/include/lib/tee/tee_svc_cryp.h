@@ -72,6 +72,8 @@ TEE_Result sys_utee_hash_update(unsigned long state, const void *chunk,
 			size_t chunk_size);
 TEE_Result sys_utee_hash_final(unsigned long state, const void *chunk,
 			size_t chunk_size, void *hash, uint64_t *hash_len);
+TEE_Result sys_utee_hash_batch(unsigned long state, struct utee_hash_msg *msgs,
+			unsigned long num_msgs);
 
 TEE_Result sys_utee_cipher_init(unsigned long state, const void *iv,
 			size_t iv_len);
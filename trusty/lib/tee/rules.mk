@@ -39,6 +39,9 @@ MODULE_SRCS += \
 	$(LOCAL_DIR)/tee_ta_core.c \
 	$(LOCAL_DIR)/tee_api.c \
 	$(LOCAL_DIR)/tee_mmu.c \
+	$(LOCAL_DIR)/tee_handle.c \
+	$(LOCAL_DIR)/tee_shm.c \
+	$(LOCAL_DIR)/tee_udata.c \
 	$(LOCAL_DIR)/tee_obj.c \
 	$(LOCAL_DIR)/tee_pobj.c \
 	$(LOCAL_DIR)/tee_svc.c \
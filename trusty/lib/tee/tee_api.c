@@ -433,6 +433,7 @@ static int match_and_set_cancel(trusty_app_t *ta, void *data)
 
 	if (tee_api_info(ta)->parent_sess_id == session_id) {
 		tee_api_info(ta)->cancel = true;
+		tee_api_sync_cancel(tee_api_info(ta));
 		return 1;
 	}
 	return 0;
@@ -483,6 +484,7 @@ bool __SYSCALL sys_mask_cancel_flag(void)
 
 	prev_masked = ta_info->cancel_masked;
 	ta_info->cancel_masked = true;
+	tee_api_sync_cancel(ta_info);
 
 	return prev_masked;
 }
@@ -494,28 +496,25 @@ bool __SYSCALL sys_unmask_cancel_flag(void)
 
 	prev_masked = ta_info->cancel_masked;
 	ta_info->cancel_masked = false;
+	tee_api_sync_cancel(ta_info);
 
 	return prev_masked;
 }
 
+#if !WITH_SYSCALL_DISPATCH
+#error "privileged syscalls are only known from syscall_dispatch.h"
+#endif
+
+/*
+ * Only called for the syscalls marked SYSCALL_PRIVILEGED in syscall_table.h,
+ * none of which a TA without privileges may make.
+ */
 long syscall_privilege_check(unsigned long num)
 {
 	trusty_app_t *ta = tee_get_current_ta();
-	uint32_t privileges = ta->props.privileges;
-
-	switch (num) {
-	case __NR_port_create:
-	case __NR_connect:
-	case __NR_accept:
-	case __NR_connect_to_ta:
-	case __NR_set_cancel_flag:
-	case __NR_get_ta_flags:
-		if (!privileges)
-			return ERR_ACCESS_DENIED;
-		break;
-	default:
-		break;
-	}
+
+	if (!ta->props.privileges)
+		return ERR_ACCESS_DENIED;
 	return NO_ERROR;
 }
 
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2018, MIPS Tech, LLC and/or its affiliated group companies
+ * (“MIPS”).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <lib/tee/tee_handle.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <tee_api_defines.h>
+
+#define TEE_HANDLE_DB_MIN_SLOTS	16
+
+static TEE_Result tee_handle_db_grow(struct tee_handle_db *db)
+{
+	struct tee_handle_slot *slots;
+	uint32_t num_slots;
+	uint32_t n;
+
+	if (db->num_slots >= TEE_HANDLE_MAX_SLOTS)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	num_slots = db->num_slots ? db->num_slots * 2 : TEE_HANDLE_DB_MIN_SLOTS;
+	if (num_slots > TEE_HANDLE_MAX_SLOTS)
+		num_slots = TEE_HANDLE_MAX_SLOTS;
+
+	slots = realloc(db->slots, num_slots * sizeof(*slots));
+	if (!slots)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	memset(slots + db->num_slots, 0,
+	       (num_slots - db->num_slots) * sizeof(*slots));
+
+	/* chain the new slots in front of the (empty) free list */
+	for (n = db->num_slots; n < num_slots - 1; n++)
+		slots[n].next_free = n + 2;
+	slots[num_slots - 1].next_free = db->free_head;
+	db->free_head = db->num_slots + 1;
+
+	db->slots = slots;
+	db->num_slots = num_slots;
+	return TEE_SUCCESS;
+}
+
+TEE_Result tee_handle_get(struct tee_handle_db *db, void *ptr, uint32_t *id)
+{
+	TEE_Result res;
+	struct tee_handle_slot *slot;
+	uint32_t idx;
+
+	if (!ptr)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!db->free_head) {
+		res = tee_handle_db_grow(db);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	idx = db->free_head - 1;
+	slot = db->slots + idx;
+	db->free_head = slot->next_free;
+	slot->next_free = 0;
+	slot->ptr = ptr;
+
+	*id = ((uint32_t)slot->gen << TEE_HANDLE_SLOT_BITS) | (idx + 1);
+	return TEE_SUCCESS;
+}
+
+void *tee_handle_put(struct tee_handle_db *db, uint32_t id)
+{
+	struct tee_handle_slot *slot;
+	void *ptr = tee_handle_lookup(db, id);
+
+	if (!ptr)
+		return NULL;
+
+	slot = db->slots + ((id & TEE_HANDLE_SLOT_MASK) - 1);
+	slot->ptr = NULL;
+	slot->gen++;
+	slot->next_free = db->free_head;
+	db->free_head = (id & TEE_HANDLE_SLOT_MASK);
+	return ptr;
+}
+
+void tee_handle_db_destroy(struct tee_handle_db *db)
+{
+	free(db->slots);
+	db->slots = NULL;
+	db->num_slots = 0;
+	db->free_head = 0;
+}
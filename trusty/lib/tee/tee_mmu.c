@@ -77,7 +77,7 @@ status_t mmu_check_access_rights(const struct uthread *ut,
 		int res;
 
 		res = uthread_virt_to_phys_flags((uthread_t *)ut,
-				(vaddr_t)uaddr, &pa, &uflags);
+				(vaddr_t)uaddr, &pa, &uflags, false);
 		if (res != NO_ERROR)
 			goto err_exit;
 
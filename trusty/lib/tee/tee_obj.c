@@ -30,34 +30,45 @@
 #include <lib/tee/tee_obj.h>
 
 #include <stdlib.h>
+#include <string.h>
 #include <tee_api_defines.h>
 #include <lib/tee/tee_api.h>
 #include <lib/tee/tee_fs.h>
 #include <lib/tee/tee_pobj.h>
 #include <trace.h>
 #include <lib/tee/tee_svc_cryp.h>
+#include <lib/slab.h>
 
-void tee_obj_add(tee_api_info_t *ta_info, struct tee_obj *o)
+static slab_cache_t tee_obj_cache =
+	SLAB_CACHE_INITIAL_VALUE(tee_obj_cache, "tee_obj", sizeof(struct tee_obj), NULL);
+
+TEE_Result tee_obj_add(tee_api_info_t *ta_info, struct tee_obj *o)
 {
+	TEE_Result res;
+
+	res = tee_handle_get(&ta_info->obj_handles, o, &o->id);
+	if (res != TEE_SUCCESS)
+		return res;
+
 	list_add_tail(&ta_info->objects, &o->node);
+	return TEE_SUCCESS;
 }
 
 TEE_Result tee_obj_get(tee_api_info_t *ta_info, uint32_t obj_id,
 		       struct tee_obj **obj)
 {
-	struct tee_obj *o;
+	struct tee_obj *o = tee_handle_lookup(&ta_info->obj_handles, obj_id);
 
-	list_for_every_entry(&ta_info->objects, o, struct tee_obj, node) {
-		if (obj_id == (vaddr_t)o) {
-			*obj = o;
-			return TEE_SUCCESS;
-		}
-	}
-	return TEE_ERROR_BAD_PARAMETERS;
+	if (!o)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	*obj = o;
+	return TEE_SUCCESS;
 }
 
-void tee_obj_close(struct tee_obj *o)
+void tee_obj_close(tee_api_info_t *ta_info, struct tee_obj *o)
 {
+	tee_handle_put(&ta_info->obj_handles, o->id);
 	list_delete(&o->node);
 
 	if ((o->info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT)) {
@@ -74,13 +85,28 @@ void tee_obj_close_all(tee_api_info_t *ta_info)
 
 	list_for_every_entry_safe(&ta_info->objects, obj, next_obj,
 			struct tee_obj, node) {
-		tee_obj_close(obj);
+		tee_obj_close(ta_info, obj);
 	}
 }
 
 struct tee_obj *tee_obj_alloc(void)
 {
-	return calloc(1, sizeof(struct tee_obj));
+	struct tee_obj *o = slab_alloc(&tee_obj_cache);
+
+	if (o)
+		memset(o, 0, sizeof(*o));
+	return o;
+}
+
+void tee_obj_key_cache_drop(struct tee_obj *o)
+{
+	if (o->key_cache) {
+		memset(o->key_cache, 0, o->key_cache_size);
+		free(o->key_cache);
+	}
+	o->key_cache = NULL;
+	o->key_cache_size = 0;
+	o->key_cache_off = false;
 }
 
 void tee_obj_free(struct tee_obj *o)
@@ -88,6 +114,6 @@ void tee_obj_free(struct tee_obj *o)
 	if (o) {
 		tee_obj_attr_free(o);
 		free(o->attr);
-		free(o);
+		slab_free(&tee_obj_cache, o);
 	}
 }
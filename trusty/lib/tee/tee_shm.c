@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2016-2018, MIPS Tech, LLC and/or its affiliated group companies
+ * (“MIPS”).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <arch/ops.h>
+#include <kernel/mutex.h>
+#include <platform.h>
+#include <uthread.h>
+#include <lib/syscall.h>
+#include <tee_common_uapi.h>
+#include <lib/tee/tee_api.h>
+#include <lib/tee/tee_shm.h>
+
+#define TEE_LOCAL_TRACE 0
+#define TEE_TAG "KTEE"
+
+/*
+ * A registered range. The registry holds one reference and every cached
+ * mapping another one. A range is only unregistered once no TA maps it; an
+ * attempt before that marks it !registered, so it is mapped into no more TAs
+ * and each TA drops its mapping when its current message is done.
+ */
+struct tee_shm {
+	struct list_node node;
+	ext_vaddr_t buf;
+	size_t size;
+	volatile int refs;
+	volatile bool registered;
+};
+
+static struct list_node shm_list = LIST_INITIAL_VALUE(shm_list);
+static mutex_t shm_lock = MUTEX_INITIAL_VALUE(shm_lock);
+static u_int shm_count;
+
+static struct {
+	u_int hits;
+	u_int misses;
+	u_int evicts;
+	u_int temp;
+	u_int pagelist;
+	size_t pagelist_bytes;
+	lk_bigtime_t hit_us;
+	lk_bigtime_t miss_us;
+	lk_bigtime_t temp_us;
+	lk_bigtime_t pagelist_us;
+} shm_stats;	/* protected by shm_lock */
+
+/* count one call that began at start */
+static void tee_shm_stat(u_int *count, lk_bigtime_t *us, lk_bigtime_t start)
+{
+	lk_bigtime_t t = current_time_hires() - start;
+
+	mutex_acquire(&shm_lock);
+	(*count)++;
+	*us += t;
+	mutex_release(&shm_lock);
+}
+
+static void tee_shm_put(struct tee_shm *shm)
+{
+	if (atomic_add(&shm->refs, -1) == 1)
+		free(shm);
+}
+
+/* Only the Session Manager relays REE shared memory registration */
+static bool tee_shm_caller_is_sm(void)
+{
+	static const uuid_t sm_uuid = SM_UUID;
+	trusty_app_t *ta = tee_get_current_ta();
+
+	return !memcmp(&ta->props.uuid, &sm_uuid, sizeof(sm_uuid));
+}
+
+static bool tee_shm_contains(struct tee_shm *shm, ext_vaddr_t buf,
+		size_t size)
+{
+	return buf >= shm->buf && size <= shm->size &&
+		buf - shm->buf <= shm->size - size;
+}
+
+TEE_Result tee_shm_register(ext_vaddr_t buf, size_t size)
+{
+	struct tee_shm *shm;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!size || buf + size < buf)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_acquire(&shm_lock);
+
+	if (shm_count >= TEE_SHM_MAX_REGS) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	list_for_every_entry(&shm_list, shm, struct tee_shm, node) {
+		if (shm->buf == buf && shm->size == size) {
+			res = TEE_ERROR_BAD_STATE;
+			goto out;
+		}
+	}
+
+	shm = calloc(1, sizeof(*shm));
+	if (!shm) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	shm->buf = buf;
+	shm->size = size;
+	shm->refs = 1;
+	shm->registered = true;
+	list_add_tail(&shm_list, &shm->node);
+	shm_count++;
+
+out:
+	mutex_release(&shm_lock);
+	return res;
+}
+
+TEE_Result tee_shm_unregister(ext_vaddr_t buf, size_t size)
+{
+	struct tee_shm *shm;
+
+	mutex_acquire(&shm_lock);
+	list_for_every_entry(&shm_list, shm, struct tee_shm, node) {
+		if (shm->buf != buf || shm->size != size)
+			continue;
+
+		/*
+		 * A TA that maps the range may be in the middle of a message
+		 * and can reach the memory until it is done with it. The REE
+		 * has to retry once every such TA has dropped its mapping.
+		 */
+		if (shm->refs > 1) {
+			shm->registered = false;
+			mutex_release(&shm_lock);
+			return TEE_ERROR_BUSY;
+		}
+
+		/* refs only grow under shm_lock, no TA can map it any more */
+		list_delete(&shm->node);
+		shm_count--;
+		mutex_release(&shm_lock);
+
+		tee_shm_put(shm);
+		return TEE_SUCCESS;
+	}
+	mutex_release(&shm_lock);
+
+	return TEE_ERROR_ITEM_NOT_FOUND;
+}
+
+static struct tee_shm *tee_shm_get(ext_vaddr_t buf, size_t size)
+{
+	struct tee_shm *shm;
+
+	mutex_acquire(&shm_lock);
+	list_for_every_entry(&shm_list, shm, struct tee_shm, node) {
+		if (shm->registered && tee_shm_contains(shm, buf, size)) {
+			atomic_add(&shm->refs, 1);
+			mutex_release(&shm_lock);
+			return shm;
+		}
+	}
+	mutex_release(&shm_lock);
+
+	return NULL;
+}
+
+static void tee_shm_unmap(trusty_app_t *ta, struct tee_shm_map *map)
+{
+	list_delete(&map->node);
+	if (ta->ut)
+		uthread_revoke_pages(ta->ut, map->uaddr, map->size);
+	tee_shm_put(map->shm);
+	free(map);
+}
+
+status_t tee_shm_map_memref(trusty_app_t *ta, ext_vaddr_t buf, size_t size,
+		u_int flags, vaddr_t *uaddr)
+{
+	struct list_node *maps = &tee_api_info(ta)->shm_maps;
+	lk_bigtime_t start = current_time_hires();
+	struct tee_shm_map *map;
+	struct tee_shm *shm;
+	status_t res;
+
+	list_for_every_entry(maps, map, struct tee_shm_map, node) {
+		if (map->buf == buf && map->size == size &&
+				map->flags == flags && map->shm->registered) {
+			/* most recently used first */
+			list_delete(&map->node);
+			list_add_head(maps, &map->node);
+			*uaddr = map->uaddr;
+			tee_shm_stat(&shm_stats.hits, &shm_stats.hit_us,
+					start);
+			return NO_ERROR;
+		}
+	}
+
+	shm = tee_shm_get(buf, size);
+	if (!shm) {
+		res = uthread_grant_pages(ta->ut, NULL, buf, size, flags,
+				uaddr, true);
+		tee_shm_stat(&shm_stats.temp, &shm_stats.temp_us, start);
+		return res;
+	}
+
+	map = calloc(1, sizeof(*map));
+	if (!map) {
+		tee_shm_put(shm);
+		return ERR_NO_MEMORY;
+	}
+
+	if (list_length(maps) >= TEE_SHM_TA_MAPS) {
+		tee_shm_unmap(ta, list_peek_tail_type(maps,
+				struct tee_shm_map, node));
+		mutex_acquire(&shm_lock);
+		shm_stats.evicts++;
+		mutex_release(&shm_lock);
+	}
+
+	res = uthread_grant_pages(ta->ut, NULL, buf, size, flags, uaddr, true);
+	if (res < NO_ERROR) {
+		tee_shm_put(shm);
+		free(map);
+		return res;
+	}
+
+	map->shm = shm;
+	map->buf = buf;
+	map->size = size;
+	map->flags = flags;
+	map->uaddr = *uaddr;
+	list_add_head(maps, &map->node);
+
+	tee_shm_stat(&shm_stats.misses, &shm_stats.miss_us, start);
+
+	return NO_ERROR;
+}
+
+status_t tee_shm_map_pagelist(trusty_app_t *ta, ext_vaddr_t pagelist,
+		size_t size, u_int flags, vaddr_t *uaddr)
+{
+	lk_bigtime_t start = current_time_hires();
+	status_t res;
+
+	res = uthread_grant_ns_pagelist(ta->ut, pagelist, size, flags, uaddr);
+	if (res == NO_ERROR) {
+		lk_bigtime_t us = current_time_hires() - start;
+
+		mutex_acquire(&shm_lock);
+		shm_stats.pagelist++;
+		shm_stats.pagelist_bytes += size;
+		shm_stats.pagelist_us += us;
+		mutex_release(&shm_lock);
+	}
+
+	return res;
+}
+
+bool tee_shm_cached(trusty_app_t *ta, vaddr_t uaddr)
+{
+	struct tee_shm_map *map;
+
+	list_for_every_entry(&tee_api_info(ta)->shm_maps, map,
+			struct tee_shm_map, node) {
+		if (map->uaddr == uaddr)
+			return true;
+	}
+
+	return false;
+}
+
+void tee_shm_purge(trusty_app_t *ta)
+{
+	struct tee_shm_map *map, *tmp;
+
+	list_for_every_entry_safe(&tee_api_info(ta)->shm_maps, map, tmp,
+			struct tee_shm_map, node) {
+		if (!map->shm->registered)
+			tee_shm_unmap(ta, map);
+	}
+}
+
+void tee_shm_release(trusty_app_t *ta)
+{
+	struct tee_shm_map *map;
+
+	while ((map = list_remove_head_type(&tee_api_info(ta)->shm_maps,
+				struct tee_shm_map, node))) {
+		tee_shm_put(map->shm);
+		free(map);
+	}
+}
+
+TEE_Result __SYSCALL sys_register_shm(unsigned long buf, size_t size)
+{
+	if (!tee_shm_caller_is_sm())
+		return TEE_ERROR_ACCESS_DENIED;
+
+	return tee_shm_register(buf, size);
+}
+
+TEE_Result __SYSCALL sys_unregister_shm(unsigned long buf, size_t size)
+{
+	if (!tee_shm_caller_is_sm())
+		return TEE_ERROR_ACCESS_DENIED;
+
+	return tee_shm_unregister(buf, size);
+}
+
+#if WITH_LIB_CONSOLE
+#include <lib/console.h>
+
+static lk_bigtime_t avg_us(lk_bigtime_t us, u_int n)
+{
+	return n ? us / n : 0;
+}
+
+static int cmd_tee_shm(int argc, const cmd_args *argv)
+{
+	struct tee_shm *shm;
+	typeof(shm_stats) st;
+
+	mutex_acquire(&shm_lock);
+	if (argc > 1 && !strcmp(argv[1].str, "reset")) {
+		memset(&shm_stats, 0, sizeof(shm_stats));
+		mutex_release(&shm_lock);
+		return 0;
+	}
+
+	printf("%u registered ranges\n", shm_count);
+	list_for_every_entry(&shm_list, shm, struct tee_shm, node)
+		printf("  0x%llx size 0x%zx refs %d%s\n",
+				(unsigned long long)shm->buf, shm->size,
+				shm->refs, shm->registered ? "" : " unregistering");
+	st = shm_stats;
+	mutex_release(&shm_lock);
+
+	printf("memref maps: %u hits avg %llu us, %u misses avg %llu us, "
+			"%u evicted\n",
+			st.hits, avg_us(st.hit_us, st.hits),
+			st.misses, avg_us(st.miss_us, st.misses),
+			st.evicts);
+	printf("temporary memrefs: %u avg %llu us\n", st.temp,
+			avg_us(st.temp_us, st.temp));
+	printf("page list memrefs: %u avg %llu us, avg %zu KB\n",
+			st.pagelist, avg_us(st.pagelist_us, st.pagelist),
+			st.pagelist ? st.pagelist_bytes / 1024 / st.pagelist : 0);
+
+	return 0;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("tee_shm", "registered shared memory and memref map cost [reset]", &cmd_tee_shm)
+STATIC_COMMAND_END(tee_shm);
+#endif
@@ -41,6 +41,7 @@
 #include <string_ext.h>
 #include <string.h>
 #include <util.h>
+#include <lib/slab.h>
 #if defined(CFG_CRYPTO_HKDF) || defined(CFG_CRYPTO_CONCAT_KDF) || \
 	defined(CFG_CRYPTO_PBKDF2)
 #include <tee_api_defines_extensions.h>
@@ -58,15 +59,19 @@
 typedef void (*tee_cryp_ctx_finalize_func_t) (void *ctx, uint32_t algo);
 struct tee_cryp_state {
 	struct list_node node;
+	uint32_t id;		/* handle id given to the TA */
 	uint32_t algo;
 	uint32_t mode;
-	vaddr_t key1;
-	vaddr_t key2;
+	uint32_t key1;		/* handle ids of the key objects, 0 if none */
+	uint32_t key2;
 	size_t ctx_size;
 	void *ctx;
 	tee_cryp_ctx_finalize_func_t ctx_finalize;
 };
 
+static slab_cache_t cryp_state_cache = SLAB_CACHE_INITIAL_VALUE(cryp_state_cache,
+		"tee_cryp_state", sizeof(struct tee_cryp_state), NULL);
+
 struct tee_cryp_obj_secret {
 	uint32_t key_size;
 	uint32_t alloc_size;
@@ -835,8 +840,7 @@ TEE_Result __SYSCALL sys_utee_cryp_obj_get_info(unsigned long obj,
 	tee_api_info_t *ta_info = tee_current_ta_info();
 	struct tee_obj *o;
 
-	res = tee_obj_get(ta_info,
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(ta_info, obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -853,8 +857,7 @@ TEE_Result __SYSCALL sys_utee_cryp_obj_restrict_usage(unsigned long obj,
 	tee_api_info_t *ta_info = tee_current_ta_info();
 	struct tee_obj *o;
 
-	res = tee_obj_get(ta_info,
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(ta_info, obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -925,8 +928,7 @@ TEE_Result __SYSCALL sys_utee_cryp_obj_get_attr(unsigned long obj,
 	const struct attr_ops *ops;
 	void *attr;
 
-	res = tee_obj_get(ta_info,
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(ta_info, obj, &o);
 	if (res != TEE_SUCCESS)
 		return TEE_ERROR_ITEM_NOT_FOUND;
 
@@ -959,6 +961,7 @@ void tee_obj_attr_free(struct tee_obj *o)
 	const struct tee_cryp_obj_type_props *tp;
 	size_t n;
 
+	tee_obj_key_cache_drop(o);
 	if (!o->attr)
 		return;
 	tp = tee_svc_find_type_props(o->info.objectType);
@@ -977,6 +980,7 @@ void tee_obj_attr_clear(struct tee_obj *o)
 	const struct tee_cryp_obj_type_props *tp;
 	size_t n;
 
+	tee_obj_key_cache_drop(o);
 	if (!o->attr)
 		return;
 	tp = tee_svc_find_type_props(o->info.objectType);
@@ -1029,6 +1033,7 @@ TEE_Result tee_obj_attr_from_binary(struct tee_obj *o, const void *data,
 	size_t n;
 	size_t offs = 0;
 
+	tee_obj_key_cache_drop(o);
 	if (o->info.objectType == TEE_TYPE_DATA)
 		return TEE_SUCCESS; /* pure data object */
 	if (!o->attr)
@@ -1058,6 +1063,7 @@ TEE_Result tee_obj_attr_copy_from(struct tee_obj *o, const struct tee_obj *src)
 	void *attr;
 	void *src_attr;
 
+	tee_obj_key_cache_drop(o);
 	if (o->info.objectType == TEE_TYPE_DATA)
 		return TEE_SUCCESS; /* pure data object */
 	if (!o->attr)
@@ -1245,11 +1251,15 @@ TEE_Result __SYSCALL sys_utee_cryp_obj_alloc(unsigned long obj_type,
 		return res;
 	}
 
-	tee_obj_add(ta_info, o);
+	res = tee_obj_add(ta_info, o);
+	if (res != TEE_SUCCESS) {
+		tee_obj_free(o);
+		return res;
+	}
 
-	res = tee_svc_copy_kaddr_to_uref(obj, o);
+	res = tee_svc_copy_to_user(obj, &o->id, sizeof(o->id));
 	if (res != TEE_SUCCESS)
-		tee_obj_close(o);
+		tee_obj_close(ta_info, o);
 	return res;
 }
 
@@ -1259,8 +1269,7 @@ TEE_Result __SYSCALL sys_utee_cryp_obj_close(unsigned long obj)
 	tee_api_info_t *ta_info = tee_current_ta_info();
 	struct tee_obj *o;
 
-	res = tee_obj_get(ta_info,
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(ta_info, obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1271,7 +1280,7 @@ TEE_Result __SYSCALL sys_utee_cryp_obj_close(unsigned long obj)
 	if (o->busy)
 		return TEE_ERROR_ITEM_NOT_FOUND;
 
-	tee_obj_close(o);
+	tee_obj_close(ta_info, o);
 	return TEE_SUCCESS;
 }
 
@@ -1281,8 +1290,7 @@ TEE_Result __SYSCALL sys_utee_cryp_obj_reset(unsigned long obj)
 	tee_api_info_t *ta_info = tee_current_ta_info();
 	struct tee_obj *o;
 
-	res = tee_obj_get(ta_info,
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(ta_info, obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1493,6 +1501,7 @@ static TEE_Result tee_svc_cryp_obj_populate_type(
 	const struct attr_ops *ops;
 	void *attr;
 
+	tee_obj_key_cache_drop(o);
 	for (n = 0; n < attr_count; n++) {
 		idx = tee_svc_cryp_obj_find_type_attr_idx(
 							attrs[n].attributeID,
@@ -1557,8 +1566,7 @@ TEE_Result __SYSCALL sys_utee_cryp_obj_populate(unsigned long obj,
 	const struct tee_cryp_obj_type_props *type_props;
 	TEE_Attribute *attrs = NULL;
 
-	res = tee_obj_get(ta_info,
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(ta_info, obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1604,13 +1612,11 @@ TEE_Result __SYSCALL sys_utee_cryp_obj_copy(unsigned long dst,
 	struct tee_obj *dst_o;
 	struct tee_obj *src_o;
 
-	res = tee_obj_get(ta_info,
-			  tee_svc_uref_to_vaddr(dst), &dst_o);
+	res = tee_obj_get(ta_info, dst, &dst_o);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_obj_get(ta_info,
-			  tee_svc_uref_to_vaddr(src), &src_o);
+	res = tee_obj_get(ta_info, src, &src_o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1757,8 +1763,7 @@ TEE_Result __SYSCALL sys_utee_cryp_obj_generate_key(unsigned long obj,
 	size_t byte_size;
 	TEE_Attribute *params = NULL;
 
-	res = tee_obj_get(ta_info,
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(ta_info, obj, &o);
 	if (res != TEE_SUCCESS)
 		return TEE_ERROR_ITEM_NOT_FOUND;
 
@@ -1769,6 +1774,7 @@ TEE_Result __SYSCALL sys_utee_cryp_obj_generate_key(unsigned long obj,
 	/* Must not be initialized already */
 	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) != 0)
 		return TEE_ERROR_BAD_STATE;
+	tee_obj_key_cache_drop(o);
 
 	/* Find description of object */
 	type_props = tee_svc_find_type_props(o->info.objectType);
@@ -1873,14 +1879,12 @@ static TEE_Result tee_svc_cryp_get_state(tee_api_info_t *ta_info,
 {
 	struct tee_cryp_state *s;
 
-	list_for_every_entry(&ta_info->cryp_states, s, struct tee_cryp_state,
-			node) {
-		if (state_id == (vaddr_t)s) {
-			*state = s;
-			return TEE_SUCCESS;
-		}
-	}
-	return TEE_ERROR_BAD_PARAMETERS;
+	s = tee_handle_lookup(&ta_info->cryp_state_handles, state_id);
+	if (!s)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	*state = s;
+	return TEE_SUCCESS;
 }
 
 static void cryp_state_free(tee_api_info_t *ta_info, struct tee_cryp_state *cs)
@@ -1888,15 +1892,16 @@ static void cryp_state_free(tee_api_info_t *ta_info, struct tee_cryp_state *cs)
 	struct tee_obj *o;
 
 	if (tee_obj_get(ta_info, cs->key1, &o) == TEE_SUCCESS)
-		tee_obj_close(o);
+		tee_obj_close(ta_info, o);
 	if (tee_obj_get(ta_info, cs->key2, &o) == TEE_SUCCESS)
-		tee_obj_close(o);
+		tee_obj_close(ta_info, o);
 
+	tee_handle_put(&ta_info->cryp_state_handles, cs->id);
 	list_delete(&cs->node);
 	if (cs->ctx_finalize != NULL)
 		cs->ctx_finalize(cs->ctx, cs->algo);
 	free(cs->ctx);
-	free(cs);
+	slab_free(&cryp_state_cache, cs);
 }
 
 static TEE_Result tee_svc_cryp_check_key_type(const struct tee_obj *o,
@@ -1994,7 +1999,7 @@ TEE_Result __SYSCALL sys_utee_cryp_state_alloc(unsigned long algo,
 	struct tee_obj *o2 = NULL;
 
 	if (key1 != 0) {
-		res = tee_obj_get(ta_info, tee_svc_uref_to_vaddr(key1), &o1);
+		res = tee_obj_get(ta_info, key1, &o1);
 		if (res != TEE_SUCCESS)
 			return res;
 		if (o1->busy)
@@ -2004,7 +2009,7 @@ TEE_Result __SYSCALL sys_utee_cryp_state_alloc(unsigned long algo,
 			return res;
 	}
 	if (key2 != 0) {
-		res = tee_obj_get(ta_info, tee_svc_uref_to_vaddr(key2), &o2);
+		res = tee_obj_get(ta_info, key2, &o2);
 		if (res != TEE_SUCCESS)
 			return res;
 		if (o2->busy)
@@ -2014,9 +2019,15 @@ TEE_Result __SYSCALL sys_utee_cryp_state_alloc(unsigned long algo,
 			return res;
 	}
 
-	cs = calloc(1, sizeof(struct tee_cryp_state));
+	cs = slab_alloc(&cryp_state_cache);
 	if (!cs)
 		return TEE_ERROR_OUT_OF_MEMORY;
+	memset(cs, 0, sizeof(*cs));
+	res = tee_handle_get(&ta_info->cryp_state_handles, cs, &cs->id);
+	if (res != TEE_SUCCESS) {
+		slab_free(&cryp_state_cache, cs);
+		return res;
+	}
 	list_add_tail(&ta_info->cryp_states, &cs->node);
 	cs->algo = algo;
 	cs->mode = mode;
@@ -2103,18 +2114,18 @@ TEE_Result __SYSCALL sys_utee_cryp_state_alloc(unsigned long algo,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = tee_svc_copy_kaddr_to_uref(state, cs);
+	res = tee_svc_copy_to_user(state, &cs->id, sizeof(cs->id));
 	if (res != TEE_SUCCESS)
 		goto out;
 
 	/* Register keys */
 	if (o1 != NULL) {
 		o1->busy = true;
-		cs->key1 = (vaddr_t)o1;
+		cs->key1 = o1->id;
 	}
 	if (o2 != NULL) {
 		o2->busy = true;
-		cs->key2 = (vaddr_t)o2;
+		cs->key2 = o2->id;
 	}
 
 out:
@@ -2131,13 +2142,11 @@ TEE_Result __SYSCALL sys_utee_cryp_state_copy(unsigned long dst,
 	struct tee_cryp_state *cs_src;
 	tee_api_info_t *ta_info = tee_current_ta_info();
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(dst),
-			&cs_dst);
+	res = tee_svc_cryp_get_state(ta_info, dst, &cs_dst);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(src),
-			&cs_src);
+	res = tee_svc_cryp_get_state(ta_info, src, &cs_src);
 	if (res != TEE_SUCCESS)
 		return res;
 	if (cs_dst->algo != cs_src->algo || cs_dst->mode != cs_src->mode)
@@ -2166,63 +2175,128 @@ TEE_Result __SYSCALL sys_utee_cryp_state_free(unsigned long state)
 	struct tee_cryp_state *cs;
 	tee_api_info_t *ta_info = tee_current_ta_info();
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 	cryp_state_free(ta_info, cs);
 	return TEE_SUCCESS;
 }
 
-TEE_Result __SYSCALL sys_utee_hash_init(unsigned long state,
-			     const void *iv __maybe_unused,
-			     size_t iv_len __maybe_unused)
+/*
+ * Key schedule cache. The context produced by a full init() is copied to
+ * the key object. When the same state is initialized again with the
+ * unchanged key, typically with a new IV for each packet, the provider's
+ * reinit() restores that copy instead of expanding the key again. Any
+ * change to the key's attributes drops the copy, see tee_obj_attr_clear().
+ * States with two keys (XTS) are not cached.
+ */
+static const void *cryp_key_cache_lookup(struct tee_cryp_state *cs,
+					 struct tee_obj *o)
+{
+	if (cs->key2 || !o->key_cache || o->key_cache_algo != cs->algo ||
+	    o->key_cache_mode != cs->mode || o->key_cache_size != cs->ctx_size)
+		return NULL;
+	return o->key_cache;
+}
+
+static void cryp_key_cache_store(struct tee_cryp_state *cs, struct tee_obj *o)
+{
+	if (cs->key2 || o->key_cache_off)
+		return;
+
+	tee_obj_key_cache_drop(o);
+	/* best effort, a failed allocation only means no caching */
+	o->key_cache = malloc(cs->ctx_size);
+	if (!o->key_cache)
+		return;
+	memcpy(o->key_cache, cs->ctx, cs->ctx_size);
+	o->key_cache_size = cs->ctx_size;
+	o->key_cache_algo = cs->algo;
+	o->key_cache_mode = cs->mode;
+}
+
+/* The provider can't reuse contexts of this algorithm */
+static void cryp_key_cache_disable(struct tee_obj *o)
+{
+	tee_obj_key_cache_drop(o);
+	o->key_cache_off = true;
+}
+
+static TEE_Result cryp_get_mac_key(tee_api_info_t *ta_info,
+				   struct tee_cryp_state *cs,
+				   struct tee_obj **obj)
 {
 	TEE_Result res;
-	struct tee_cryp_state *cs;
-	tee_api_info_t *ta_info = tee_current_ta_info();
+	struct tee_obj *o;
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_obj_get(ta_info, cs->key1, &o);
 	if (res != TEE_SUCCESS)
 		return res;
+	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	*obj = o;
+	return TEE_SUCCESS;
+}
+
+static TEE_Result cryp_mac_init(struct tee_cryp_state *cs, struct tee_obj *o)
+{
+	TEE_Result res;
+	struct tee_cryp_obj_secret *key = o->attr;
+	const void *cached;
+
+	if (!crypto_ops.mac.init)
+		return TEE_ERROR_NOT_IMPLEMENTED;
+
+	cached = cryp_key_cache_lookup(cs, o);
+	if (cached && crypto_ops.mac.reinit) {
+		res = crypto_ops.mac.reinit(cs->ctx, cached, cs->algo);
+		if (res != TEE_ERROR_NOT_SUPPORTED)
+			return res;
+		cryp_key_cache_disable(o);
+	}
+
+	res = crypto_ops.mac.init(cs->ctx, cs->algo, (void *)(key + 1),
+				  key->key_size);
+	if (res == TEE_SUCCESS && crypto_ops.mac.reinit)
+		cryp_key_cache_store(cs, o);
+	return res;
+}
+
+static TEE_Result cryp_hash_init(tee_api_info_t *ta_info,
+				 struct tee_cryp_state *cs)
+{
+	TEE_Result res;
+	struct tee_obj *o;
 
 	switch (TEE_ALG_GET_CLASS(cs->algo)) {
 	case TEE_OPERATION_DIGEST:
 		if (!crypto_ops.hash.init)
 			return TEE_ERROR_NOT_IMPLEMENTED;
-		res = crypto_ops.hash.init(cs->ctx, cs->algo);
+		return crypto_ops.hash.init(cs->ctx, cs->algo);
+	case TEE_OPERATION_MAC:
+		res = cryp_get_mac_key(ta_info, cs, &o);
 		if (res != TEE_SUCCESS)
 			return res;
-		break;
-	case TEE_OPERATION_MAC:
-		{
-			struct tee_obj *o;
-			struct tee_cryp_obj_secret *key;
-
-			res = tee_obj_get(ta_info,
-					  cs->key1, &o);
-			if (res != TEE_SUCCESS)
-				return res;
-			if ((o->info.handleFlags &
-			     TEE_HANDLE_FLAG_INITIALIZED) == 0)
-				return TEE_ERROR_BAD_PARAMETERS;
-
-			key = (struct tee_cryp_obj_secret *)o->attr;
-			if (!crypto_ops.mac.init)
-				return TEE_ERROR_NOT_IMPLEMENTED;
-			res = crypto_ops.mac.init(cs->ctx, cs->algo,
-						  (void *)(key + 1),
-						  key->key_size);
-			if (res != TEE_SUCCESS)
-				return res;
-			break;
-		}
+		return cryp_mac_init(cs, o);
 	default:
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
+}
 
-	return TEE_SUCCESS;
+TEE_Result __SYSCALL sys_utee_hash_init(unsigned long state,
+			     const void *iv __maybe_unused,
+			     size_t iv_len __maybe_unused)
+{
+	TEE_Result res;
+	struct tee_cryp_state *cs;
+	tee_api_info_t *ta_info = tee_current_ta_info();
+
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	return cryp_hash_init(ta_info, cs);
 }
 
 TEE_Result __SYSCALL sys_utee_hash_update(unsigned long state,
@@ -2248,8 +2322,7 @@ TEE_Result __SYSCALL sys_utee_hash_update(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2310,8 +2383,7 @@ TEE_Result __SYSCALL sys_utee_hash_final(unsigned long state, const void *chunk,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2374,6 +2446,248 @@ out:
 	return res;
 }
 
+/* Number of messages copied in and hashed per provider call */
+#define HASH_BATCH_CHUNK	16
+
+/*
+ * Finish whatever the state holds and initialize it again. A plain init on
+ * top of a live HMAC context would leak the key copy LibTomCrypt allocates.
+ */
+static TEE_Result cryp_hash_reset(tee_api_info_t *ta_info,
+				  struct tee_cryp_state *cs, size_t digest_size)
+{
+	uint8_t scratch[TEE_MAX_HASH_SIZE];
+
+	if (digest_size > sizeof(scratch))
+		return TEE_ERROR_BAD_STATE;
+
+	/* the result is discarded, an incomplete CBC-MAC may legally fail */
+	if (TEE_ALG_GET_CLASS(cs->algo) == TEE_OPERATION_MAC) {
+		if (crypto_ops.mac.final)
+			crypto_ops.mac.final(cs->ctx, cs->algo, scratch,
+					     digest_size);
+	} else {
+		if (crypto_ops.hash.final)
+			crypto_ops.hash.final(cs->ctx, cs->algo, scratch,
+					      digest_size);
+	}
+	memset(scratch, 0, sizeof(scratch));
+
+	return cryp_hash_init(ta_info, cs);
+}
+
+/* Hash messages one at a time through the state's own context */
+static TEE_Result cryp_hash_batch_serial(tee_api_info_t *ta_info,
+					 struct tee_cryp_state *cs, size_t num,
+					 const uint8_t * const *data,
+					 const size_t *len,
+					 uint8_t * const *digest,
+					 size_t digest_size)
+{
+	TEE_Result res;
+	bool is_mac = TEE_ALG_GET_CLASS(cs->algo) == TEE_OPERATION_MAC;
+	size_t n;
+
+	if (is_mac ? (!crypto_ops.mac.update || !crypto_ops.mac.final) :
+		     (!crypto_ops.hash.update || !crypto_ops.hash.final))
+		return TEE_ERROR_NOT_IMPLEMENTED;
+
+	/* the state is freshly initialized on entry and on return */
+	for (n = 0; n < num; n++) {
+		if (is_mac) {
+			res = crypto_ops.mac.update(cs->ctx, cs->algo,
+						    data[n], len[n]);
+			if (res == TEE_SUCCESS)
+				res = crypto_ops.mac.final(cs->ctx, cs->algo,
+							   digest[n],
+							   digest_size);
+		} else {
+			res = crypto_ops.hash.update(cs->ctx, cs->algo,
+						     data[n], len[n]);
+			if (res == TEE_SUCCESS)
+				res = crypto_ops.hash.final(cs->ctx, cs->algo,
+							    digest[n],
+							    digest_size);
+		}
+		if (res != TEE_SUCCESS)
+			return res;
+		res = cryp_hash_init(ta_info, cs);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Copy in msgs[done..done + num) and check them. Sets *short_buffer if a
+ * digest buffer is smaller than digest_size; the others are checked for
+ * write access.
+ */
+static TEE_Result cryp_hash_batch_get(uthread_t *ut,
+				      struct utee_hash_msg *msgs, size_t done,
+				      size_t num, size_t digest_size,
+				      struct utee_hash_msg *m,
+				      const uint8_t **data, size_t *len,
+				      uint8_t **digest, bool *short_buffer)
+{
+	TEE_Result res;
+	size_t n;
+
+	res = tee_svc_copy_from_user(m, msgs + done, num * sizeof(m[0]));
+	if (res != TEE_SUCCESS)
+		return res;
+
+	for (n = 0; n < num; n++) {
+		data[n] = (const uint8_t *)(uintptr_t)m[n].data;
+		len[n] = m[n].data_len;
+		digest[n] = (uint8_t *)(uintptr_t)m[n].digest;
+
+		if ((!data[n] && len[n]) || len[n] != m[n].data_len)
+			return TEE_ERROR_BAD_PARAMETERS;
+
+		res = tee_mmu_check_access_rights(ut,
+				TEE_MEMORY_ACCESS_READ |
+				TEE_MEMORY_ACCESS_ANY_OWNER,
+				(uaddr_t)data[n], len[n]);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		if (m[n].digest_len < digest_size) {
+			*short_buffer = true;
+			continue;
+		}
+
+		res = tee_mmu_check_access_rights(ut,
+				TEE_MEMORY_ACCESS_READ |
+				TEE_MEMORY_ACCESS_WRITE |
+				TEE_MEMORY_ACCESS_ANY_OWNER,
+				(uaddr_t)digest[n], digest_size);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
+/* report the digest size back, as sys_utee_hash_final() */
+static TEE_Result cryp_hash_batch_put(struct utee_hash_msg *msgs, size_t done,
+				      size_t num, size_t digest_size,
+				      struct utee_hash_msg *m)
+{
+	size_t n;
+
+	for (n = 0; n < num; n++)
+		m[n].digest_len = digest_size;
+
+	return tee_svc_copy_to_user(msgs + done, m, num * sizeof(m[0]));
+}
+
+TEE_Result __SYSCALL sys_utee_hash_batch(unsigned long state,
+			struct utee_hash_msg *msgs,
+			unsigned long num_msgs)
+{
+	TEE_Result res;
+	struct tee_cryp_state *cs;
+	struct tee_cryp_obj_secret *key = NULL;
+	struct tee_obj *o;
+	struct utee_hash_msg m[HASH_BATCH_CHUNK];
+	const uint8_t *data[HASH_BATCH_CHUNK];
+	uint8_t *digest[HASH_BATCH_CHUNK];
+	size_t len[HASH_BATCH_CHUNK];
+	size_t digest_size;
+	size_t done, num;
+	bool short_buffer = false;
+	tee_api_info_t *ta_info = tee_current_ta_info();
+	uthread_t *ut = uthread_get_current();
+
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	switch (TEE_ALG_GET_CLASS(cs->algo)) {
+	case TEE_OPERATION_DIGEST:
+		res = tee_hash_get_digest_size(cs->algo, &digest_size);
+		break;
+	case TEE_OPERATION_MAC:
+		res = tee_mac_get_digest_size(cs->algo, &digest_size);
+		if (res == TEE_SUCCESS)
+			res = cryp_get_mac_key(ta_info, cs, &o);
+		if (res == TEE_SUCCESS)
+			key = o->attr;
+		break;
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/*
+	 * Check every message before anything is hashed, so that a short
+	 * digest buffer leaves the state and all digests untouched.
+	 */
+	for (done = 0; done < num_msgs; done += num) {
+		num = MIN(num_msgs - done, (size_t)HASH_BATCH_CHUNK);
+		res = cryp_hash_batch_get(ut, msgs, done, num, digest_size,
+					  m, data, len, digest, &short_buffer);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	if (short_buffer) {
+		for (done = 0; done < num_msgs; done += num) {
+			num = MIN(num_msgs - done, (size_t)HASH_BATCH_CHUNK);
+			res = tee_svc_copy_from_user(m, msgs + done,
+						     num * sizeof(m[0]));
+			if (res == TEE_SUCCESS)
+				res = cryp_hash_batch_put(msgs, done, num,
+							  digest_size, m);
+			if (res != TEE_SUCCESS)
+				return res;
+		}
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	/* drop any data already hashed into the state */
+	res = cryp_hash_reset(ta_info, cs, digest_size);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	for (done = 0; done < num_msgs; done += num) {
+		num = MIN(num_msgs - done, (size_t)HASH_BATCH_CHUNK);
+
+		/* copied in again, the TA may have changed them meanwhile */
+		res = cryp_hash_batch_get(ut, msgs, done, num, digest_size,
+					  m, data, len, digest, &short_buffer);
+		if (res != TEE_SUCCESS)
+			return res;
+		if (short_buffer)
+			return TEE_ERROR_BAD_STATE;
+
+		res = TEE_ERROR_NOT_SUPPORTED;
+		if (key && crypto_ops.mac.batch)
+			res = crypto_ops.mac.batch(cs->algo,
+					(void *)(key + 1),
+					key->key_size, num, data, len,
+					digest);
+		else if (!key && crypto_ops.hash.batch)
+			res = crypto_ops.hash.batch(cs->algo, num,
+					data, len, digest);
+		if (res == TEE_ERROR_NOT_SUPPORTED)
+			res = cryp_hash_batch_serial(ta_info, cs, num,
+					data, len, digest,
+					digest_size);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		res = cryp_hash_batch_put(msgs, done, num, digest_size, m);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result __SYSCALL sys_utee_cipher_init(unsigned long state, const void *iv,
 			size_t iv_len)
 {
@@ -2381,10 +2695,11 @@ TEE_Result __SYSCALL sys_utee_cipher_init(unsigned long state, const void *iv,
 	struct tee_cryp_state *cs;
 	tee_api_info_t *ta_info = tee_current_ta_info();
 	struct tee_obj *o;
+	struct tee_obj *ko;
 	struct tee_cryp_obj_secret *key1;
+	const void *cached;
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2401,11 +2716,21 @@ TEE_Result __SYSCALL sys_utee_cipher_init(unsigned long state, const void *iv,
 	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	ko = o;
 	key1 = o->attr;
 
 	if (!crypto_ops.cipher.init)
 		return TEE_ERROR_NOT_IMPLEMENTED;
 
+	cached = cryp_key_cache_lookup(cs, ko);
+	if (cached && crypto_ops.cipher.reinit) {
+		res = crypto_ops.cipher.reinit(cs->ctx, cached, cs->algo,
+					       cs->mode, iv, iv_len);
+		if (res != TEE_ERROR_NOT_SUPPORTED)
+			goto out;
+		cryp_key_cache_disable(ko);
+	}
+
 	if (tee_obj_get(ta_info, cs->key2, &o) == TEE_SUCCESS) {
 		struct tee_cryp_obj_secret *key2 = o->attr;
 
@@ -2426,6 +2751,9 @@ TEE_Result __SYSCALL sys_utee_cipher_init(unsigned long state, const void *iv,
 					     0,
 					     iv, iv_len);
 	}
+	if (res == TEE_SUCCESS && crypto_ops.cipher.reinit)
+		cryp_key_cache_store(cs, ko);
+out:
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2443,8 +2771,7 @@ static TEE_Result tee_svc_cipher_update_helper(unsigned long state,
 	uint64_t dlen;
 	uthread_t *ut = uthread_get_current();
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2667,8 +2994,7 @@ TEE_Result __SYSCALL sys_utee_cryp_derive_key(unsigned long state,
 	const struct tee_cryp_obj_type_props *type_props;
 	TEE_Attribute *params = NULL;
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2685,7 +3011,7 @@ TEE_Result __SYSCALL sys_utee_cryp_derive_key(unsigned long state,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = tee_obj_get(ta_info, tee_svc_uref_to_vaddr(derived_key), &so);
+	res = tee_obj_get(ta_info, derived_key, &so);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -2894,9 +3220,9 @@ TEE_Result __SYSCALL sys_utee_authenc_init(unsigned long state,
 	tee_api_info_t *ta_info = tee_current_ta_info();
 	struct tee_obj *o;
 	struct tee_cryp_obj_secret *key;
+	const void *cached;
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2908,11 +3234,25 @@ TEE_Result __SYSCALL sys_utee_authenc_init(unsigned long state,
 
 	if (!crypto_ops.authenc.init)
 		return TEE_ERROR_NOT_IMPLEMENTED;
+
+	cached = cryp_key_cache_lookup(cs, o);
+	if (cached && crypto_ops.authenc.reinit) {
+		res = crypto_ops.authenc.reinit(cs->ctx, cached, cs->algo,
+						cs->mode, nonce, nonce_len,
+						tag_len, aad_len, payload_len);
+		if (res != TEE_ERROR_NOT_SUPPORTED)
+			goto out;
+		cryp_key_cache_disable(o);
+	}
+
 	key = o->attr;
 	res = crypto_ops.authenc.init(cs->ctx, cs->algo, cs->mode,
 				      (uint8_t *)(key + 1), key->key_size,
 				      nonce, nonce_len, tag_len, aad_len,
 				      payload_len);
+	if (res == TEE_SUCCESS && crypto_ops.authenc.reinit)
+		cryp_key_cache_store(cs, o);
+out:
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2936,8 +3276,7 @@ TEE_Result __SYSCALL sys_utee_authenc_update_aad(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2962,8 +3301,7 @@ TEE_Result __SYSCALL sys_utee_authenc_update_payload(unsigned long state,
 	size_t tmp_dlen;
 	uthread_t *ut = uthread_get_current();
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3023,8 +3361,7 @@ TEE_Result __SYSCALL sys_utee_authenc_enc_final(unsigned long state,
 	size_t tmp_tlen;
 	uthread_t *ut = uthread_get_current();
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3111,8 +3448,7 @@ TEE_Result __SYSCALL sys_utee_authenc_dec_final(unsigned long state,
 	size_t tmp_dlen;
 	uthread_t *ut = uthread_get_current();
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3214,8 +3550,7 @@ TEE_Result __SYSCALL sys_utee_asymm_operate(unsigned long state,
 	TEE_Attribute *params = NULL;
 	uthread_t *ut = uthread_get_current();
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3399,8 +3734,7 @@ TEE_Result __SYSCALL sys_utee_asymm_verify(unsigned long state,
 	uint32_t hash_algo;
 	uthread_t *ut = uthread_get_current();
 
-	res = tee_svc_cryp_get_state(ta_info, tee_svc_uref_to_vaddr(state),
-			&cs);
+	res = tee_svc_cryp_get_state(ta_info, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
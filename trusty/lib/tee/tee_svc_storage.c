@@ -509,7 +509,7 @@ err:
 		fops->close(&o->fh);
 	if (po)
 		tee_pobj_release(po);
-	free(o);
+	tee_obj_free(o);
 
 	return res;
 }
@@ -37,6 +37,7 @@
 #include <tee_common_uapi.h>
 #include <lib/tee/tee_api.h>
 #include <lib/tee/tee_obj.h>
+#include <lib/tee/tee_shm.h>
 #include <lib/tee/tee_svc_cryp.h>
 #include <lib/tee/tee_svc_storage.h>
 
@@ -258,6 +259,7 @@ static status_t ta_poll_msg(msg_map_t *msg_buf)
 	do {
 		sys_res = k_sys_wait_any(&ev, INFINITE_TIME);
 		ta_info->cancel = false;
+		tee_api_sync_cancel(ta_info);
 		if (sys_res < 0) {
 			res = (int)sys_res;
 			return res;
@@ -343,6 +345,10 @@ static status_t ta_munmap_memref(msg_map_t *msg_buf)
 			if (!memref_buffer)
 				continue;
 
+			/* registered shm stays mapped for the next invoke */
+			if (tee_shm_cached(tee_get_current_ta(), memref_buffer))
+				continue;
+
 			res = uthread_revoke_pages(tee_get_current_ta()->ut,
 					memref_buffer, size);
 			if (res < NO_ERROR)
@@ -479,16 +485,24 @@ static status_t ta_mmap_memref(msg_map_t *msg_buf)
 			continue;
 
 		// TODO add TEE support for mapping a chain of multiple memrefs
-		// TEE mapping of fragmented memrefs is not implemented; REE
-		// must enforce contiguous memref regions from its user space.
-		if (ns_src)
+		// Fragmented NS memrefs must be passed as a page list, any
+		// other NS memref is a physically contiguous region.
+		if (ns_src && !(msg_buf->ns_pagelist & (1U << i)))
 			uflags |= UTM_PHYS_CONTIG;
 
 		if (ut_src)
 			uflags |= UTM_NS_MEM;
 
-		res = uthread_grant_pages(ut_target, ut_src, memref_buffer,
-			size, uflags, &uaddr_mapped, ns_src);
+		if (ns_src && !(uflags & UTM_PHYS_CONTIG))
+			res = tee_shm_map_pagelist(tee_get_current_ta(),
+				memref_buffer, size, uflags, &uaddr_mapped);
+		else if (ns_src)
+			res = tee_shm_map_memref(tee_get_current_ta(),
+				memref_buffer, size, uflags, &uaddr_mapped);
+		else
+			res = uthread_grant_pages(ut_target, ut_src,
+				memref_buffer, size, uflags, &uaddr_mapped,
+				ns_src);
 		if (res < NO_ERROR) {
 			/*
 			 * mapping 'i' failed, zero paramtype for remaining
@@ -526,6 +540,8 @@ static status_t ta_preprocess_msg(msg_map_t *sm_msg, msg_map_t *ta_msg)
 	tee_api_info_t *ta_info = tee_current_ta_info();
 	status_t res = NO_ERROR;
 
+	tee_shm_purge(tee_get_current_ta());
+
 	res = ta_mmap_memref(sm_msg);
 	if (res < 0)
 		goto preprocess_err;
@@ -724,6 +740,9 @@ static status_t ta_postprocess_msg(msg_map_t *sm_msg, msg_map_t *ta_msg)
 	if (res < 0)
 		goto postprocess_err;
 
+	/* before the reply lets the REE retry an unregister */
+	tee_shm_purge(tee_get_current_ta());
+
 	res = ta_send_reply(sm_msg, ta_msg);
 	if (res < 0)
 		goto postprocess_err;
@@ -769,7 +788,7 @@ static status_t ta_init_msg_buf(user_addr_t user_msg_buf, msg_map_t **sm_msg,
 
 	/* get kernel address of user space message buffer */
 	res = uthread_virt_to_kvaddr(ut, (vaddr_t)user_msg_buf,
-			&msg_buf_kaddr);
+			&msg_buf_kaddr, true);
 	if (res < NO_ERROR)
 		return res;
 
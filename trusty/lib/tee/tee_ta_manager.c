@@ -38,6 +38,8 @@
 #include <tee_common_uapi.h>
 #include <tee_api_properties.h>
 #include <lib/tee/tee_api.h>
+#include <lib/tee/tee_shm.h>
+#include <lib/tee/tee_udata.h>
 
 #define TEE_LOCAL_TRACE 0
 #define TEE_TAG "KTEE"
@@ -197,6 +199,10 @@ TEE_Result __SYSCALL sys_get_ta_flags(const uuid_t *dest_uuid, uint32_t *flags)
 		return TEE_ERROR_ITEM_NOT_FOUND;
 	}
 
+	/* the flags are read from the image when the TA is loaded */
+	if (trusty_app_load(trusty_app))
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
 	value = is_single_instance(trusty_app);
 	ta_flags |= value ? TA_FLAGS_SINGLE_INSTANCE : 0;
 	value = is_multi_session(trusty_app);
@@ -289,6 +295,13 @@ static status_t tee_api_load_properties(trusty_app_t *ta)
 	if (ta->is_parent)
 		res = properties_copy_from_user(ta);
 
+	/* pooled instances are only handed out as new multi instance clones */
+	if (ta->is_parent && kprops->single_instance &&
+			ta->props.instance_pool) {
+		dprintf(CRITICAL, "single instance TA: INSTANCE_POOL ignored\n");
+		ta->props.instance_pool = 0;
+	}
+
 	if (!ta->is_parent) {
 		trusty_app_t *ta_parent;
 		ta_parent = trusty_app_find_by_uuid(&ta->props.uuid);
@@ -308,6 +321,10 @@ static void tee_api_info_free(trusty_app_t *ta)
 	tee_api_info_t *ta_info = tee_api_info(ta);
 
 	if (ta_info) {
+		tee_shm_release(ta);
+		tee_udata_free(ta_info);
+		tee_handle_db_destroy(&ta_info->cryp_state_handles);
+		tee_handle_db_destroy(&ta_info->obj_handles);
 		memset(ta_info, 0, sizeof(*ta_info));
 		free(ta_info);
 		trusty_als_set(ta, _tee_api_info_slot_id, NULL);
@@ -355,8 +372,9 @@ static status_t tee_api_info_init(trusty_app_t *ta)
 	list_initialize(&ta_info->operation_list);
 	list_initialize(&ta_info->cryp_states);
 	list_initialize(&ta_info->objects);
+	list_initialize(&ta_info->shm_maps);
 
-	return NO_ERROR;
+	return tee_udata_map(ta, ta_info);
 }
 
 static status_t _tee_api_startup_notifier(trusty_app_t *ta)
@@ -123,7 +123,7 @@ static status_t tee_api_u_props_num(trusty_app_t *ta, uint32_t *ta_props_num)
 	uint32_t *u_props_num_uaddr = ta->props.custom_cfg_size;
 
 	res = uthread_virt_to_kvaddr(ta->ut, (vaddr_t)u_props_num_uaddr,
-			&u_props_num_kaddr);
+			&u_props_num_kaddr, false);
 	if (res)
 		return res;
 
@@ -146,7 +146,8 @@ static status_t tee_api_u_props_kaddr(trusty_app_t *ta,
 		return NO_ERROR;
 	}
 
-	res = uthread_virt_to_kvaddr(ut, (vaddr_t)u_props_uaddr, &props_kaddr);
+	res = uthread_virt_to_kvaddr(ut, (vaddr_t)u_props_uaddr, &props_kaddr,
+			false);
 	if (res)
 		return res;
 
@@ -223,12 +224,12 @@ static status_t properties_copy_from_user_gpd_ta(
 	void *value = NULL;
 
 	res = uthread_virt_to_kvaddr(ut, (vaddr_t)u_props_kaddr->name,
-			(void **)&name);
+			(void **)&name, false);
 	if (res)
 		return res;
 
 	res = uthread_virt_to_kvaddr(ut, (vaddr_t)u_props_kaddr->value,
-			&value);
+			&value, false);
 	if (res)
 		return res;
 
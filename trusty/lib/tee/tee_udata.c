@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2016-2018, MIPS Tech, LLC and/or its affiliated group companies
+ * (“MIPS”).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <arch/ops.h>
+#include <kernel/timer.h>
+#include <lk/init.h>
+#include <platform.h>
+#include <uthread.h>
+#include <tee_common_uapi.h>
+#include <lib/tee/tee_api.h>
+#include <lib/tee/tee_udata.h>
+
+#if ARCH_MIPS
+#include <arch/mips.h>
+#endif
+
+/* well below the time the count register takes to wrap at any clock rate */
+#define TIME_DATA_REFRESH_MSECS	1000
+
+static uint8_t time_page[PAGE_SIZE] __ALIGNED(PAGE_SIZE);
+static timer_t time_timer;
+
+static void time_data_publish(void)
+{
+#if ARCH_MIPS
+	struct utee_time_data *td = (struct utee_time_data *)time_page;
+	spin_lock_saved_state_t state;
+
+	arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+	td->seq++;
+	smp_wmb();
+	td->base_us = current_time_hires();
+	td->base_count = mips_read_c0_count();
+	td->count_mhz = mips_timer_rate_mhz();
+	smp_wmb();
+	td->seq++;
+	arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+#endif
+}
+
+static enum handler_return time_data_tick(struct timer *t, lk_time_t now,
+		void *arg)
+{
+	time_data_publish();
+	return INT_NO_RESCHEDULE;
+}
+
+status_t tee_udata_map(trusty_app_t *ta, tee_api_info_t *ta_info)
+{
+	struct utee_ta_data *data;
+	vaddr_t vaddr;
+	status_t res;
+
+	data = memalign(PAGE_SIZE, PAGE_SIZE);
+	if (!data)
+		return ERR_NO_MEMORY;
+	memset(data, 0, PAGE_SIZE);
+
+	data->props_num = ta->props.valid_ta_props_cnt;
+
+	vaddr = UTEE_TIME_DATA_VADDR;
+	res = uthread_map_contig(ta->ut, &vaddr, vaddr_to_paddr(time_page),
+			PAGE_SIZE, UTM_R | UTM_FIXED, UT_MAP_ALIGN_DEFAULT);
+	if (res)
+		goto err_free;
+
+	vaddr = UTEE_TA_DATA_VADDR;
+	res = uthread_map_contig(ta->ut, &vaddr, vaddr_to_paddr(data),
+			PAGE_SIZE, UTM_R | UTM_FIXED, UT_MAP_ALIGN_DEFAULT);
+	if (res) {
+		uthread_unmap(ta->ut, UTEE_TIME_DATA_VADDR, PAGE_SIZE);
+		goto err_free;
+	}
+
+	ta_info->ta_data = data;
+	tee_api_sync_cancel(ta_info);
+	return NO_ERROR;
+
+err_free:
+	free(data);
+	return res;
+}
+
+/* The TA is not going to run again when its data page is freed */
+void tee_udata_free(tee_api_info_t *ta_info)
+{
+	free(ta_info->ta_data);
+	ta_info->ta_data = NULL;
+}
+
+static void tee_udata_init(uint level)
+{
+	time_data_publish();
+	timer_initialize(&time_timer);
+	timer_set_periodic(&time_timer, TIME_DATA_REFRESH_MSECS,
+			time_data_tick, NULL);
+}
+
+LK_INIT_HOOK(tee_udata, tee_udata_init, LK_INIT_LEVEL_APPS - 2);
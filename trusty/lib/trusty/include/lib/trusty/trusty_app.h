@@ -44,6 +44,7 @@ typedef struct
 	uint32_t	map_io_mem_cnt;
 	bool		auto_start;
 	uint32_t	privileges;
+	uint32_t	instance_pool;
 	uint32_t	config_entry_cnt;
 	uint32_t	*config_blob;
 	void		*custom_cfg_ptr;
@@ -80,10 +81,20 @@ typedef struct trusty_app
 	struct list_node trusty_app_node; // node in trusty_app_list
 	struct list_node cloned_child_list; // list of cloned children
 	struct list_node cloned_node;     // node in cloned_child_list
+	struct list_node pool_list;       // started idle clones
+	struct list_node pool_node;       // node in pool_list
+	struct list_node reap_node;       // node in reap_list once exited
+	struct trusty_app *hash_next;     // next parent in app_hash bucket
+
+	/* load statistics */
+	lk_bigtime_t load_time;           // usecs to set up the instance
+	size_t load_size;                 // stack and heap bytes reserved
+	lk_bigtime_t exit_time;           // when the app thread exited
 
 	/* state info */
 	u_int trusty_app_index;           // app index for log messages
 	bool is_parent;			  // parent app or clone?
+	bool loaded;                      // is the address space set up?
 	bool started;                     // has app been started?
 	bool dead;                        // has app exited?
 } trusty_app_t;
@@ -91,6 +102,7 @@ typedef struct trusty_app
 status_t trusty_app_start_instance(uuid_t *uuid, trusty_app_t **trusty_app);
 status_t trusty_app_start_clone(uuid_t *uuid, trusty_app_t **trusty_app);
 status_t trusty_app_exit(trusty_app_t *trusty_app);
+status_t trusty_app_load(trusty_app_t *trusty_app);
 void trusty_app_dead(trusty_app_t *trusty_app);
 
 void trusty_app_init(void);
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2013-2017 Google Inc. All rights reserved
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* This file is auto-generated. !!! DO NOT EDIT !!! */
+
+DEF_SYSCALL_DISPATCH(0x1, write, 3, 0)
+DEF_SYSCALL_DISPATCH(0x2, brk, 1, 0)
+DEF_SYSCALL_DISPATCH(0x3, exit_group, 0, 0)
+DEF_SYSCALL_DISPATCH(0x4, read, 3, 0)
+DEF_SYSCALL_DISPATCH(0x5, ioctl, 3, 0)
+DEF_SYSCALL_DISPATCH(0x6, nanosleep, 4, 0)
+DEF_SYSCALL_DISPATCH(0x7, gettime, 3, 0)
+DEF_SYSCALL_DISPATCH(0x8, mmap, 4, 0)
+DEF_SYSCALL_DISPATCH(0x9, munmap, 2, 0)
+DEF_SYSCALL_DISPATCH(0xa, prepare_dma, 4, 0)
+DEF_SYSCALL_DISPATCH(0xb, finish_dma, 3, 0)
+DEF_SYSCALL_DISPATCH(0x10, port_create, 4, SYSCALL_F_PRIVILEGED)
+DEF_SYSCALL_DISPATCH(0x11, connect, 2, SYSCALL_F_PRIVILEGED)
+DEF_SYSCALL_DISPATCH(0x12, accept, 2, SYSCALL_F_PRIVILEGED)
+DEF_SYSCALL_DISPATCH(0x13, close, 1, 0)
+DEF_SYSCALL_DISPATCH(0x14, set_cookie, 2, 0)
+DEF_SYSCALL_DISPATCH(0x18, wait, 3, 0)
+DEF_SYSCALL_DISPATCH(0x19, wait_any, 2, 0)
+DEF_SYSCALL_DISPATCH(0x20, get_msg, 2, 0)
+DEF_SYSCALL_DISPATCH(0x21, read_msg, 4, 0)
+DEF_SYSCALL_DISPATCH(0x22, put_msg, 2, 0)
+DEF_SYSCALL_DISPATCH(0x23, send_msg, 2, 0)
+DEF_SYSCALL_DISPATCH(0x24, set_panic_handler, 2, 0)
+DEF_SYSCALL_DISPATCH(0x30, check_access_rights, 3, 0)
+DEF_SYSCALL_DISPATCH(0x31, connect_to_ta, 2, SYSCALL_F_PRIVILEGED)
+DEF_SYSCALL_DISPATCH(0x32, get_kprops, 5, 0)
+DEF_SYSCALL_DISPATCH(0x33, get_ta_client_props, 5, 0)
+DEF_SYSCALL_DISPATCH(0x34, get_props_num, 3, 0)
+DEF_SYSCALL_DISPATCH(0x35, get_prop_name, 5, 0)
+DEF_SYSCALL_DISPATCH(0x36, ta_dead, 0, 0)
+DEF_SYSCALL_DISPATCH(0x37, ta_next_msg, 1, 0)
+DEF_SYSCALL_DISPATCH(0x38, invoke_operation, 4, 0)
+DEF_SYSCALL_DISPATCH(0x39, close_session, 1, 0)
+DEF_SYSCALL_DISPATCH(0x3a, set_cancel_flag, 2, SYSCALL_F_PRIVILEGED)
+DEF_SYSCALL_DISPATCH(0x3b, get_cancel_flag, 0, 0)
+DEF_SYSCALL_DISPATCH(0x3c, mask_cancel_flag, 0, 0)
+DEF_SYSCALL_DISPATCH(0x3d, unmask_cancel_flag, 0, 0)
+DEF_SYSCALL_DISPATCH(0x3e, connect_to_sm, 1, 0)
+DEF_SYSCALL_DISPATCH(0x3f, get_ta_flags, 2, SYSCALL_F_PRIVILEGED)
+DEF_SYSCALL_DISPATCH(0x40, tee_wait, 1, 0)
+DEF_SYSCALL_DISPATCH(0x41, register_shm, 2, 0)
+DEF_SYSCALL_DISPATCH(0x42, unregister_shm, 2, 0)
+DEF_SYSCALL_DISPATCH(0x50, utee_cryp_state_alloc, 5, 0)
+DEF_SYSCALL_DISPATCH(0x51, utee_cryp_state_copy, 2, 0)
+DEF_SYSCALL_DISPATCH(0x52, utee_cryp_state_free, 1, 0)
+DEF_SYSCALL_DISPATCH(0x53, utee_hash_init, 3, 0)
+DEF_SYSCALL_DISPATCH(0x54, utee_hash_update, 3, 0)
+DEF_SYSCALL_DISPATCH(0x55, utee_hash_final, 5, 0)
+DEF_SYSCALL_DISPATCH(0x56, utee_cipher_init, 3, 0)
+DEF_SYSCALL_DISPATCH(0x57, utee_cipher_update, 5, 0)
+DEF_SYSCALL_DISPATCH(0x58, utee_cipher_final, 5, 0)
+DEF_SYSCALL_DISPATCH(0x59, utee_cryp_obj_get_info, 2, 0)
+DEF_SYSCALL_DISPATCH(0x5a, utee_cryp_obj_restrict_usage, 2, 0)
+DEF_SYSCALL_DISPATCH(0x5b, utee_cryp_obj_get_attr, 4, 0)
+DEF_SYSCALL_DISPATCH(0x5c, utee_cryp_obj_alloc, 3, 0)
+DEF_SYSCALL_DISPATCH(0x5d, utee_cryp_obj_close, 1, 0)
+DEF_SYSCALL_DISPATCH(0x5e, utee_cryp_obj_reset, 1, 0)
+DEF_SYSCALL_DISPATCH(0x5f, utee_cryp_obj_populate, 3, 0)
+DEF_SYSCALL_DISPATCH(0x60, utee_cryp_obj_copy, 2, 0)
+DEF_SYSCALL_DISPATCH(0x61, utee_cryp_obj_generate_key, 4, 0)
+DEF_SYSCALL_DISPATCH(0x62, utee_cryp_derive_key, 4, 0)
+DEF_SYSCALL_DISPATCH(0x63, utee_cryp_random_number_generate, 2, 0)
+DEF_SYSCALL_DISPATCH(0x64, utee_authenc_init, 6, 0)
+DEF_SYSCALL_DISPATCH(0x65, utee_authenc_update_aad, 3, 0)
+DEF_SYSCALL_DISPATCH(0x66, utee_authenc_update_payload, 5, 0)
+DEF_SYSCALL_DISPATCH(0x67, utee_authenc_enc_final, 7, 0)
+DEF_SYSCALL_DISPATCH(0x68, utee_authenc_dec_final, 7, 0)
+DEF_SYSCALL_DISPATCH(0x69, utee_asymm_operate, 7, 0)
+DEF_SYSCALL_DISPATCH(0x6a, utee_asymm_verify, 7, 0)
+DEF_SYSCALL_DISPATCH(0x6b, utee_storage_obj_open, 5, 0)
+DEF_SYSCALL_DISPATCH(0x6c, utee_storage_obj_create, 8, 0)
+DEF_SYSCALL_DISPATCH(0x6d, utee_storage_obj_del, 1, 0)
+DEF_SYSCALL_DISPATCH(0x6e, utee_storage_obj_rename, 3, 0)
+DEF_SYSCALL_DISPATCH(0x6f, utee_storage_alloc_enum, 1, 0)
+DEF_SYSCALL_DISPATCH(0x70, utee_storage_free_enum, 1, 0)
+DEF_SYSCALL_DISPATCH(0x71, utee_storage_reset_enum, 1, 0)
+DEF_SYSCALL_DISPATCH(0x72, utee_storage_start_enum, 2, 0)
+DEF_SYSCALL_DISPATCH(0x73, utee_storage_next_enum, 4, 0)
+DEF_SYSCALL_DISPATCH(0x74, utee_storage_obj_read, 4, 0)
+DEF_SYSCALL_DISPATCH(0x75, utee_storage_obj_write, 3, 0)
+DEF_SYSCALL_DISPATCH(0x76, utee_storage_obj_trunc, 2, 0)
+DEF_SYSCALL_DISPATCH(0x77, utee_storage_obj_seek, 3, 0)
+DEF_SYSCALL_DISPATCH(0x78, utee_hash_batch, 3, 0)
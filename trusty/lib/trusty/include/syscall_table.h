@@ -24,8 +24,16 @@
 /* DEF_SYSCALL(syscall_nr, syscall_name, return type, nr_args, [argument list])
  *
  * Please keep this table sorted by syscall number
+ *
+ * SYSCALL_PRIVILEGED(syscall_name) marks a syscall that only TAs with
+ * privileges may make. Regenerate syscall_dispatch.h after changing either:
+ * ../../syscall/stubgen/stubgen.py -k syscall_dispatch.h -a <ARCH> syscall_table.h
  */
 
+#ifndef SYSCALL_PRIVILEGED
+#define SYSCALL_PRIVILEGED(fn)
+#endif
+
 DEF_SYSCALL(0x1, write, long, 3, uint32_t fd, void *msg, uint32_t size)
 DEF_SYSCALL(0x2, brk, long, 1, uint32_t brk)
 DEF_SYSCALL(0x3, exit_group, long, 0)
@@ -76,6 +84,10 @@ DEF_SYSCALL(0x3e, connect_to_sm, TEE_Result, 1, uint32_t *handle_id)
 DEF_SYSCALL(0x3f, get_ta_flags, TEE_Result, 2, const uuid_t *dest_uuid, uint32_t *flags)
 DEF_SYSCALL(0x40, tee_wait, TEE_Result, 1, uint32_t timeout)
 
+/* REE shared memory registration, Session Manager only */
+DEF_SYSCALL(0x41, register_shm, TEE_Result, 2, unsigned long buf, size_t size)
+DEF_SYSCALL(0x42, unregister_shm, TEE_Result, 2, unsigned long buf, size_t size)
+
 /* TEE Crypto API syscalls */
 DEF_SYSCALL(0x50, utee_cryp_state_alloc, TEE_Result, 5, unsigned long algo, unsigned long op_mode, unsigned long key1, unsigned long key2, uint32_t *state)
 DEF_SYSCALL(0x51, utee_cryp_state_copy, TEE_Result, 2, unsigned long dst, unsigned long src)
@@ -164,3 +176,15 @@ DEF_SYSCALL(0x76, utee_storage_obj_trunc, TEE_Result, 2, unsigned long obj, size
 /* obj is of type TEE_ObjectHandle */
 /* whence is of type TEE_Whence */
 DEF_SYSCALL(0x77, utee_storage_obj_seek, TEE_Result, 3, unsigned long obj, int32_t offset, unsigned long whence)
+
+/* Digest or MAC of num_msgs independent messages, state is left re-initialized;
+ * a short digest buffer fails the call before anything is hashed */
+DEF_SYSCALL(0x78, utee_hash_batch, TEE_Result, 3, unsigned long state, struct utee_hash_msg *msgs, unsigned long num_msgs)
+
+/* checked against the TA's privileges by syscall_privilege_check() */
+SYSCALL_PRIVILEGED(port_create)
+SYSCALL_PRIVILEGED(connect)
+SYSCALL_PRIVILEGED(accept)
+SYSCALL_PRIVILEGED(connect_to_ta)
+SYSCALL_PRIVILEGED(set_cancel_flag)
+SYSCALL_PRIVILEGED(get_ta_flags)
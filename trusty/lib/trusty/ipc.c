@@ -35,6 +35,7 @@
 #include <lk/init.h>
 #include <kernel/mutex.h>
 #include <kernel/event.h>
+#include <lib/slab.h>
 
 #include <lib/syscall.h>
 
@@ -55,6 +56,9 @@ static struct list_node ipc_port_list = LIST_INITIAL_VALUE(ipc_port_list);
 
 mutex_t ipc_lock = MUTEX_INITIAL_VALUE(ipc_lock);
 
+static slab_cache_t chan_cache =
+	SLAB_CACHE_INITIAL_VALUE(chan_cache, "ipc_chan", sizeof(ipc_chan_t), NULL);
+
 static uint32_t port_poll(handle_t *handle);
 static void port_shutdown(handle_t *handle);
 static void port_handle_destroy(handle_t *handle);
@@ -432,7 +436,7 @@ static inline void __chan_destroy_refobj(obj_t *ref)
 		ipc_msg_queue_destroy(chan->msg_queue);
 		chan->msg_queue = NULL;
 	}
-	free(chan);
+	slab_free(&chan_cache, chan);
 }
 
 static inline void chan_add_ref(ipc_chan_t *chan, obj_ref_t *ref)
@@ -463,9 +467,10 @@ static ipc_chan_t *chan_alloc(uint32_t flags, const uuid_t *uuid,
 {
 	ipc_chan_t *chan;
 
-	chan = calloc(1, sizeof(ipc_chan_t));
+	chan = slab_alloc(&chan_cache);
 	if (!chan)
 		return NULL;
+	memset(chan, 0, sizeof(ipc_chan_t));
 
 	/* init ref count */
 	obj_init(&chan->refobj, ref);
@@ -47,6 +47,7 @@
 #include <sys/types.h>
 #include <trace.h>
 #include <uthread.h>
+#include <lib/slab.h>
 
 #include <lib/syscall.h>
 
@@ -93,6 +94,20 @@ typedef struct ipc_msg_queue {
 	msg_item_t		items[0];
 } ipc_msg_queue_t;
 
+/* queues of up to MQ_CACHE_ITEMS messages, the common case, share a cache */
+#define MQ_CACHE_ITEMS	4
+
+static slab_cache_t mq_cache = SLAB_CACHE_INITIAL_VALUE(mq_cache, "ipc_msg_queue",
+		sizeof(ipc_msg_queue_t) + MQ_CACHE_ITEMS * sizeof(msg_item_t), NULL);
+
+static void mq_free(ipc_msg_queue_t *mq, uint num_items)
+{
+	if (num_items <= MQ_CACHE_ITEMS)
+		slab_free(&mq_cache, mq);
+	else
+		free(mq);
+}
+
 enum {
 	IPC_MSG_BUFFER_USER	= 0,
 	IPC_MSG_BUFFER_KERNEL	= 1,
@@ -122,10 +137,16 @@ typedef struct msg_desc {
 int ipc_msg_queue_create(uint num_items, size_t item_sz, ipc_msg_queue_t **mq)
 {
 	ipc_msg_queue_t *tmp_mq;
+	size_t mq_sz = sizeof(ipc_msg_queue_t) + num_items * sizeof(msg_item_t);
 	int ret;
 
-	tmp_mq = calloc(1, (sizeof(ipc_msg_queue_t) +
-			    num_items * sizeof(msg_item_t)));
+	if (num_items <= MQ_CACHE_ITEMS) {
+		tmp_mq = slab_alloc(&mq_cache);
+		if (tmp_mq)
+			memset(tmp_mq, 0, mq_sz);
+	} else {
+		tmp_mq = calloc(1, mq_sz);
+	}
 	if (!tmp_mq) {
 		dprintf(CRITICAL, "cannot allocate memory for message queue\n");
 		return ERR_NO_MEMORY;
@@ -153,14 +174,14 @@ int ipc_msg_queue_create(uint num_items, size_t item_sz, ipc_msg_queue_t **mq)
 	return 0;
 
 err_alloc_buf:
-	free(tmp_mq);
+	mq_free(tmp_mq, num_items);
 	return ret;
 }
 
 void ipc_msg_queue_destroy(ipc_msg_queue_t *mq)
 {
 	free(mq->buf);
-	free(mq);
+	mq_free(mq, mq->num_items);
 }
 
 bool ipc_msg_queue_is_empty(ipc_msg_queue_t *mq)
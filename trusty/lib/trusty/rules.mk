@@ -58,6 +58,7 @@ MODULE_DEPS += \
 
 GLOBAL_DEFINES += \
 	WITH_SYSCALL_TABLE=1 \
+	WITH_SYSCALL_DISPATCH=1 \
 
 ifeq (true,$(call TOBOOL,$(WITH_UPSTREAM_LK)))
 
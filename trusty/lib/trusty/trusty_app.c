@@ -30,6 +30,7 @@
 #include <debug.h>
 #include "elf.h"
 #include <err.h>
+#include <kernel/event.h>
 #include <kernel/mutex.h>
 #include <kernel/thread.h>
 #include <malloc.h>
@@ -40,6 +41,7 @@
 #include <sys/types.h>
 #include <uthread.h>
 #include <lk/init.h>
+#include <tee_common_uapi.h>
 
 #include <lib/trusty/trusty_app.h>
 
@@ -58,6 +60,7 @@ enum {
 	TRUSTY_APP_CONFIG_KEY_AUTO_START	= 4,
 	TRUSTY_APP_CONFIG_KEY_EXTERN		= 5,
 	TRUSTY_APP_CONFIG_KEY_PRIVILEGES	= 6,
+	TRUSTY_APP_CONFIG_KEY_INSTANCE_POOL	= 7,
 };
 
 typedef struct trusty_app_manifest {
@@ -80,20 +83,18 @@ typedef struct trusty_app_manifest {
 
 #define PAGE_MASK		(PAGE_SIZE - 1)
 
-/* Session Manager UUID. It has to be kept in sync with changes to SM UUID in
- * appropriate manifest file.
- * The definition here is used that so any tampering with SM_UUID that could
- * affect checks in this file can be prevented.
- */
-#ifdef SM_UUID
-#undef SM_UUID
-#endif
-#define SM_UUID { 0x7ea5ad73, 0xd8eb, 0x4859, \
-                  { 0xa2, 0x06, 0x17, 0x46, 0xd3, 0xc4, 0xcc, 0xdf } }
-
 static u_int trusty_app_count;
 static struct list_node trusty_app_list = LIST_INITIAL_VALUE(trusty_app_list);
 
+/*
+ * Parents hashed by uuid. Entries are only added by the bootloader and
+ * parents are never freed once added, so lookups walk a bucket without
+ * taking THREAD_LOCK.
+ */
+#define APP_HASH_SIZE		32
+
+static trusty_app_t *app_hash[APP_HASH_SIZE];
+
 static char *trusty_app_image_start;
 static char *trusty_app_image_end;
 static u_int trusty_app_image_size;
@@ -102,12 +103,45 @@ extern intptr_t __trusty_app_start;
 extern intptr_t __trusty_app_end;
 
 static bool apps_registration_closed;
+/* notifier and als registration, and trusty_app_load */
 static mutex_t apps_lock = MUTEX_INITIAL_VALUE(apps_lock);
 static struct list_node app_notifier_list = LIST_INITIAL_VALUE(app_notifier_list);
 uint als_slot_cnt;
 static struct list_node started_app_list = LIST_INITIAL_VALUE(started_app_list);
 static bool session_manager_started = 0;
 
+/* wakes the thread that tops up the instance pools */
+static event_t pool_event = EVENT_INITIAL_VALUE(pool_event, true,
+		EVENT_FLAG_AUTOUNSIGNAL);
+
+/* apps whose thread has exited, for trusty_exit_handler to reap */
+static struct list_node reap_list = LIST_INITIAL_VALUE(reap_list);
+static event_t reap_event = EVENT_INITIAL_VALUE(reap_event, false,
+		EVENT_FLAG_AUTOUNSIGNAL);
+
+#define REAP_SCAN_MSECS	1000
+
+/* exit to reap latencies in usecs, for the ta_reap command */
+#define REAP_LAT_SAMPLES	64
+
+static uint32_t reap_lat[REAP_LAT_SAMPLES];
+static u_int reap_lat_cnt;
+
+/*
+ * trusty_app_start_clone latencies in usecs, for the ta_pool command.
+ * Protected by THREAD_LOCK, like the instance pools.
+ */
+#define CLONE_LAT_SAMPLES	64
+
+static uint32_t clone_lat[CLONE_LAT_SAMPLES];
+static u_int clone_lat_cnt;
+static u_int clone_pool_hits;
+
+/* parents found in the image, how many are loaded and the boot time spent */
+static u_int apps_registered;
+static u_int apps_loaded;
+static lk_bigtime_t apps_boot_time;
+
 #define PRINT_TRUSTY_APP_UUID(tid,u)					\
 	dprintf(SPEW,							\
 		"trusty_app %d uuid: " UUID_STR_FORMAT "\n",		\
@@ -165,6 +199,33 @@ static inline u_int trusty_app_index(trusty_app_t *trusty_app)
 	return trusty_app->trusty_app_index;
 }
 
+static inline u_int app_hash_bucket(const uuid_t *uuid)
+{
+	const uint8_t *p = uuid->clock_seq_and_node;
+	uint32_t h;
+
+	h = uuid->time_low ^ (uuid->time_mid << 16) ^ uuid->time_hi_and_version;
+	h ^= (p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]);
+	h ^= (p[4] << 24 | p[5] << 16 | p[6] << 8 | p[7]);
+	h ^= h >> 16;
+	h ^= h >> 8;
+
+	return h % APP_HASH_SIZE;
+}
+
+/* append so that the first of several parents with one uuid is found */
+static void app_hash_insert(trusty_app_t *trusty_app)
+{
+	trusty_app_t **pp = &app_hash[app_hash_bucket(&trusty_app->props.uuid)];
+
+	while (*pp)
+		pp = &(*pp)->hash_next;
+
+	trusty_app->hash_next = NULL;
+	smp_wmb();
+	*pp = trusty_app;
+}
+
 static trusty_app_t *app_alloc(bool is_parent)
 {
 	trusty_app_t *trusty_app = calloc(1, sizeof(*trusty_app));
@@ -173,6 +234,7 @@ static trusty_app_t *app_alloc(bool is_parent)
 
 	trusty_app->is_parent = is_parent;
 	list_initialize(&trusty_app->cloned_child_list);
+	list_initialize(&trusty_app->pool_list);
 
 	// keep an index for logging purposes, it is not a list index
 	trusty_app->trusty_app_index = trusty_app_count++;
@@ -202,6 +264,8 @@ static void trusty_app_free(trusty_app_t *trusty_app)
 	if (!trusty_app->is_parent) {
 		if (list_in_list(&trusty_app->cloned_node))
 			list_delete(&trusty_app->cloned_node);
+		if (list_in_list(&trusty_app->pool_node))
+			list_delete(&trusty_app->pool_node);
 	}
 	free(trusty_app);
 	THREAD_UNLOCK(state);
@@ -321,6 +385,10 @@ static status_t load_app_config_options(intptr_t trusty_app_image_addr,
 			if (not_session_manager && (trusty_app->props.privileges > 1))
 			    trusty_app->props.privileges = 0;
 			break;
+		case TRUSTY_APP_CONFIG_KEY_INSTANCE_POOL:
+			/* INSTANCE_POOL takes 1 data value */
+			trusty_app->props.instance_pool = val[0];
+			break;
 		default:
 			dprintf(CRITICAL, "Unknown manifest config key: %d\n",
 					key);
@@ -340,25 +408,10 @@ static status_t load_app_config_options(intptr_t trusty_app_image_addr,
 	return NO_ERROR;
 }
 
-static status_t free_map_list_insert(trusty_app_t *trusty_app, void* ptr)
-{
-	struct free_map_node *node = malloc(sizeof(struct free_map_node));
-	if (!node)
-		return ERR_NO_MEMORY;
-
-	node->ptr = ptr;
-	THREAD_LOCK(state);
-	list_add_tail(&trusty_app->free_map_list, &node->node);
-	THREAD_UNLOCK(state);
-
-	return NO_ERROR;
-}
-
 static status_t init_brk(trusty_app_t *trusty_app)
 {
 	status_t status;
 	vaddr_t vaddr;
-	void *heap;
 
 	trusty_app->cur_brk = trusty_app->start_brk;
 
@@ -367,28 +420,18 @@ static status_t init_brk(trusty_app_t *trusty_app)
 	    trusty_app->props.min_heap_size)
 		return NO_ERROR;
 
-	heap = memalign(PAGE_SIZE, trusty_app->props.min_heap_size);
-	if (heap == 0)
-		return ERR_NO_MEMORY;
-	memset(heap, 0, trusty_app->props.min_heap_size);
-
+	/* heap pages are only allocated once the app writes them */
 	vaddr = trusty_app->end_brk;
-	status = uthread_map_contig(trusty_app->ut, &vaddr,
-			     vaddr_to_paddr(heap),
+	status = uthread_map_zero(trusty_app->ut, &vaddr,
 			     trusty_app->props.min_heap_size,
 			     UTM_W | UTM_R | UTM_FIXED,
 			     UT_MAP_ALIGN_DEFAULT);
 	if (status != NO_ERROR || vaddr != trusty_app->end_brk) {
 		dprintf(CRITICAL, "cannot map brk\n");
-		free(heap);
-		return ERR_NO_MEMORY;
-	}
-
-	if (free_map_list_insert(trusty_app, heap)) {
-		free(heap);
 		return ERR_NO_MEMORY;
 	}
 
+	trusty_app->load_size += trusty_app->props.min_heap_size;
 	trusty_app->end_brk += trusty_app->props.min_heap_size;
 	return NO_ERROR;
 }
@@ -451,26 +494,10 @@ static status_t alloc_address_map(trusty_app_t *trusty_app)
 		vaddr_t vaddr = prg_hdr->p_vaddr;
 		u_int flags = PF_TO_UTM_FLAGS(prg_hdr->p_flags) | UTM_FIXED;
 
-		// not running in place, duplicate writable pages, share read-only pages
-		if (flags & UTM_W) {
-			size_t app_size = prg_hdr->p_memsz;
-			size_t app_size_pg = size;
-
-			char* clone_app_img = memalign(PAGE_SIZE, app_size_pg);
-			if (!clone_app_img)
-				return ERR_NO_MEMORY;
-
-			memcpy(clone_app_img, seg_vaddr, app_size);
-			// zero fill the memory after the image
-			memset(clone_app_img + app_size, 0, app_size_pg - app_size);
-
-			paddr = vaddr_to_paddr(clone_app_img);
-
-			if (free_map_list_insert(trusty_app, clone_app_img)) {
-				free(clone_app_img);
-				return ERR_NO_MEMORY;
-			}
-		}
+		// not running in place, writable pages are shared with the image
+		// until the instance writes them, read-only pages stay shared
+		if (flags & UTM_W)
+			flags |= UTM_COW;
 
 		ret = uthread_map_contig(trusty_app->ut, &vaddr, paddr, size,
 				flags, UT_MAP_ALIGN_DEFAULT);
@@ -681,6 +708,8 @@ static void trusty_app_bootloader(void)
 		/* If there was an error loading trusty app, unload it. */
 		if (ret != NO_ERROR)
 			trusty_app_free(trusty_app);
+		else
+			app_hash_insert(trusty_app);
 
 		/* align next trusty_app start */
 		trusty_app_image_addr = align_next_app(ehdr, bss_pad_shdr, trusty_app_max_extent);
@@ -727,6 +756,7 @@ static status_t trusty_app_init_one(const char *name, trusty_app_t *trusty_app)
 {
 	uthread_t *uthread;
 	int ret = NO_ERROR;
+	lk_bigtime_t start = current_time_hires();
 
 	/* entry is 0 at this point since we haven't parsed the elf hdrs
 	 * yet */
@@ -740,6 +770,7 @@ static status_t trusty_app_init_one(const char *name, trusty_app_t *trusty_app)
 		goto done;
 	}
 	trusty_app->ut = uthread;
+	trusty_app->load_size = trusty_app->props.min_stack_size;
 
 	ret = alloc_address_map(trusty_app);
 	if (ret != NO_ERROR) {
@@ -766,15 +797,89 @@ static status_t trusty_app_init_one(const char *name, trusty_app_t *trusty_app)
 			}
 		}
 	}
+
+	trusty_app->load_time = current_time_hires() - start;
+	dprintf(SPEW, "trusty_app %d: loaded in %llu us, %zu reserved bytes\n",
+		trusty_app_index(trusty_app), trusty_app->load_time,
+		trusty_app->load_size);
 done:
 	return ret;
 }
 
+static bool trusty_app_is_loaded(trusty_app_t *trusty_app)
+{
+	bool loaded;
+
+	THREAD_LOCK(state);
+	loaded = trusty_app->loaded;
+	THREAD_UNLOCK(state);
+
+	return loaded;
+}
+
+/*
+ * Set up the address space of a parent app. Only the apps that start at boot
+ * are loaded by trusty_app_init, the others are loaded when first connected
+ * to or asked about. An app that fails to load is marked dead.
+ *
+ * Loads are serialized by apps_lock and THREAD_LOCK is only taken to
+ * publish the loaded flag, so the lock is not held while the address space
+ * is set up. A parent without an address space has no thread that could
+ * exit, so under apps_lock only a failed load changes loaded or dead.
+ */
+status_t trusty_app_load(trusty_app_t *trusty_app)
+{
+	char name[THREAD_NAME_LEN];
+	status_t ret = NO_ERROR;
+
+	if (!trusty_app->is_parent)
+		return ERR_INVALID_ARGS;
+
+	if (trusty_app_is_loaded(trusty_app))
+		return NO_ERROR;
+
+	mutex_acquire(&apps_lock);
+	if (trusty_app->loaded)
+		goto done;
+
+	if (trusty_app->dead) {
+		ret = ERR_NOT_VALID;
+		goto done;
+	}
+
+	snprintf(name, sizeof(name), "trusty_app_%u_" UUID_STR_FORMAT,
+		 trusty_app_index(trusty_app),
+		 trusty_app->props.uuid.time_low,
+		 trusty_app->props.uuid.time_mid,
+		 trusty_app->props.uuid.time_hi_and_version,
+		 trusty_app->props.uuid.clock_seq_and_node[0],
+		 trusty_app->props.uuid.clock_seq_and_node[1],
+		 trusty_app->props.uuid.clock_seq_and_node[2],
+		 trusty_app->props.uuid.clock_seq_and_node[3],
+		 trusty_app->props.uuid.clock_seq_and_node[4],
+		 trusty_app->props.uuid.clock_seq_and_node[5],
+		 trusty_app->props.uuid.clock_seq_and_node[6],
+		 trusty_app->props.uuid.clock_seq_and_node[7]);
+
+	ret = trusty_app_init_one(name, trusty_app);
+	if (ret) {
+		trusty_app_exit(trusty_app);
+		goto done;
+	}
+
+	THREAD_LOCK(state);
+	trusty_app->loaded = true;
+	apps_loaded++;
+	THREAD_UNLOCK(state);
+done:
+	mutex_release(&apps_lock);
+	return ret;
+}
+
 void trusty_app_init(void)
 {
 	trusty_app_t *trusty_app;
-	u_int i = 0;
-	int ret = NO_ERROR;
+	lk_bigtime_t start = current_time_hires();
 
 	trusty_app_image_start = (char *)&__trusty_app_start;
 	trusty_app_image_end = (char *)&__trusty_app_end;
@@ -786,37 +891,28 @@ void trusty_app_init(void)
 
 	trusty_app_bootloader();
 
-	THREAD_LOCK(state);
+	/*
+	 * No instances exist yet and parents are never removed, so the list
+	 * can be walked without THREAD_LOCK while the apps load.
+	 */
 	list_for_every_entry(&trusty_app_list, trusty_app, trusty_app_t,
 			trusty_app_node)
 	{
-		char name[THREAD_NAME_LEN];
-
-		snprintf(name, sizeof(name), "trusty_app_%u_" UUID_STR_FORMAT,
-			 i,
-			 trusty_app->props.uuid.time_low,
-			 trusty_app->props.uuid.time_mid,
-			 trusty_app->props.uuid.time_hi_and_version,
-			 trusty_app->props.uuid.clock_seq_and_node[0],
-			 trusty_app->props.uuid.clock_seq_and_node[1],
-			 trusty_app->props.uuid.clock_seq_and_node[2],
-			 trusty_app->props.uuid.clock_seq_and_node[3],
-			 trusty_app->props.uuid.clock_seq_and_node[4],
-			 trusty_app->props.uuid.clock_seq_and_node[5],
-			 trusty_app->props.uuid.clock_seq_and_node[6],
-			 trusty_app->props.uuid.clock_seq_and_node[7]);
-
-		i++;
-		ret = trusty_app_init_one(name, trusty_app);
-		if (ret)
-			trusty_app_exit(trusty_app);
+		apps_registered++;
+
+		/* the rest are loaded by their first user */
+		if (trusty_app->props.auto_start)
+			trusty_app_load(trusty_app);
 	}
-	THREAD_UNLOCK(state);
+
+	apps_boot_time = current_time_hires() - start;
+	dprintf(INFO, "trusty_app: %u apps registered, %u loaded in %llu us\n",
+		apps_registered, apps_loaded, apps_boot_time);
 }
 
 /*
- * Iterate by uuid over all trusty_app parent instances; cloned apps are
- * skipped; dead apps are NOT skipped.
+ * Look up the trusty_app parent instance by uuid; cloned apps are not
+ * indexed; dead apps are NOT skipped. Safe to call without THREAD_LOCK.
  *
  * NOTE: the matched trusty_app may be reaped by trusty_exit_handler at any
  * time.
@@ -827,18 +923,10 @@ trusty_app_t *trusty_app_find_by_uuid(uuid_t *uuid)
 {
 	trusty_app_t *ta;
 
-	/* find app for this uuid */
-	THREAD_LOCK(state);
-	list_for_every_entry(&trusty_app_list, ta, trusty_app_t,
-			trusty_app_node)
-	{
-		/* search parent apps; cloned app uuid are duplicates */
-		if (!ta->is_parent)
-			continue;
+	for (ta = app_hash[app_hash_bucket(uuid)]; ta; ta = ta->hash_next) {
 		if (!memcmp(&ta->props.uuid, uuid, sizeof(uuid_t)))
 			return ta;
 	}
-	THREAD_UNLOCK(state);
 
 	return NULL;
 }
@@ -853,6 +941,10 @@ trusty_app_t *trusty_app_find_by_uuid(uuid_t *uuid)
  * NOTE: the callback fn is called under THREAD_LOCK so that it may safely
  * access the trusty_app exclusively from trusty_exit_handler.
  *
+ * Only the parent is found through app_hash. Its instances are not indexed:
+ * they are walked under THREAD_LOCK, so interrupts stay off for as long as
+ * it takes to visit every live instance of the uuid.
+ *
  * @ret: set to ERR_NOT_FOUND if the uuid doesn't match; otherwise NO_ERROR.
  * @fn_ret: only valid if @ret is NO_ERROR, @fn_ret is set by callback fn.
  */
@@ -864,14 +956,14 @@ status_t trusty_app_find_instance_by_uuid(uuid_t *uuid,
 	trusty_app_t *parent_app;
 	trusty_app_t *child_app;
 
-	THREAD_LOCK(state);
-
 	/* first match parent app */
 	parent_app = trusty_app_find_by_uuid(uuid);
 	if (!parent_app)
-		goto exit_unlock;
+		return ret;
+
+	THREAD_LOCK(state);
 
-	if (!trusty_app_is_dead(parent_app)) {
+	if (parent_app->loaded && !trusty_app_is_dead(parent_app)) {
 		ret = NO_ERROR;
 		*fn_ret = fn(parent_app, data);
 		if (*fn_ret)
@@ -998,6 +1090,11 @@ static status_t trusty_app_clone(trusty_app_t *parent_app, trusty_app_t **ta_clo
 	if (!parent_app->is_parent)
 		return ERR_INVALID_ARGS;
 
+	/* clones copy the properties the parent read from its image */
+	ret = trusty_app_load(parent_app);
+	if (ret)
+		return ret;
+
 	ret = clone_parent(parent_app, &clone_app);
 	if (ret)
 		return ret;
@@ -1052,11 +1149,13 @@ static status_t trusty_app_restart(trusty_app_t *parent_app, trusty_app_t **ta_c
 	THREAD_LOCK(state);
 
 	if (trusty_app_is_dead(ta)) {
-		// check if at least one ta instance is started but not dead
+		// check if at least one ta instance is started but not dead;
+		// idle pool instances are for trusty_app_pool_take only
 		list_for_every_entry( &ta->cloned_child_list, child_app,
 				trusty_app_t, cloned_node) {
 			if (trusty_app_is_started(child_app) &&
-					!trusty_app_is_dead(child_app)) {
+					!trusty_app_is_dead(child_app) &&
+					!list_in_list(&child_app->pool_node)) {
 				*ta_clone = child_app;
 				ret = ERR_ALREADY_STARTED;
 				goto release;
@@ -1092,6 +1191,10 @@ status_t trusty_app_start_instance(uuid_t *uuid, trusty_app_t **trusty_app)
 		return ERR_NOT_FOUND;
 	}
 
+	/* callers treat an app that cannot be loaded like a missing one */
+	if (trusty_app_load(ta))
+		return ERR_NOT_FOUND;
+
 	ret = trusty_app_restart(ta, &ta_clone);
 	if (ta_clone)
 		*trusty_app = ta_clone;
@@ -1101,12 +1204,31 @@ status_t trusty_app_start_instance(uuid_t *uuid, trusty_app_t **trusty_app)
 	return ret;
 }
 
+/* Hand out an idle instance started ahead of time, NULL if there is none */
+static trusty_app_t *trusty_app_pool_take(trusty_app_t *parent_app)
+{
+	trusty_app_t *ta_clone;
+
+	THREAD_LOCK(state);
+	ta_clone = list_remove_head_type(&parent_app->pool_list, trusty_app_t,
+			pool_node);
+	if (ta_clone)
+		clone_pool_hits++;
+	THREAD_UNLOCK(state);
+
+	if (ta_clone)
+		event_signal(&pool_event, false);
+
+	return ta_clone;
+}
+
 // may be called externally from other thread contexts
 status_t trusty_app_start_clone(uuid_t *uuid, trusty_app_t **trusty_app)
 {
 	int ret = NO_ERROR;
 	trusty_app_t *ta;
 	trusty_app_t *ta_clone = NULL;
+	lk_bigtime_t start;
 
 	*trusty_app = NULL;
 
@@ -1115,6 +1237,14 @@ status_t trusty_app_start_clone(uuid_t *uuid, trusty_app_t **trusty_app)
 		return ERR_NOT_FOUND;
 	}
 
+	start = current_time_hires();
+
+	ta_clone = trusty_app_pool_take(ta);
+	if (ta_clone) {
+		*trusty_app = ta_clone;
+		goto done;
+	}
+
 	ret = trusty_app_clone(ta, &ta_clone);
 	if (ret == NO_ERROR) {
 		ret = trusty_app_start(ta_clone);
@@ -1122,9 +1252,106 @@ status_t trusty_app_start_clone(uuid_t *uuid, trusty_app_t **trusty_app)
 			*trusty_app = ta_clone;
 	}
 
+done:
+	if (ret == NO_ERROR) {
+		uint32_t us = current_time_hires() - start;
+
+		THREAD_LOCK(state);
+		clone_lat[clone_lat_cnt++ % CLONE_LAT_SAMPLES] = us;
+		THREAD_UNLOCK(state);
+	}
+
 	return ret;
 }
 
+/* First parent with fewer idle instances than its manifest asks for */
+static trusty_app_t *trusty_app_pool_short(void)
+{
+	trusty_app_t *ta, *parent = NULL;
+
+	THREAD_LOCK(state);
+	list_for_every_entry(&trusty_app_list, ta, trusty_app_t,
+			trusty_app_node) {
+		if (ta->is_parent && list_length(&ta->pool_list) <
+		    ta->props.instance_pool) {
+			parent = ta;
+			break;
+		}
+	}
+	THREAD_UNLOCK(state);
+
+	return parent;
+}
+
+/*
+ * Top up the pool of every parent that asked for one in its manifest. Only
+ * the pool thread adds to pools, so the lock is dropped while cloning.
+ */
+static void trusty_app_pool_fill(void)
+{
+	trusty_app_t *parent;
+	trusty_app_t *ta_clone;
+	status_t ret;
+
+	for (;;) {
+		parent = trusty_app_pool_short();
+		if (!parent)
+			return;
+
+		/*
+		 * Whether the TA is single instance, and so must not have a
+		 * pool, is only known once it is loaded; look again then.
+		 */
+		if (!trusty_app_is_loaded(parent)) {
+			ret = trusty_app_load(parent);
+			if (ret) {
+				dprintf(CRITICAL,
+					"Trusty app: failed (%d) to load app for instance pool\n",
+					ret);
+				return;
+			}
+			continue;
+		}
+
+		ret = trusty_app_clone(parent, &ta_clone);
+		if (ret == NO_ERROR) {
+			ret = trusty_app_start(ta_clone);
+			if (ret)
+				trusty_app_exit(ta_clone);
+		}
+		if (ret) {
+			/* try again when the next instance is taken */
+			dprintf(CRITICAL,
+				"Trusty app: failed (%d) to fill instance pool\n",
+				ret);
+			return;
+		}
+
+		THREAD_LOCK(state);
+		list_add_tail(&parent->pool_list, &ta_clone->pool_node);
+		THREAD_UNLOCK(state);
+	}
+}
+
+static int trusty_app_pool_thread(void *arg)
+{
+	for (;;) {
+		event_wait(&pool_event);
+		trusty_app_pool_fill();
+	}
+
+	return 0;
+}
+
+static void start_pool_thread(uint level)
+{
+	thread_detach_and_resume(thread_create("trusty_app_pool",
+				&trusty_app_pool_thread, NULL, LOW_PRIORITY,
+				DEFAULT_STACK_SIZE));
+}
+
+LK_INIT_HOOK(libtrusty_apps_pool, start_pool_thread, LK_INIT_LEVEL_APPS + 1);
+
 static void auto_start_apps(uint level)
 {
 	trusty_app_t *trusty_app;
@@ -1188,6 +1415,8 @@ status_t trusty_app_exit(trusty_app_t *trusty_app)
 
 	if (list_in_list(&trusty_app->started_node))
 		list_delete(&trusty_app->started_node);
+	if (list_in_list(&trusty_app->reap_node))
+		list_delete(&trusty_app->reap_node);
 
 	/* call all registered shutdown notifiers */
 	trusty_app_notifier_t *n;
@@ -1231,19 +1460,68 @@ __NO_INLINE static void dump_started_app_list(void)
 	THREAD_UNLOCK(state);
 }
 
+/*
+ * Called by an app thread on its way out of uthread_exit; it has not reached
+ * thread_exit yet, so trusty_exit_handler may find it still running.
+ */
+static void trusty_app_thread_exit(uthread_t *ut)
+{
+	trusty_app_t *trusty_app = ut->private_data;
+
+	THREAD_LOCK(state);
+	if (trusty_app && trusty_app->ut == ut &&
+	    list_in_list(&trusty_app->started_node) &&
+	    !list_in_list(&trusty_app->reap_node)) {
+		trusty_app->exit_time = current_time_hires();
+		list_add_tail(&reap_list, &trusty_app->reap_node);
+	}
+	THREAD_UNLOCK(state);
+
+	event_signal(&reap_event, false);
+}
+
+/*
+ * App threads that die from a fault taken in kernel mode never get to
+ * uthread_exit, so they are looked for every REAP_SCAN_MSECS, whether or
+ * not other apps keep the reaper busy.
+ */
+static void trusty_app_reap_scan(void)
+{
+	trusty_app_t *trusty_app;
+
+	THREAD_LOCK(state);
+	list_for_every_entry(&started_app_list, trusty_app, trusty_app_t,
+			started_node) {
+		if (trusty_app->kt && trusty_app->kt->state == THREAD_DEATH &&
+		    !list_in_list(&trusty_app->reap_node)) {
+			trusty_app->exit_time = current_time_hires();
+			list_add_tail(&reap_list, &trusty_app->reap_node);
+		}
+	}
+	THREAD_UNLOCK(state);
+}
+
 static int trusty_exit_handler(void *arg)
 {
 	int ret;
+	lk_time_t last_scan = current_time();
 
 	dprintf(SPEW, "starting trusty_exit_handler\n");
 
 	for (;;) {
 		struct trusty_app *trusty_app;
 		struct trusty_app *temp;
+		bool pending = false;
+
+		event_wait_timeout(&reap_event, REAP_SCAN_MSECS);
+		if (current_time() - last_scan >= REAP_SCAN_MSECS) {
+			trusty_app_reap_scan();
+			last_scan = current_time();
+		}
 
 		THREAD_LOCK(state);
-		list_for_every_entry_safe(&started_app_list, trusty_app, temp,
-				struct trusty_app, started_node) {
+		list_for_every_entry_safe(&reap_list, trusty_app, temp,
+				struct trusty_app, reap_node) {
 			int thread_ret;
 			__UNUSED char name[THREAD_NAME_LEN] = {0};
 			if (LK_DEBUGLEVEL == SPEW)
@@ -1252,9 +1530,16 @@ static int trusty_exit_handler(void *arg)
 			ret = thread_join(trusty_app->kt, &thread_ret, 0);
 			switch (ret) {
 			case ERR_TIMED_OUT:
+				// queued itself but not yet in thread_exit
+				pending = true;
 				break;
 			case ERR_THREAD_DETACHED: // fall through
 			case NO_ERROR:
+				list_delete(&trusty_app->reap_node);
+				reap_lat[reap_lat_cnt++ % REAP_LAT_SAMPLES] =
+					current_time_hires() -
+					trusty_app->exit_time;
+
 				// not safe to access thread struct beyond thread_join
 				trusty_app->kt = NULL;
 				trusty_app->ut = NULL;
@@ -1278,15 +1563,199 @@ static int trusty_exit_handler(void *arg)
 			}
 		}
 		THREAD_UNLOCK(state);
-		thread_sleep(10);
+
+		/* let the exiting thread get to thread_exit, then retry */
+		if (pending) {
+			thread_sleep(1);
+			event_signal(&reap_event, false);
+		}
 	}
 }
 
 static void start_exit_handler(uint level)
 {
+	uthread_set_exit_notifier(trusty_app_thread_exit);
 	thread_detach_and_resume(thread_create("trusty_exit_handler",
 				&trusty_exit_handler, NULL, HIGH_PRIORITY,
 				DEFAULT_STACK_SIZE));
 }
 
 LK_INIT_HOOK(libtrusty_apps_exit_handler, start_exit_handler, LK_INIT_LEVEL_APPS - 1);
+
+#if WITH_LIB_CONSOLE
+#include <lib/console.h>
+
+/*
+ * Memory of every loaded instance. Stack and heap are only reserved; pages
+ * of them and of the image get allocated when the instance writes them.
+ */
+static int cmd_ta_mem(int argc, const cmd_args *argv)
+{
+	trusty_app_t *ta;
+	size_t cow_size, total = 0;
+
+	THREAD_LOCK(state);
+	printf("apps %u loaded %u boot %llu us\n", apps_registered,
+	       apps_loaded, apps_boot_time);
+
+	list_for_every_entry(&trusty_app_list, ta, trusty_app_t,
+			trusty_app_node) {
+		if (!ta->ut)
+			continue;
+
+		cow_size = ta->ut->cow_pages * PAGE_SIZE;
+		total += cow_size;
+		printf("%3u %-40s load %6llu us reserved %6zu private %6zu\n",
+		       trusty_app_index(ta), ta->ut->thread->name,
+		       ta->load_time, ta->load_size, cow_size);
+	}
+	THREAD_UNLOCK(state);
+
+	printf("private total %zu\n", total);
+
+	return 0;
+}
+
+static int lat_cmp(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Pool sizes and percentiles of the recent trusty_app_start_clone calls */
+static int cmd_ta_pool(int argc, const cmd_args *argv)
+{
+	uint32_t lat[CLONE_LAT_SAMPLES];
+	trusty_app_t *ta;
+	u_int n, hits, calls;
+
+	THREAD_LOCK(state);
+	if (argc > 1 && !strcmp(argv[1].str, "reset")) {
+		clone_lat_cnt = 0;
+		clone_pool_hits = 0;
+		THREAD_UNLOCK(state);
+		return 0;
+	}
+
+	list_for_every_entry(&trusty_app_list, ta, trusty_app_t,
+			trusty_app_node) {
+		if (ta->is_parent && ta->props.instance_pool)
+			printf("%3u pool %zu/%u\n", trusty_app_index(ta),
+			       list_length(&ta->pool_list),
+			       ta->props.instance_pool);
+	}
+
+	calls = clone_lat_cnt;
+	hits = clone_pool_hits;
+	n = MIN(calls, CLONE_LAT_SAMPLES);
+	memcpy(lat, clone_lat, n * sizeof(lat[0]));
+	THREAD_UNLOCK(state);
+
+	printf("clones %u from pool %u\n", calls, hits);
+	if (!n)
+		return 0;
+
+	qsort(lat, n, sizeof(lat[0]), lat_cmp);
+	printf("last %u: p50 %u us p90 %u us p99 %u us max %u us\n", n,
+	       lat[n * 50 / 100], lat[n * 90 / 100], lat[n * 99 / 100],
+	       lat[n - 1]);
+
+	return 0;
+}
+
+/* Delay between an app thread exiting and its resources being released */
+static int cmd_ta_reap(int argc, const cmd_args *argv)
+{
+	uint32_t lat[REAP_LAT_SAMPLES];
+	u_int n, reaped;
+
+	THREAD_LOCK(state);
+	if (argc > 1 && !strcmp(argv[1].str, "reset")) {
+		reap_lat_cnt = 0;
+		THREAD_UNLOCK(state);
+		return 0;
+	}
+
+	reaped = reap_lat_cnt;
+	n = MIN(reaped, REAP_LAT_SAMPLES);
+	memcpy(lat, reap_lat, n * sizeof(lat[0]));
+	THREAD_UNLOCK(state);
+
+	printf("reaped %u\n", reaped);
+	if (!n)
+		return 0;
+
+	qsort(lat, n, sizeof(lat[0]), lat_cmp);
+	printf("last %u: p50 %u us p90 %u us p99 %u us max %u us\n", n,
+	       lat[n * 50 / 100], lat[n * 90 / 100], lat[n * 99 / 100],
+	       lat[n - 1]);
+
+	return 0;
+}
+
+static int lookup_count(trusty_app_t *ta, void *data)
+{
+	(*(u_int *)data)++;
+	return 0;
+}
+
+#define LOOKUP_ROUNDS	64
+
+/*
+ * Time rounds of trusty_app_find_instance_by_uuid over every parent, which
+ * is what each connect and session open does, and print the spread of the
+ * cost of one lookup. This includes the locked walk of the instances.
+ */
+static int cmd_ta_lookup(int argc, const cmd_args *argv)
+{
+	uint32_t lat[LOOKUP_ROUNDS];
+	uuid_t *uuids;
+	trusty_app_t *ta;
+	lk_bigtime_t start;
+	u_int i, n = 0, r, instances = 0;
+	int fn_ret;
+
+	uuids = malloc(trusty_app_count * sizeof(uuids[0]));
+	if (!uuids)
+		return ERR_NO_MEMORY;
+
+	THREAD_LOCK(state);
+	list_for_every_entry(&trusty_app_list, ta, trusty_app_t,
+			trusty_app_node) {
+		if (ta->is_parent && n < trusty_app_count)
+			uuids[n++] = ta->props.uuid;
+	}
+	THREAD_UNLOCK(state);
+
+	if (!n) {
+		free(uuids);
+		return 0;
+	}
+
+	for (r = 0; r < LOOKUP_ROUNDS; r++) {
+		start = current_time_hires();
+		for (i = 0; i < n; i++)
+			trusty_app_find_instance_by_uuid(&uuids[i],
+					lookup_count, &instances, &fn_ret);
+		lat[r] = (current_time_hires() - start) * 1000 / n;
+	}
+	free(uuids);
+
+	qsort(lat, LOOKUP_ROUNDS, sizeof(lat[0]), lat_cmp);
+	printf("%u parents %u instances\n", n, instances / LOOKUP_ROUNDS);
+	printf("per lookup: p50 %u ns p90 %u ns p99 %u ns max %u ns\n",
+	       lat[LOOKUP_ROUNDS * 50 / 100], lat[LOOKUP_ROUNDS * 90 / 100],
+	       lat[LOOKUP_ROUNDS * 99 / 100], lat[LOOKUP_ROUNDS - 1]);
+
+	return 0;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("ta_mem", "app boot time, per instance load time and memory", &cmd_ta_mem)
+STATIC_COMMAND("ta_pool", "instance pools and clone latency [reset]", &cmd_ta_pool)
+STATIC_COMMAND("ta_reap", "app exit to reap latency [reset]", &cmd_ta_reap)
+STATIC_COMMAND("ta_lookup", "time uuid lookups of all apps", &cmd_ta_lookup)
+STATIC_COMMAND_END(trusty_app);
+#endif
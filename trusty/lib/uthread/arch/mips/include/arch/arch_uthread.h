@@ -54,6 +54,7 @@ struct arch_uthread
 {
 	uint32_t kernel_stack;
 	asid_t asid[SMP_MAX_CPUS];
+	vaddr_t tlb_fault_next;	/* pair after the last tlb reload */
 };
 
 uint32_t mips_cpu_asid(struct uthread *ut, uint cpu);
@@ -40,6 +40,19 @@
 #define MMU_L2_INDEX_MASK	((1 << MMU_L2_INDEX_WIDTH) - 1)
 #define MMU_L2_SIZE		(1 << (MMU_L2_INDEX_WIDTH + 2))
 
+/*
+ * Large page L2 entries. With a 32 bit paddr the top pte bits are never
+ * part of the PFN, so they tag every pte of a page that the tlb refill
+ * handler loads as one even/odd pair of (4K << (2 * pgsz)) pages.
+ */
+#define MMU_PTE_LARGE		(1U << 31)
+#define MMU_PTE_PGSZ_SHIFT	(28)
+#define MMU_PTE_PGSZ_BITS	(3)
+#define MMU_PTE_PGSZ_MASK	(MMU_PTE_LARGE | \
+				 (((1U << MMU_PTE_PGSZ_BITS) - 1) << MMU_PTE_PGSZ_SHIFT))
+#define MMU_PTE_PGSZ_MAX	(6)	/* 16MB */
+#define MMU_PTE_PGSZ_PAGE_SHIFT(pgsz)	(SHIFT_4K + (2 * (pgsz)))
+
 #ifndef ASSEMBLY
 
 #include <arch.h>
@@ -58,6 +71,10 @@ status_t mips_uthread_mmu_query(uthread_t *ut, vaddr_t vaddr, paddr_t *paddr,
 status_t mips_uthread_mmu_map(uthread_t *ut, paddr_t paddr,
 		vaddr_t vaddr, uint l1_flags, uint l2_flags);
 status_t mips_uthread_mmu_unmap(uthread_t *ut, vaddr_t vaddr);
+status_t mips_uthread_mmu_remap(uthread_t *ut, paddr_t paddr,
+		vaddr_t vaddr, uint l2_flags);
+status_t mips_uthread_mmu_tlb_load(uthread_t *ut, vaddr_t vaddr,
+		size_t *pair_size, bool whole_pair);
 
 #endif // ASSEMBLY
 
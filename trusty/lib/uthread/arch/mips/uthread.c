@@ -36,6 +36,7 @@
 #include <uthread.h>
 
 #define PAGE_MASK (PAGE_SIZE - 1)
+#define HWRENA_CC (1 << 2)
 
 vaddr_t kernel_sp[SMP_MAX_CPUS];
 vaddr_t user_pgd[SMP_MAX_CPUS];
@@ -90,6 +91,9 @@ void arch_uthread_init()
 {
 	for (uint i = 0; i < SMP_MAX_CPUS; i++)
 		asid_version[i] = ASID_INITIAL_VERSION;
+
+	/* let user mode rdhwr the count register, for time without a syscall */
+	mips_write_c0_hwrena(mips_read_c0_hwrena() | HWRENA_CC);
 }
 
 void arch_uthread_startup(void)
@@ -160,6 +164,7 @@ void arch_uthread_context_switch(struct uthread *old_ut, struct uthread *new_ut)
 status_t arch_uthread_create(struct uthread *ut)
 {
 	ut->arch.kernel_stack = ut->thread->arch.cs_frame.sp;
+	ut->arch.tlb_fault_next = 0;
 	mips_asid_init(ut);
 	return NO_ERROR;
 }
@@ -179,7 +184,7 @@ static void arch_uthread_mmu_flags(u_int flags, u_int *l1_flags,
 	*l2_flags = MMU_NO_PERM | MMU_VALID;
 	if (flags & UTM_R)
 		*l2_flags &= ~MMU_NO_READ;
-	if (flags & UTM_W)
+	if ((flags & UTM_W) && !(flags & UTM_COW))
 		*l2_flags |= MMU_DIRTY;
 	if (flags & UTM_X)
 		*l2_flags &= ~MMU_NO_EXEC;
@@ -187,12 +192,43 @@ static void arch_uthread_mmu_flags(u_int flags, u_int *l1_flags,
 	*l2_flags |= (flags & UTM_IO) ? MMU_UNCACHED : MMU_CACHED;
 }
 
+/*
+ * Largest page that can back vaddr of a physically contiguous map. The
+ * tlb maps pages in even/odd pairs, so the whole pair must lie inside the
+ * map and the map's physical offset must be a multiple of the page size.
+ */
+static u_int arch_uthread_large_pgsz(struct uthread_map *mp, vaddr_t vaddr)
+{
+	u_int pgsz;
+	size_t size;
+	vaddr_t pair;
+
+	for (pgsz = MMU_PTE_PGSZ_MAX; pgsz > 0; pgsz--) {
+		size = 1UL << MMU_PTE_PGSZ_PAGE_SHIFT(pgsz);
+		if (size <= PAGE_SIZE)
+			break;
+
+		if ((mp->vaddr - mp->pfn_list[0]) & (size - 1))
+			continue;
+
+		pair = ROUNDDOWN(vaddr, 2 * size);
+		if (pair < mp->vaddr ||
+		    pair + 2 * size > mp->vaddr + mp->size)
+			continue;
+
+		return MMU_PTE_LARGE | (pgsz << MMU_PTE_PGSZ_SHIFT);
+	}
+
+	return 0;
+}
+
 status_t arch_uthread_map(struct uthread *ut, struct uthread_map *mp)
 {
 	addr_t vaddr, paddr;
 	u_int pg;
 	u_int l1_flags = 0;
 	u_int l2_flags = 0;
+	u_int pgsz = 0;
 	status_t err = NO_ERROR;
 
 	if (mp->size > MAX_USR_VA || mp->vaddr > (MAX_USR_VA - mp->size)) {
@@ -223,8 +259,11 @@ status_t arch_uthread_map(struct uthread *ut, struct uthread_map *mp)
 
 		vaddr = mp->vaddr + (pg * PAGE_SIZE);
 
+		if (mp->flags & UTM_PHYS_CONTIG)
+			pgsz = arch_uthread_large_pgsz(mp, vaddr);
+
 		err = mips_uthread_mmu_map(ut, paddr, vaddr,
-					l1_flags, l2_flags);
+					l1_flags, l2_flags | pgsz);
 
 		if (err)
 			goto err_undo_maps;
@@ -258,3 +297,16 @@ status_t arch_uthread_unmap(struct uthread *ut, struct uthread_map *mp)
 done:
 	return err;
 }
+
+status_t arch_uthread_remap_page(struct uthread *ut, vaddr_t vaddr,
+		paddr_t paddr, u_int flags)
+{
+	u_int l1_flags, l2_flags;
+
+	if (paddr & PAGE_MASK)
+		return ERR_INVALID_ARGS;
+
+	arch_uthread_mmu_flags(flags, &l1_flags, &l2_flags);
+
+	return mips_uthread_mmu_remap(ut, paddr, vaddr, l2_flags);
+}
@@ -30,6 +30,7 @@
 #include <string.h>
 #include <assert.h>
 #include <arch.h>
+#include <mips/m32c0.h>
 #include <arch/mips.h>
 #include <arch/tlb.h>
 #include <arch/mips/mmu.h>
@@ -45,6 +46,10 @@ static void mips_uthread_mmu_init(uint level)
 	STATIC_ASSERT(KERNEL_BASE > MAX_USR_VA);
 	STATIC_ASSERT(MAX_USR_VA ==
 		((MMU_L1_SIZE / 4) * ((MMU_L2_SIZE / 4) * PAGE_SIZE)));
+	/* large page tags live in pte bits a 32 bit paddr never reaches */
+	STATIC_ASSERT(sizeof(paddr_t) == 4);
+	STATIC_ASSERT((2UL << MMU_PTE_PGSZ_PAGE_SHIFT(MMU_PTE_PGSZ_MAX)) <=
+		MAX_USR_VA);
 
 	mips_invalidate_tlb_global();
 }
@@ -171,7 +176,7 @@ static status_t mips_uthread_mmu_pgd_walk(uint32_t *page_table, vaddr_t vaddr,
 }
 
 static inline paddr_t pte_ptr_to_paddr(u_int* pte_ptr) {
-	return (*pte_ptr >> MMU_FLAG_BITS) << SHIFT_4K;
+	return ((*pte_ptr & ~MMU_PTE_PGSZ_MASK) >> MMU_FLAG_BITS) << SHIFT_4K;
 }
 
 status_t mips_uthread_mmu_query(uthread_t *ut, vaddr_t vaddr, paddr_t *paddr,
@@ -198,6 +203,79 @@ status_t mips_uthread_mmu_query(uthread_t *ut, vaddr_t vaddr, paddr_t *paddr,
 	return NO_ERROR;
 }
 
+static bool pte_valid(uint32_t *page_table, vaddr_t vaddr)
+{
+	u_int *pte_ptr;
+
+	if (pgd_walk(page_table, vaddr, &pte_ptr, NULL, 0))
+		return false;
+
+	return *pte_ptr & MMU_VALID;
+}
+
+static tlblo_t pte_to_entrylo(uint32_t *page_table, vaddr_t vaddr)
+{
+	u_int *pte_ptr;
+	u_int pte;
+
+	if (pgd_walk(page_table, vaddr, &pte_ptr, NULL, 0))
+		return 0;
+
+	pte = *pte_ptr & ~MMU_PTE_PGSZ_MASK;
+	return (pte >> TLB_ENTRYLO_RIXI_ROTR) |
+		(pte << (32 - TLB_ENTRYLO_RIXI_ROTR));
+}
+
+/*
+ * Load the tlb entry of the pte pair mapping vaddr the way _tlb_refill
+ * does, rewriting a stale entry for it in place. The size of the pair
+ * is returned in *pair_size so the caller can step to the next pair.
+ * With whole_pair nothing is written unless both halves are mapped, so a
+ * speculative load never installs an invalid half.
+ */
+status_t mips_uthread_mmu_tlb_load(uthread_t *ut, vaddr_t vaddr,
+		size_t *pair_size, bool whole_pair)
+{
+	uint32_t *page_table;
+	u_int *pte_ptr;
+	u_int shift = PAGE_SIZE_SHIFT;
+	vaddr_t pair;
+	tlbhi_t entryhi;
+	status_t err;
+
+	page_table = (uint32_t *)(ut->page_table);
+	if (!page_table)
+		return ERR_INVALID_ARGS;
+
+	err = pgd_walk(page_table, vaddr, &pte_ptr, NULL, 0);
+	if (err)
+		return err;
+
+	if (!(*pte_ptr & MMU_VALID))
+		return ERR_NOT_FOUND;
+
+	if (*pte_ptr & MMU_PTE_LARGE)
+		shift = MMU_PTE_PGSZ_PAGE_SHIFT((*pte_ptr >> MMU_PTE_PGSZ_SHIFT) &
+				((1U << MMU_PTE_PGSZ_BITS) - 1));
+
+	pair = ROUNDDOWN(vaddr, 2UL << shift);
+	if (whole_pair && !(pte_valid(page_table, pair) &&
+			    pte_valid(page_table, pair + (1UL << shift))))
+		return ERR_NOT_FOUND;
+
+	entryhi = pair | (mips_cpu_asid(ut, arch_curr_cpu_num()) &
+			C0_ENTRYHI_ASID_MASK);
+
+	mips_tlbrwr2(entryhi, pte_to_entrylo(page_table, pair),
+			pte_to_entrylo(page_table, pair + (1UL << shift)),
+			((1UL << shift) - PAGE_SIZE_4K) << 1);
+
+	if (pair_size)
+		*pair_size = 2UL << shift;
+
+	return NO_ERROR;
+}
+
 status_t mips_uthread_mmu_map(uthread_t *ut, paddr_t paddr,
 		vaddr_t vaddr, uint l1_flags, uint l2_flags)
 {
@@ -229,7 +307,7 @@ status_t mips_uthread_mmu_map(uthread_t *ut, paddr_t paddr,
 	/* store pte such that tlb_refill can do ROTR to align paddr with tlb
 	 * entrylo.PFN field and get RIXI flags into entrylo high order bits */
 	*level_2_pte = ((paddr >> SHIFT_4K) << MMU_FLAG_BITS) | (l2_flags &
-			MMU_FLAGS);
+			(MMU_FLAGS | MMU_PTE_PGSZ_MASK));
 
 done:
 	return err;
@@ -258,3 +336,30 @@ status_t mips_uthread_mmu_unmap(uthread_t *ut, vaddr_t vaddr)
 done:
 	return err;
 }
+
+/* Point the existing pte of vaddr at a new page, dropping any stale tlb entry */
+status_t mips_uthread_mmu_remap(uthread_t *ut, paddr_t paddr,
+		vaddr_t vaddr, uint l2_flags)
+{
+	uint32_t *page_table;
+	u_int *level_2_pte;
+	status_t err;
+
+	page_table = (uint32_t *)(ut->page_table);
+	if (!page_table)
+		return ERR_INVALID_ARGS;
+
+	err = mips_uthread_mmu_pgd_walk(page_table, vaddr, &level_2_pte, NULL);
+	if (err)
+		return err;
+
+	if (!(*level_2_pte & MMU_VALID) || (*level_2_pte & MMU_PTE_LARGE))
+		return ERR_NOT_VALID;
+
+	*level_2_pte = ((paddr >> SHIFT_4K) << MMU_FLAG_BITS) | (l2_flags &
+			MMU_FLAGS);
+	SYNC;
+	mips_invalidate_tlb_asid(vaddr, mips_cpu_asid(ut, arch_curr_cpu_num()));
+
+	return NO_ERROR;
+}
@@ -46,6 +46,8 @@ void arch_uthread_context_switch(struct uthread *old_ut, struct uthread *new_ut)
 
 status_t arch_uthread_map(struct uthread *ut, struct uthread_map *mp);
 status_t arch_uthread_unmap(struct uthread *ut, struct uthread_map *mp);
+status_t arch_uthread_remap_page(struct uthread *ut, vaddr_t vaddr,
+		paddr_t paddr, u_int flags);
 
 status_t arch_copy_from_user(void *kdest, user_addr_t usrc, size_t len);
 status_t arch_copy_to_user(user_addr_t udest, const void *ksrc, size_t len);
@@ -43,6 +43,16 @@ typedef struct uthread_map
 	u_int  flags;
 	u_int align;
 	struct list_node node;
+
+	/* map tree, see uthread_map_tree.c */
+	struct uthread_map *left;
+	struct uthread_map *right;
+	vaddr_t gap;		/* unmapped VA between the previous map and this one */
+	vaddr_t max_gap;	/* largest gap in this subtree */
+	u_short height;
+	bool has_sec;		/* subtree holds a non-NS map */
+
+	/* UTM_COW maps follow the pfns with the shared pages they started as */
 	paddr_t pfn_list[];
 } uthread_map_t;
 
@@ -89,9 +99,9 @@ typedef struct uthread
 	vaddr_t start_stack;
 
 	vaddr_t entry;
-	void *stack;
 
 	struct list_node map_list;
+	struct uthread_map *map_tree;
 	mutex_t mmap_lock;
 	vaddr_t ns_va_bottom;
 
@@ -104,6 +114,9 @@ typedef struct uthread
 	struct list_node uthread_list_node;
 	void *private_data;
 
+	/* private pages made by copy-on-write faults */
+	u_int cow_pages;
+
 	/* user-space panic function */
 	panic_fn_t u_panic_handler_fn;
 	panic_args_t u_panic_args;
@@ -123,6 +136,7 @@ enum
 	UTM_NS_MEM	= 1 << 6,
 	UTM_IO		= 1 << 7,
 	UTM_FIXED	= 1 << 8,
+	UTM_COW		= 1 << 9,	/* writable, pages shared until written */
 };
 
 /* uthread mapping alignments */
@@ -131,6 +145,9 @@ enum
 #define UT_MAP_ALIGN_1MB	(1UL * 1024 * 1024)
 #define UT_MAP_ALIGN_DEFAULT	PAGE_SIZE
 
+/* page addresses per page of an NS page list, the last slot links the next */
+#define NS_PAGELIST_ENTRIES	(PAGE_SIZE / sizeof(uint64_t) - 1)
+
 /* Create a new user thread */
 uthread_t *uthread_create(const char *name, vaddr_t entry, int priority,
 		vaddr_t stack_top, size_t stack_size, void *private_data);
@@ -142,6 +159,9 @@ status_t uthread_start(uthread_t *ut);
 void uthread_exit(int retcode) __NO_RETURN;
 void uthread_kill(uthread_t *ut, int retcode);
 
+/* Set a function to be called by each uthread as it exits */
+void uthread_set_exit_notifier(void (*fn)(uthread_t *ut));
+
 /* set user-space address of panic function and args */
 void uthread_set_user_panic_fn(panic_fn_t panic_fn, panic_args_t args);
 void uthread_get_user_panic_fn(panic_fn_t *panic_fn, panic_args_t *args);
@@ -150,12 +170,19 @@ void uthread_get_user_panic_fn(panic_fn_t *panic_fn, panic_args_t *args);
 status_t uthread_map(uthread_t *ut, vaddr_t *vaddrp, paddr_t *pfn_list,
 		size_t size, u_int flags, u_int align);
 
+/* Map a zero filled region whose pages are allocated on first write */
+status_t uthread_map_zero(uthread_t *ut, vaddr_t *vaddrp, size_t size,
+		u_int flags, u_int align);
+
 /* Unmap a region of memory */
 status_t uthread_unmap(uthread_t *ut, vaddr_t vaddr, size_t size);
 
 /* Check if the given user address range has a valid mapping */
 bool uthread_is_valid_range(uthread_t *ut, vaddr_t vaddr, size_t size);
 
+/* Give the faulting page of a UTM_COW map a private, writable copy */
+status_t uthread_cow_fault(uthread_t *ut, vaddr_t vaddr);
+
 static inline status_t copy_from_user(void *kdest, user_addr_t usrc, size_t len)
 {
 	return arch_copy_from_user(kdest, usrc, len);
@@ -195,16 +222,24 @@ static inline uthread_t *uthread_get_current(void)
 /* Translate virtual address to physical address */
 status_t uthread_virt_to_phys(uthread_t *ut, vaddr_t vaddr, paddr_t *paddr);
 status_t uthread_virt_to_phys_flags(uthread_t *ut, vaddr_t vaddr,
-		paddr_t *paddr, u_int *flags);
+		paddr_t *paddr, u_int *flags, bool write);
 
-/* Translate virtual address to kernel virtual address */
-status_t uthread_virt_to_kvaddr(uthread_t *ut, vaddr_t vaddr, void **kvaddr);
+/*
+ * Translate virtual address to kernel virtual address. Pass write if the
+ * kernel will store through it, so a copy-on-write page is unshared first.
+ */
+status_t uthread_virt_to_kvaddr(uthread_t *ut, vaddr_t vaddr, void **kvaddr,
+		bool write);
 
 /* Grant pages from current context into target uthread */
 status_t uthread_grant_pages(uthread_t *ut_target, uthread_t *ut_src,
 		ext_vaddr_t vaddr_src, size_t size, u_int flags,
 		vaddr_t *vaddr_target, bool ns_src);
 
+/* Grant an NS buffer described by a page list into target uthread */
+status_t uthread_grant_ns_pagelist(uthread_t *ut_target, ext_vaddr_t pagelist,
+		size_t size, u_int flags, vaddr_t *vaddr_target);
+
 /* Revoke mappings from a previous grant */
 status_t uthread_revoke_pages(uthread_t *ut, vaddr_t vaddr, size_t size);
 #endif
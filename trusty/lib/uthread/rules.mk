@@ -33,7 +33,8 @@ GLOBAL_INCLUDES += \
 MODULE_DEPS += kernel
 
 MODULE_SRCS += \
-	$(LOCAL_DIR)/uthread.c
+	$(LOCAL_DIR)/uthread.c \
+	$(LOCAL_DIR)/uthread_map_tree.c
 
 include $(LOCAL_DIR)/arch/$(ARCH)/rules.mk
 
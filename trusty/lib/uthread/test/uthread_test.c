@@ -23,16 +23,26 @@
 
 #include <debug.h>
 #include <assert.h>
+#include <err.h>
+#include <string.h>
 #include <sys/types.h>
 #include <uthread.h>
 #include <arch/uthread_mmu.h>
 #include <lk/init.h>
+#include <platform.h>
 #include <trusty_unittest.h>
 
+#if WITH_LIB_CONSOLE
+#include <lib/console.h>
+#endif
+
 #define LOG_TAG "uthread_test"
 
 #define PAGE_MASK (PAGE_SIZE - 1)
 
+#define BENCH_MAPS	500
+#define BENCH_PASSES	100
+
 extern void umain(void);
 
 void uthread_test(void)
@@ -159,6 +169,88 @@ void uthread_test(void)
 		TLOGI("Some tests FAILED\n");
 }
 
+#if WITH_LIB_CONSOLE
+/* time access checks against a uthread holding BENCH_MAPS maps */
+static int uthread_map_bench(int argc, const cmd_args *argv)
+{
+	static vaddr_t map_addr[BENCH_MAPS];
+	static bool mapped[BENCH_MAPS];
+	lk_bigtime_t start, usecs;
+	status_t err = NO_ERROR;
+	uint i, pass, checks = 0;
+
+	uthread_t *ut = uthread_create("bench_ut", 0x8000, DEFAULT_PRIORITY,
+			MAX_USR_VA >> 1, PAGE_SIZE, NULL);
+	if (!ut) {
+		TLOGI("uthread_create failed\n");
+		return ERR_NO_MEMORY;
+	}
+
+	memset(mapped, 0, sizeof(mapped));
+
+	for (i = 0; i < BENCH_MAPS; i++) {
+		err = uthread_map_contig(ut, &map_addr[i],
+				vaddr_to_paddr(umain), PAGE_SIZE,
+				UTM_R | UTM_W, UT_MAP_ALIGN_DEFAULT);
+		if (err) {
+			TLOGI("Error mapping bench segment %u: %d\n", i, err);
+			goto out;
+		}
+		mapped[i] = true;
+	}
+
+	/* punch holes so the allocator has gaps to search */
+	for (i = 0; i < BENCH_MAPS; i += 2) {
+		uthread_unmap(ut, map_addr[i], PAGE_SIZE);
+		mapped[i] = false;
+	}
+
+	start = current_time_hires();
+	for (pass = 0; pass < BENCH_PASSES; pass++) {
+		for (i = 0; i < BENCH_MAPS; i++)
+			checks += uthread_is_valid_range(ut, map_addr[i],
+					PAGE_SIZE);
+	}
+	usecs = current_time_hires() - start;
+
+	TLOGI("%u maps: %u/%u valid range checks in %llu us\n",
+			BENCH_MAPS / 2, checks, BENCH_MAPS * BENCH_PASSES,
+			(unsigned long long)usecs);
+
+	start = current_time_hires();
+	for (i = 0; i < BENCH_MAPS; i += 2) {
+		err = uthread_map_contig(ut, &map_addr[i],
+				vaddr_to_paddr(umain), PAGE_SIZE,
+				UTM_R | UTM_W, UT_MAP_ALIGN_DEFAULT);
+		if (err) {
+			TLOGI("Error remapping bench segment %u: %d\n", i, err);
+			goto out;
+		}
+		mapped[i] = true;
+	}
+	usecs = current_time_hires() - start;
+
+	TLOGI("%u maps filled into gaps in %llu us\n", BENCH_MAPS / 2,
+			(unsigned long long)usecs);
+
+out:
+	/* odd slots are still mapped when a remap fails part way */
+	for (i = 0; i < BENCH_MAPS; i++) {
+		if (mapped[i])
+			uthread_unmap(ut, map_addr[i], PAGE_SIZE);
+	}
+	/* bench_ut's thread was never resumed; this frees it outright */
+	uthread_kill(ut, 0);
+
+	return err;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("uthread_map_bench", "time range checks and gap-filling maps",
+		&uthread_map_bench)
+STATIC_COMMAND_END(uthreadtest);
+#endif /* WITH_LIB_CONSOLE */
+
 void uthread_test_run(uint level)
 {
 	uthread_test();
@@ -33,12 +33,31 @@
 #endif
 
 #include <kernel/mutex.h>
+#include <lib/slab.h>
 
 #include <arch/uthread_mmu.h>  // for MAX_USR_VA
 
+#include "uthread_map_tree.h"
+
 /* Global list of all userspace threads */
 static struct list_node uthread_list;
 
+/* Physically contiguous maps carry a single pfn and are the common case */
+static slab_cache_t contig_map_cache = SLAB_CACHE_INITIAL_VALUE(contig_map_cache,
+		"uthread_map", sizeof(uthread_map_t) + sizeof(paddr_t), NULL);
+
+/* Scratch pfn lists for grants of up to PFN_CACHE_PAGES pages */
+#define PFN_CACHE_PAGES	16
+
+static slab_cache_t pfn_list_cache = SLAB_CACHE_INITIAL_VALUE(pfn_list_cache,
+		"uthread_pfn_list", PFN_CACHE_PAGES * sizeof(paddr_t), NULL);
+
+/* Runs on an exiting uthread's own thread, before it is destroyed */
+static void (*uthread_exit_notifier)(uthread_t *ut);
+
+/* backs every page of uthread_map_zero maps until it is written */
+static uint8_t zero_page[PAGE_SIZE] __ALIGNED(PAGE_SIZE);
+
 /* Monotonically increasing thread id for now */
 static uint32_t next_utid;
 static spin_lock_t uthread_lock;
@@ -73,40 +92,58 @@ static void uthread_free_utid(uint32_t utid)
 }
 
 
+static inline bool uthread_cow_shared(uthread_map_t *mp, u_int pg)
+{
+	return mp->pfn_list[pg] == mp->pfn_list[(mp->size / PAGE_SIZE) + pg];
+}
+
+static void uthread_map_free(uthread_map_t *mp)
+{
+	u_int pg;
+
+	if (mp->flags & UTM_COW) {
+		for (pg = 0; pg < mp->size / PAGE_SIZE; pg++)
+			if (!uthread_cow_shared(mp, pg))
+				free(paddr_to_kvaddr(mp->pfn_list[pg]));
+	}
+
+	if (mp->flags & UTM_PHYS_CONTIG)
+		slab_free(&contig_map_cache, mp);
+	else
+		free(mp);
+}
+
 static vaddr_t uthread_find_va_space_ns(uthread_t *ut, size_t size, u_int align)
 {
 	vaddr_t start, end;
 	uthread_map_t *mp;
+	bool blocked = false;
 
 	/* get first suitable address */
 	start = ROUNDDOWN(MAX_USR_VA - size, align);
 	end = start + size;
 
 	mp = list_peek_tail_type (&ut->map_list, uthread_map_t, node);
-	while (mp) {
-		if (start >= mp->vaddr + mp->size) { /* found gap */
-
-			if (start >= ut->ns_va_bottom)
-				break; /* the whole map fits above ns_va_bottom */
-
-			/* check if we can move ns_va_bottom */
-			DEBUG_ASSERT((mp->flags & UTM_NS_MEM) == 0);
-			if (ROUNDDOWN(start, UT_MAP_ALIGN_1MB) < mp->vaddr + mp->size)
-				return (vaddr_t) NULL; /*  nope, we can't */
-
-			break;
-		}
+	if (mp && start < mp->vaddr + mp->size) {
+		/* no room above the top map, find the highest gap below it */
+		mp = uthread_map_tree_gap_down(ut->map_tree, size, align,
+				&start, &blocked);
+		if (!mp)
+			return (vaddr_t) NULL;  /* no gap above the non-NS maps */
 
-		if (!(mp->flags & UTM_NS_MEM))
-			return (vaddr_t) NULL;  /* next mp is non-NS */
-
-		start = MIN(start, ROUNDDOWN((mp->vaddr - size), align));
 		end = start + size;
 
-		/* get prev list item */
+		/* the gap ends at mp, check the map below it */
 		mp = list_prev_type(&ut->map_list, &mp->node, uthread_map_t, node);
 	}
 
+	if (mp && start < ut->ns_va_bottom) {
+		/* check if we can move ns_va_bottom */
+		DEBUG_ASSERT((mp->flags & UTM_NS_MEM) == 0);
+		if (ROUNDDOWN(start, UT_MAP_ALIGN_1MB) < mp->vaddr + mp->size)
+			return (vaddr_t) NULL; /*  nope, we can't */
+	}
+
 	if (start < ut->start_stack || start > end)
 		return (vaddr_t) NULL;
 
@@ -118,17 +155,17 @@ static vaddr_t uthread_find_va_space_sec(uthread_t *ut, size_t size, u_int align
 	vaddr_t start, end;
 	uthread_map_t *mp;
 
-	start = ROUNDUP(ut->start_stack, align);
-	end = start + size;
-
 	/* find first fit */
-	list_for_every_entry(&ut->map_list, mp, uthread_map_t, node) {
-		if (end <= mp->vaddr)
-			break;
-
-		start = MAX(start, ROUNDUP((mp->vaddr + mp->size), align));
-		end = start + size;
+	mp = uthread_map_tree_gap_up(ut->map_tree, size, ut->start_stack,
+			align, &start);
+	if (!mp) {
+		/* nothing fits between maps, go above the last one */
+		start = ROUNDUP(ut->start_stack, align);
+		mp = list_peek_tail_type(&ut->map_list, uthread_map_t, node);
+		if (mp)
+			start = MAX(start, ROUNDUP((mp->vaddr + mp->size), align));
 	}
+	end = start + size;
 
 	if (end > ut->ns_va_bottom || start > end)
 		return (vaddr_t) NULL;
@@ -149,7 +186,7 @@ static status_t uthread_map_alloc(uthread_t *ut, uthread_map_t **mpp,
 		vaddr_t vaddr, paddr_t *pfn_list, size_t size, u_int flags,
 		u_int align)
 {
-	uthread_map_t *mp, *mp_lst;
+	uthread_map_t *mp, *prev, *next;
 	status_t err = NO_ERROR;
 	uint32_t npages;
 
@@ -158,22 +195,48 @@ static status_t uthread_map_alloc(uthread_t *ut, uthread_map_t **mpp,
 	if (vaddr + size <= vaddr)
 		return ERR_INVALID_ARGS;
 
-	if (flags & UTM_PHYS_CONTIG)
-		npages = 1;
-	else
+	if (flags & UTM_COW) {
+		/* every page gets its own pfn once it is written */
+		if (!(flags & UTM_W) || (flags & (UTM_NS_MEM | UTM_IO)))
+			return ERR_INVALID_ARGS;
+
 		npages = (size / PAGE_SIZE);
+		mp = malloc(sizeof(uthread_map_t) +
+			    (2 * npages * sizeof(mp->pfn_list[0])));
+		if (!mp) {
+			err = ERR_NO_MEMORY;
+			goto err_out;
+		}
 
-	mp = malloc(sizeof(uthread_map_t) + (npages * sizeof(mp->pfn_list[0])));
-	if (!mp) {
-		err = ERR_NO_MEMORY;
-		goto err_out;
+		for (u_int pg = 0; pg < npages; pg++) {
+			if (flags & UTM_PHYS_CONTIG)
+				mp->pfn_list[pg] = pfn_list[0] + (pg * PAGE_SIZE);
+			else
+				mp->pfn_list[pg] = pfn_list[pg];
+			mp->pfn_list[npages + pg] = mp->pfn_list[pg];
+		}
+		flags &= ~UTM_PHYS_CONTIG;
+	} else {
+		if (flags & UTM_PHYS_CONTIG)
+			npages = 1;
+		else
+			npages = (size / PAGE_SIZE);
+
+		if (flags & UTM_PHYS_CONTIG)
+			mp = slab_alloc(&contig_map_cache);
+		else
+			mp = malloc(sizeof(uthread_map_t) + (npages * sizeof(mp->pfn_list[0])));
+		if (!mp) {
+			err = ERR_NO_MEMORY;
+			goto err_out;
+		}
+		memcpy(mp->pfn_list, pfn_list, npages*sizeof(paddr_t));
 	}
 
 	mp->vaddr = vaddr;
 	mp->size = size;
 	mp->flags = flags;
 	mp->align = align;
-	memcpy(mp->pfn_list, pfn_list, npages*sizeof(paddr_t));
 
 
 	vaddr_t new_ns = ut->ns_va_bottom;
@@ -183,32 +246,40 @@ static status_t uthread_map_alloc(uthread_t *ut, uthread_map_t **mpp,
 		new_ns = ROUNDDOWN(mp->vaddr, UT_MAP_ALIGN_1MB);
 	}
 
-	list_for_every_entry(&ut->map_list, mp_lst, uthread_map_t, node) {
-		if (mp_lst->vaddr > mp->vaddr) {
-			if((mp->vaddr + mp->size) > mp_lst->vaddr) {
-				err = ERR_INVALID_ARGS;
-				goto err_free_mp;
-			}
-			ut->ns_va_bottom = new_ns;
-			list_add_before(&mp_lst->node, &mp->node);
-			goto out;
-		} else {
-			if (mp->vaddr < (mp_lst->vaddr + mp_lst->size)) {
-				err = ERR_INVALID_ARGS;
-				goto err_free_mp;
-			}
-		}
+	/* maps on either side of the new one */
+	prev = uthread_map_tree_floor(ut->map_tree, mp->vaddr);
+	if (prev)
+		next = list_next_type(&ut->map_list, &prev->node,
+				uthread_map_t, node);
+	else
+		next = list_peek_head_type(&ut->map_list, uthread_map_t, node);
+
+	if ((prev && mp->vaddr < prev->vaddr + prev->size) ||
+	    (next && mp->vaddr + mp->size > next->vaddr)) {
+		err = ERR_INVALID_ARGS;
+		goto err_free_mp;
 	}
 
 	ut->ns_va_bottom = new_ns;
-	list_add_tail(&ut->map_list, &mp->node);
-out:
+	if (prev) {
+		list_add_after(&prev->node, &mp->node);
+		mp->gap = mp->vaddr - (prev->vaddr + prev->size);
+	} else {
+		list_add_head(&ut->map_list, &mp->node);
+		mp->gap = mp->vaddr;
+	}
+	uthread_map_tree_insert(&ut->map_tree, mp);
+
+	if (next)
+		uthread_map_tree_set_gap(&ut->map_tree, next,
+				next->vaddr - (mp->vaddr + mp->size));
+
 	if (mpp)
 		*mpp = mp;
 	return NO_ERROR;
 
 err_free_mp:
-	free(mp);
+	uthread_map_free(mp);
 err_out:
 	if (mpp)
 		*mpp = NULL;
@@ -222,13 +293,11 @@ static uthread_map_t *uthread_map_find(uthread_t *ut, vaddr_t vaddr, size_t size
 	if (vaddr + size < vaddr)
 		return NULL;
 
-	/* TODO: Fuzzy comparisions for now */
-	list_for_every_entry(&ut->map_list, mp, uthread_map_t, node) {
-		if ((mp->vaddr <= vaddr) &&
-		    (vaddr < mp->vaddr + mp->size) &&
-		    ((mp->vaddr + mp->size) >= (vaddr + size))) {
-			return mp;
-		}
+	/* only the last map starting at or below vaddr can hold it */
+	mp = uthread_map_tree_floor(ut->map_tree, vaddr);
+	if (mp && (vaddr < mp->vaddr + mp->size) &&
+	    ((mp->vaddr + mp->size) >= (vaddr + size))) {
+		return mp;
 	}
 
 	return NULL;
@@ -237,6 +306,8 @@ static uthread_map_t *uthread_map_find(uthread_t *ut, vaddr_t vaddr, size_t size
 /* caller ensures mp is in the mapping list */
 static void uthread_map_remove(uthread_t *ut, uthread_map_t *mp)
 {
+	uthread_map_t *prev, *next;
+
 	if (mp->flags & UTM_NS_MEM) {
 		uthread_map_t *item;
 
@@ -260,8 +331,17 @@ static void uthread_map_remove(uthread_t *ut, uthread_map_t *mp)
 		}
 	}
 
+	prev = list_prev_type(&ut->map_list, &mp->node, uthread_map_t, node);
+	next = list_next_type(&ut->map_list, &mp->node, uthread_map_t, node);
+
 	list_delete(&mp->node);
-	free(mp);
+	uthread_map_tree_remove(&ut->map_tree, mp);
+
+	/* the gap below mp now belongs to the next map */
+	if (next)
+		uthread_map_tree_set_gap(&ut->map_tree, next,
+				next->vaddr - (prev ? prev->vaddr + prev->size : 0));
+	uthread_map_free(mp);
 }
 
 static void uthread_free_maps(uthread_t *ut)
@@ -271,8 +351,9 @@ static void uthread_free_maps(uthread_t *ut)
 			uthread_map_t, node) {
 		arch_uthread_unmap(ut, mp);
 		list_delete(&mp->node);
-		free(mp);
+		uthread_map_free(mp);
 	}
+	ut->map_tree = NULL;
 }
 
 uthread_t *uthread_create(const char *name, vaddr_t entry, int priority,
@@ -295,18 +376,13 @@ uthread_t *uthread_create(const char *name, vaddr_t entry, int priority,
 	ut->entry = entry;
 	ut->ns_va_bottom = MAX_USR_VA;
 
-	/* Allocate and map in a stack region */
-	ut->stack = memalign(PAGE_SIZE, stack_size);
-	if(!ut->stack)
-		goto err_free_ut;
-
+	/* Map in a stack region, pages are allocated as it grows into them */
 	stack_bot = start_stack - stack_size;
-	err = uthread_map_contig(ut, &stack_bot, vaddr_to_paddr(ut->stack),
-				stack_size,
+	err = uthread_map_zero(ut, &stack_bot, stack_size,
 				UTM_W | UTM_R | UTM_STACK | UTM_FIXED,
 				UT_MAP_ALIGN_DEFAULT);
 	if (err)
-		goto err_free_ut_stack;
+		goto err_free_ut;
 
 	ut->start_stack = start_stack;
 
@@ -335,9 +411,6 @@ uthread_t *uthread_create(const char *name, vaddr_t entry, int priority,
 err_free_ut_maps:
 	uthread_free_maps(ut);
 
-err_free_ut_stack:
-	free(ut->stack);
-
 err_free_ut:
 	uthread_free_utid(ut->id);
 	free(ut);
@@ -357,7 +430,6 @@ status_t uthread_start(uthread_t *ut)
 static void uthread_destroy(uthread_t *ut)
 {
 	uthread_free_maps(ut);
-	free(ut->stack);
 	arch_uthread_free(ut);
 	uthread_free_utid(ut->id);
 	list_delete(&ut->uthread_list_node);
@@ -378,12 +450,19 @@ void uthread_kill(uthread_t *ut, int retcode)
 	thread_kill(thread, retcode);
 }
 
+void uthread_set_exit_notifier(void (*fn)(uthread_t *ut))
+{
+	uthread_exit_notifier = fn;
+}
+
 void __NO_RETURN uthread_exit(int retcode)
 {
 	uthread_t *ut;
 
 	ut = uthread_get_current();
 	if (ut) {
+		if (uthread_exit_notifier)
+			uthread_exit_notifier(ut);
 		uthread_destroy(ut);
 	} else {
 		TRACEF("WARNING: unexpected call on kernel thread %s!",
@@ -505,6 +584,84 @@ status_t uthread_unmap(uthread_t *ut, vaddr_t vaddr, size_t size)
 	return err;
 }
 
+/*
+ * Map size bytes that read as zero. Every page starts out as a copy-on-write
+ * view of zero_page and only gets memory of its own when it is written.
+ */
+status_t uthread_map_zero(uthread_t *ut, vaddr_t *vaddrp, size_t size,
+		u_int flags, u_int align)
+{
+	u_int npages = size / PAGE_SIZE;
+	paddr_t *pfn_list;
+	status_t err;
+
+	pfn_list = malloc(npages * sizeof(pfn_list[0]));
+	if (!pfn_list)
+		return ERR_NO_MEMORY;
+
+	for (u_int pg = 0; pg < npages; pg++)
+		pfn_list[pg] = vaddr_to_paddr(zero_page);
+
+	err = uthread_map(ut, vaddrp, pfn_list, size,
+			(flags & ~UTM_PHYS_CONTIG) | UTM_COW, align);
+	free(pfn_list);
+	return err;
+}
+
+/*
+ * Replace the shared page under vaddr of a UTM_COW map with a private copy
+ * and map it writable. Pages that are already private are left alone.
+ */
+static status_t uthread_cow_break_locked(uthread_t *ut, uthread_map_t *mp,
+		vaddr_t vaddr)
+{
+	u_int pg = (vaddr - mp->vaddr) / PAGE_SIZE;
+	u_int npages = mp->size / PAGE_SIZE;
+	void *page;
+	status_t err;
+
+	if (!uthread_cow_shared(mp, pg))
+		return NO_ERROR;
+
+	page = memalign(PAGE_SIZE, PAGE_SIZE);
+	if (!page)
+		return ERR_NO_MEMORY;
+
+	memcpy(page, paddr_to_kvaddr(mp->pfn_list[npages + pg]), PAGE_SIZE);
+
+	vaddr = mp->vaddr + (pg * PAGE_SIZE);
+	err = arch_uthread_remap_page(ut, vaddr, vaddr_to_paddr(page),
+			mp->flags & ~UTM_COW);
+	if (err) {
+		free(page);
+		return err;
+	}
+
+	mp->pfn_list[pg] = vaddr_to_paddr(page);
+	ut->cow_pages++;
+	return NO_ERROR;
+}
+
+status_t uthread_cow_fault(uthread_t *ut, vaddr_t vaddr)
+{
+	uthread_map_t *mp;
+	status_t err;
+
+	if (!ut)
+		return ERR_INVALID_ARGS;
+
+	/* pages already made private fault for other reasons */
+	mmap_lock(ut);
+	mp = uthread_map_find(ut, vaddr, 0);
+	if (mp && (mp->flags & UTM_COW) &&
+	    uthread_cow_shared(mp, (vaddr - mp->vaddr) / PAGE_SIZE))
+		err = uthread_cow_break_locked(ut, mp, vaddr);
+	else
+		err = ERR_NOT_FOUND;
+	mmap_unlock(ut);
+	return err;
+}
+
 bool uthread_is_valid_range(uthread_t *ut, vaddr_t vaddr, size_t size)
 {
 	bool ret;
@@ -565,7 +722,7 @@ static void translate_virt_to_phys_locked(uthread_map_t *mp,
 }
 
 status_t uthread_virt_to_phys_flags(uthread_t *ut, vaddr_t vaddr,
-		paddr_t *paddr, u_int *flags)
+		paddr_t *paddr, u_int *flags, bool write)
 {
 	uthread_map_t *mp;
 	status_t err;
@@ -580,6 +737,13 @@ status_t uthread_virt_to_phys_flags(uthread_t *ut, vaddr_t vaddr,
 		goto err_out;
 	}
 
+	/* kernel writes through the translation bypass the tlb */
+	if (write && (mp->flags & UTM_COW)) {
+		err = uthread_cow_break_locked(ut, mp, vaddr);
+		if (err)
+			goto err_out;
+	}
+
 	translate_virt_to_phys_locked(mp, vaddr, paddr);
 
 	if (flags)
@@ -593,15 +757,17 @@ err_out:
 
 status_t uthread_virt_to_phys(uthread_t *ut, vaddr_t vaddr, paddr_t *paddr)
 {
-	return uthread_virt_to_phys_flags(ut, vaddr, paddr, NULL);
+	/* devices may write the page */
+	return uthread_virt_to_phys_flags(ut, vaddr, paddr, NULL, true);
 }
 
-status_t uthread_virt_to_kvaddr(uthread_t *ut, vaddr_t vaddr, void **kvaddr)
+status_t uthread_virt_to_kvaddr(uthread_t *ut, vaddr_t vaddr, void **kvaddr,
+		bool write)
 {
 	status_t err;
 	paddr_t paddr;
 
-	err = uthread_virt_to_phys_flags(ut, vaddr, &paddr, NULL);
+	err = uthread_virt_to_phys_flags(ut, vaddr, &paddr, NULL, write);
 	if (err)
 		return err;
 
@@ -619,6 +785,20 @@ static status_t translate_ns_src(vaddr_t vaddr, size_t size, paddr_t *paddr)
 #endif
 }
 
+/*
+ * Align the user mapping of a physically contiguous buffer like its physical
+ * address, up to half its size, so the arch can map it with large pages.
+ */
+static u_int uthread_contig_align(paddr_t paddr, size_t size)
+{
+	u_int align = UT_MAP_ALIGN_DEFAULT;
+
+	while (!(paddr & ((2 * align) - 1)) && (4 * align) <= size)
+		align <<= 1;
+
+	return align;
+}
+
 status_t uthread_grant_pages(uthread_t *ut_target, uthread_t *ut_src,
 		ext_vaddr_t vaddr_src, size_t size, u_int flags,
 		vaddr_t *vaddr_target, bool ns_src)
@@ -650,7 +830,10 @@ status_t uthread_grant_pages(uthread_t *ut_target, uthread_t *ut_src,
 	if (npages == 1)
 		flags |= UTM_PHYS_CONTIG;
 
-	pfn_list = malloc(npages * sizeof(paddr_t));
+	if (npages <= PFN_CACHE_PAGES)
+		pfn_list = slab_alloc(&pfn_list_cache);
+	else
+		pfn_list = malloc(npages * sizeof(paddr_t));
 	if (!pfn_list) {
 		err = ERR_NO_MEMORY;
 		goto err_out;
@@ -667,7 +850,6 @@ status_t uthread_grant_pages(uthread_t *ut_target, uthread_t *ut_src,
 		}
 		vaddr = (vaddr_t)vaddr_src;
 
-		align = UT_MAP_ALIGN_DEFAULT;
 		flags |= UTM_NS_MEM;
 
 		/* only contiguous ns_src mappings are implemented */
@@ -677,6 +859,8 @@ status_t uthread_grant_pages(uthread_t *ut_target, uthread_t *ut_src,
 		if (err)
 			goto err_out;
 
+		align = uthread_contig_align(paddr, size);
+
 		for (pg = 0; pg < npages; pg++)
 			pfn_list[pg] = paddr + (PAGE_SIZE * pg);
 
@@ -704,6 +888,15 @@ status_t uthread_grant_pages(uthread_t *ut_target, uthread_t *ut_src,
 		for (pg = 0; pg < npages; pg++, vaddr += PAGE_SIZE) {
 
 			paddr_t paddr;
+
+			/* both sides must see the same page from now on */
+			if (mp_src->flags & UTM_COW) {
+				err = uthread_cow_break_locked(ut_src, mp_src,
+						vaddr);
+				if (err)
+					goto err_out;
+			}
+
 			translate_virt_to_phys_locked(mp_src, vaddr, &paddr);
 			pfn_list[pg] = paddr;
 
@@ -719,13 +912,102 @@ status_t uthread_grant_pages(uthread_t *ut_target, uthread_t *ut_src,
 	*vaddr_target += offset;
 
 err_out:
-	if (pfn_list)
+	if (npages <= PFN_CACHE_PAGES)
+		slab_free(&pfn_list_cache, pfn_list);
+	else
 		free(pfn_list);
 
 	mmap_unlock_pair(ut_src, ut_target);
 	return err;
 }
 
+/*
+ * Grant an NS buffer described by a page list. Each page of the list holds
+ * NS_PAGELIST_ENTRIES page addresses followed by the address of the next
+ * page of the list; all addresses are in the ns_src address space. The low
+ * bits of pagelist give the offset of the buffer in its first page.
+ */
+status_t uthread_grant_ns_pagelist(uthread_t *ut_target, ext_vaddr_t pagelist,
+		size_t size, u_int flags, vaddr_t *vaddr_target)
+{
+	const uint64_t *entries = NULL;
+	paddr_t *pfn_list = NULL;
+	paddr_t paddr;
+	uint64_t entry;
+	u_int offset, npages, pg, n;
+	status_t err;
+
+	if (size == 0)
+		size = 1;
+
+	offset = pagelist & (PAGE_SIZE - 1);
+	pagelist = ROUNDDOWN(pagelist, PAGE_SIZE);
+
+	if (size > MAX_USR_VA)
+		return ERR_INVALID_ARGS;
+	size = ROUNDUP((size + offset), PAGE_SIZE);
+	npages = size / PAGE_SIZE;
+
+	if (npages <= PFN_CACHE_PAGES)
+		pfn_list = slab_alloc(&pfn_list_cache);
+	else
+		pfn_list = malloc(npages * sizeof(paddr_t));
+	if (!pfn_list)
+		return ERR_NO_MEMORY;
+
+	for (pg = 0, n = NS_PAGELIST_ENTRIES; pg < npages; pg++, n++) {
+		if (n == NS_PAGELIST_ENTRIES) {
+			/* first page of the list, or follow the link */
+			if (entries)
+				pagelist = entries[NS_PAGELIST_ENTRIES];
+			if ((pagelist & (PAGE_SIZE - 1)) ||
+			    pagelist != (vaddr_t)pagelist) {
+				err = ERR_INVALID_ARGS;
+				goto err_out;
+			}
+			err = translate_ns_src((vaddr_t)pagelist, PAGE_SIZE,
+					&paddr);
+			if (err)
+				goto err_out;
+			entries = paddr_to_kvaddr(paddr);
+			n = 0;
+		}
+
+		/* the REE can rewrite the list, only read an entry once */
+		entry = entries[n];
+		if ((entry & (PAGE_SIZE - 1)) || entry != (vaddr_t)entry) {
+			err = ERR_INVALID_ARGS;
+			goto err_out;
+		}
+		err = translate_ns_src((vaddr_t)entry, PAGE_SIZE, &pfn_list[pg]);
+		if (err)
+			goto err_out;
+	}
+
+	flags |= UTM_NS_MEM;
+	if (npages == 1)
+		flags |= UTM_PHYS_CONTIG;
+	else
+		flags &= ~UTM_PHYS_CONTIG;
+
+	mmap_lock(ut_target);
+	err = uthread_map_locked(ut_target, vaddr_target, pfn_list, size,
+			flags, UT_MAP_ALIGN_DEFAULT);
+	mmap_unlock(ut_target);
+	if (err)
+		goto err_out;
+
+	*vaddr_target += offset;
+
+err_out:
+	if (npages <= PFN_CACHE_PAGES)
+		slab_free(&pfn_list_cache, pfn_list);
+	else
+		free(pfn_list);
+
+	return err;
+}
+
 status_t uthread_revoke_pages(uthread_t *ut, vaddr_t vaddr, size_t size)
 {
 	u_int offset = vaddr & (PAGE_SIZE - 1);
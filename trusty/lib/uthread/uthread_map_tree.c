@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2016-2018, MIPS Tech, LLC and/or its affiliated group companies
+ * (“MIPS”).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include "uthread_map_tree.h"
+
+static inline u_int node_height(uthread_map_t *n)
+{
+	return n ? n->height : 0;
+}
+
+static void node_update(uthread_map_t *n)
+{
+	n->height = 1 + MAX(node_height(n->left), node_height(n->right));
+	n->max_gap = n->gap;
+	n->has_sec = !(n->flags & UTM_NS_MEM);
+
+	if (n->left) {
+		n->max_gap = MAX(n->max_gap, n->left->max_gap);
+		n->has_sec |= n->left->has_sec;
+	}
+	if (n->right) {
+		n->max_gap = MAX(n->max_gap, n->right->max_gap);
+		n->has_sec |= n->right->has_sec;
+	}
+}
+
+static uthread_map_t *node_rotate_right(uthread_map_t *n)
+{
+	uthread_map_t *l = n->left;
+
+	n->left = l->right;
+	l->right = n;
+	node_update(n);
+	node_update(l);
+	return l;
+}
+
+static uthread_map_t *node_rotate_left(uthread_map_t *n)
+{
+	uthread_map_t *r = n->right;
+
+	n->right = r->left;
+	r->left = n;
+	node_update(n);
+	node_update(r);
+	return r;
+}
+
+static uthread_map_t *node_balance(uthread_map_t *n)
+{
+	int bf;
+
+	node_update(n);
+	bf = (int)node_height(n->left) - (int)node_height(n->right);
+
+	if (bf > 1) {
+		if (node_height(n->left->left) < node_height(n->left->right))
+			n->left = node_rotate_left(n->left);
+		return node_rotate_right(n);
+	}
+	if (bf < -1) {
+		if (node_height(n->right->right) < node_height(n->right->left))
+			n->right = node_rotate_right(n->right);
+		return node_rotate_left(n);
+	}
+	return n;
+}
+
+static uthread_map_t *node_insert(uthread_map_t *n, uthread_map_t *mp)
+{
+	if (!n)
+		return mp;
+
+	DEBUG_ASSERT(mp->vaddr != n->vaddr);
+	if (mp->vaddr < n->vaddr)
+		n->left = node_insert(n->left, mp);
+	else
+		n->right = node_insert(n->right, mp);
+	return node_balance(n);
+}
+
+static uthread_map_t *node_remove_min(uthread_map_t *n, uthread_map_t **min)
+{
+	if (!n->left) {
+		*min = n;
+		return n->right;
+	}
+	n->left = node_remove_min(n->left, min);
+	return node_balance(n);
+}
+
+static uthread_map_t *node_remove(uthread_map_t *n, uthread_map_t *mp)
+{
+	uthread_map_t *min;
+
+	DEBUG_ASSERT(n);
+	if (mp->vaddr < n->vaddr) {
+		n->left = node_remove(n->left, mp);
+	} else if (mp->vaddr > n->vaddr) {
+		n->right = node_remove(n->right, mp);
+	} else {
+		DEBUG_ASSERT(n == mp);
+		if (!n->right)
+			return n->left;
+		n->right = node_remove_min(n->right, &min);
+		min->left = n->left;
+		min->right = n->right;
+		n = min;
+	}
+	return node_balance(n);
+}
+
+/* recompute the augmented fields on the path down to mp */
+static void node_refresh(uthread_map_t *n, uthread_map_t *mp)
+{
+	DEBUG_ASSERT(n);
+	if (mp->vaddr < n->vaddr)
+		node_refresh(n->left, mp);
+	else if (mp->vaddr > n->vaddr)
+		node_refresh(n->right, mp);
+	node_update(n);
+}
+
+void uthread_map_tree_insert(uthread_map_t **root, uthread_map_t *mp)
+{
+	mp->left = NULL;
+	mp->right = NULL;
+	node_update(mp);
+	*root = node_insert(*root, mp);
+}
+
+void uthread_map_tree_remove(uthread_map_t **root, uthread_map_t *mp)
+{
+	*root = node_remove(*root, mp);
+	mp->left = NULL;
+	mp->right = NULL;
+}
+
+void uthread_map_tree_set_gap(uthread_map_t **root, uthread_map_t *mp,
+		vaddr_t gap)
+{
+	mp->gap = gap;
+	node_refresh(*root, mp);
+}
+
+uthread_map_t *uthread_map_tree_floor(uthread_map_t *n, vaddr_t vaddr)
+{
+	uthread_map_t *floor = NULL;
+
+	while (n) {
+		if (n->vaddr <= vaddr) {
+			floor = n;
+			n = n->right;
+		} else {
+			n = n->left;
+		}
+	}
+	return floor;
+}
+
+uthread_map_t *uthread_map_tree_gap_up(uthread_map_t *n, size_t size,
+		vaddr_t lo, u_int align, vaddr_t *start)
+{
+	uthread_map_t *mp;
+	vaddr_t base, s;
+
+	if (!n || n->max_gap < size)
+		return NULL;
+
+	/* gaps in the left subtree all end below n->vaddr */
+	if (n->vaddr > lo) {
+		mp = uthread_map_tree_gap_up(n->left, size, lo, align, start);
+		if (mp)
+			return mp;
+
+		base = MAX(n->vaddr - n->gap, lo);
+		s = ROUNDUP(base, align);
+		if (s >= base && s < n->vaddr && n->vaddr - s >= size) {
+			*start = s;
+			return n;
+		}
+	}
+
+	return uthread_map_tree_gap_up(n->right, size, lo, align, start);
+}
+
+uthread_map_t *uthread_map_tree_gap_down(uthread_map_t *n, size_t size,
+		u_int align, vaddr_t *start, bool *blocked)
+{
+	uthread_map_t *mp;
+	vaddr_t s;
+
+	if (!n)
+		return NULL;
+
+	if (n->max_gap < size) {
+		/* nothing fits, but a secure map in here ends the search */
+		if (n->has_sec)
+			*blocked = true;
+		return NULL;
+	}
+
+	mp = uthread_map_tree_gap_down(n->right, size, align, start, blocked);
+	if (mp || *blocked)
+		return mp;
+
+	if (!(n->flags & UTM_NS_MEM)) {
+		*blocked = true;
+		return NULL;
+	}
+
+	if (n->vaddr >= size) {
+		s = ROUNDDOWN(n->vaddr - size, align);
+		if (s >= n->vaddr - n->gap) {
+			*start = s;
+			return n;
+		}
+	}
+
+	return uthread_map_tree_gap_down(n->left, size, align, start, blocked);
+}
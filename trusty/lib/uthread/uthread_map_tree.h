@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2016-2018, MIPS Tech, LLC and/or its affiliated group companies
+ * (“MIPS”).
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <sys/types.h>
+#include <uthread.h>
+
+/*
+ * AVL tree of a uthread's maps keyed by vaddr. Every node also records the
+ * unmapped gap below it so the VA allocators can skip whole subtrees that
+ * have no room. The tree mirrors ut->map_list, which still provides the
+ * in-order prev/next links; both are protected by mmap_lock.
+ */
+void uthread_map_tree_insert(uthread_map_t **root, uthread_map_t *mp);
+void uthread_map_tree_remove(uthread_map_t **root, uthread_map_t *mp);
+
+/* update the gap below mp after its predecessor changed */
+void uthread_map_tree_set_gap(uthread_map_t **root, uthread_map_t *mp,
+		vaddr_t gap);
+
+/* map with the highest vaddr <= vaddr, or NULL */
+uthread_map_t *uthread_map_tree_floor(uthread_map_t *root, vaddr_t vaddr);
+
+/*
+ * Lowest map whose gap holds size bytes aligned to align at or above lo.
+ * The aligned start of the space is returned in *start.
+ */
+uthread_map_t *uthread_map_tree_gap_up(uthread_map_t *root, size_t size,
+		vaddr_t lo, u_int align, vaddr_t *start);
+
+/*
+ * Highest map whose gap holds size bytes aligned to align, walking down
+ * from the top. Only gaps above the highest non-NS map are considered;
+ * *blocked is set if the search ran into one.
+ */
+uthread_map_t *uthread_map_tree_gap_down(uthread_map_t *root, size_t size,
+		u_int align, vaddr_t *start, bool *blocked);